@@ -0,0 +1,161 @@
+// Benchmark suite: AlertEngine evaluation with thousands of rules against
+// a snapshot of a large host, and rule compilation.
+//
+// Build and run with: make bench
+// Run a subset with: bin/alert_bench Evaluate
+#include "bench.h"
+#include "alert_engine.h"
+#include "fixtures.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::size_t kCores = 512;
+const std::size_t kMounts = 500;
+const std::size_t kInterfaces = 64;
+const std::size_t kCgroups = 20;
+
+// The cgroup rules read the monitor's cgroup table, so the monitor runs on
+// a fixture tree. It has only a couple of samples, so the rules below
+// compare current values.
+Settings settings;
+ResourceMonitor* monitor = nullptr;
+
+void fillSnapshot(ResourceSnapshot& snapshot) {
+    snapshot.timestamp = 1700000000000;
+    snapshot.cpuUsage = 50.0;
+    snapshot.memInfo.percent = 60.0;
+    snapshot.coreUsage.assign(kCores, 0.0);
+    for (std::size_t i = 0; i < kCores; i++) {
+        snapshot.coreUsage[i] = static_cast<double>(i % 100);
+    }
+    snapshot.diskInfo.resize(kMounts);
+    for (std::size_t i = 0; i < kMounts; i++) {
+        snapshot.diskInfo[i].mountpoint = "/mnt/volume" + std::to_string(i);
+        snapshot.diskInfo[i].percent = static_cast<double>(i % 100);
+        snapshot.diskInfo[i].readBytesPerSec = i * 1024.0 * 1024.0;
+        snapshot.diskInfo[i].writeBytesPerSec = i * 512.0 * 1024.0;
+        snapshot.diskInfo[i].ioUtilization = static_cast<double>(i % 100);
+    }
+    snapshot.networkInfo.resize(kInterfaces);
+    for (std::size_t i = 0; i < kInterfaces; i++) {
+        std::snprintf(snapshot.networkInfo[i].name, sizeof(snapshot.networkInfo[i].name), "eth%zu", i);
+        snapshot.networkInfo[i].rxBytesPerSec = i * 1e6;
+        snapshot.networkInfo[i].txBytesPerSec = i * 2e5;
+    }
+}
+
+// `count` rules spread over every metric, about a tenth of them with "*"
+std::vector<std::string> makeRules(std::size_t count) {
+    std::vector<std::string> rules;
+    for (std::size_t i = 0; i < count; i++) {
+        std::string threshold = std::to_string(i % 100);
+        switch (i % 10) {
+            case 0:
+                rules.push_back("cpu >= " + threshold + " for 30s clear " + std::to_string(i % 100 / 2));
+                break;
+            case 1:
+                rules.push_back("core:" + std::to_string(i % kCores) + " > " + threshold);
+                break;
+            case 2:
+                rules.push_back("memory < " + threshold + " clear " + std::to_string(i % 100 + 5));
+                break;
+            case 3:
+                rules.push_back("disk:/mnt/volume" + std::to_string(i % kMounts) + " >= " + threshold);
+                break;
+            case 4:
+                rules.push_back("disk_read:/mnt/volume" + std::to_string(i % kMounts) + " > " + threshold + "M");
+                break;
+            case 5:
+                rules.push_back("net_rx:eth" + std::to_string(i % kInterfaces) + " > " + threshold + "M for 1m");
+                break;
+            case 6:
+                rules.push_back("net_tx:eth" + std::to_string(i % kInterfaces) + " > " + threshold + "K");
+                break;
+            case 7:
+                rules.push_back("cgroup_memory:kubepods.slice/pod-0.slice/container-" +
+                                std::to_string(i % kCgroups) + ".scope > " + threshold + "M");
+                break;
+            case 8:
+                rules.push_back("disk_util:/mnt/volume" + std::to_string(i % kMounts) + " >= " + threshold);
+                break;
+            case 9:
+                rules.push_back(i % 20 == 9 ? "disk:* >= " + threshold : "core:* > " + threshold + " for 5s");
+                break;
+        }
+    }
+    return rules;
+}
+
+void evaluateRules(BenchState& state, std::size_t count) {
+    ResourceSnapshot snapshot;
+    fillSnapshot(snapshot);
+    AlertEngine engine;
+    std::string error;
+    if (!engine.compile(makeRules(count), error)) {
+        std::printf("alert_bench: %s\n", error.c_str());
+        return;
+    }
+    std::vector<AlertEvent> events;
+
+    // Every other tick moves the values across the thresholds, so rows keep
+    // firing and resolving
+    std::size_t tick = 0;
+    while (state.keepRunning()) {
+        snapshot.timestamp += 1000;
+        snapshot.cpuUsage = (tick & 1) ? 10.0 : 90.0;
+        snapshot.memInfo.percent = (tick & 1) ? 90.0 : 10.0;
+        engine.evaluate(snapshot, *monitor, events);
+        doNotOptimize(events.size());
+        tick++;
+    }
+    state.setItemsProcessed(state.iterations() * engine.getRowCount());
+}
+
+void BM_Evaluate1kRules(BenchState& state) {
+    evaluateRules(state, 1000);
+}
+BENCHMARK(BM_Evaluate1kRules);
+
+void BM_Evaluate10kRules(BenchState& state) {
+    // Includes 500 "disk:*" and 500 "core:*" rules, expanded to 500k rows
+    evaluateRules(state, 10000);
+}
+BENCHMARK(BM_Evaluate10kRules);
+
+void BM_Compile10kRules(BenchState& state) {
+    std::vector<std::string> rules = makeRules(10000);
+    AlertEngine engine;
+    std::string error;
+    while (state.keepRunning()) {
+        doNotOptimize(engine.compile(rules, error));
+    }
+    state.setItemsProcessed(state.iterations() * rules.size());
+}
+BENCHMARK(BM_Compile10kRules);
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    FixtureTree tree;
+    tree.writeStat(4);
+    tree.writeMeminfo();
+    tree.writeMounts(0);
+    tree.writeNetDev(0);
+    tree.writeDiskstats(0);
+    tree.writeCgroups(kCgroups);
+
+    // Two samples, so every cgroup has one with rates
+    ResourceMonitor fixtureMonitor(&settings, tree.root());
+    if (!fixtureMonitor.initialize()) {
+        std::printf("alert_bench: cannot initialize the monitor on %s\n", tree.root().c_str());
+        return 1;
+    }
+    fixtureMonitor.sample();
+    fixtureMonitor.sample();
+    monitor = &fixtureMonitor;
+
+    return runBenchmarks(argc, argv);
+}
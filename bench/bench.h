@@ -0,0 +1,151 @@
+// Minimal benchmark harness in the style of Google Benchmark, so the suite
+// builds with nothing but the compiler:
+//
+//   static void BM_Parse(BenchState& state) {
+//       while (state.keepRunning()) { ... }
+//       state.setItemsProcessed(state.iterations() * items);
+//   }
+//   BENCHMARK(BM_Parse);
+//
+// Each benchmark runs with a growing iteration count until one run takes at
+// least 0.5 s, and reports the time per iteration of that run. Arguments on
+// the command line select benchmarks whose name contains one of them.
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+class BenchState {
+public:
+    explicit BenchState(std::size_t iterations)
+        : m_iterations(iterations),
+          m_remaining(iterations),
+          m_started(false),
+          m_items(0)
+    {
+    }
+
+    // True while iterations are left; the clock runs from the first call
+    // to the one that returns false
+    bool keepRunning() {
+        if (!m_started) {
+            m_started = true;
+            m_start = std::chrono::steady_clock::now();
+        }
+        if (m_remaining == 0) {
+            m_end = std::chrono::steady_clock::now();
+            return false;
+        }
+        m_remaining--;
+        return true;
+    }
+
+    std::size_t iterations() const { return m_iterations; }
+
+    // Items handled by the whole run, for the items/s column
+    void setItemsProcessed(std::size_t items) { m_items = items; }
+    std::size_t itemsProcessed() const { return m_items; }
+
+    double seconds() const {
+        return std::chrono::duration<double>(m_end - m_start).count();
+    }
+
+private:
+    std::size_t m_iterations;
+    std::size_t m_remaining;
+    bool m_started;
+    std::size_t m_items;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_end;
+};
+
+using BenchFunction = void (*)(BenchState&);
+
+struct BenchEntry {
+    const char* name;
+    BenchFunction function;
+};
+
+inline std::vector<BenchEntry>& benchRegistry() {
+    static std::vector<BenchEntry> registry;
+    return registry;
+}
+
+inline int registerBenchmark(const char* name, BenchFunction function) {
+    benchRegistry().push_back({name, function});
+    return 0;
+}
+
+#define BENCHMARK(function) \
+    static int function##_registration = registerBenchmark(#function, function)
+
+// Keep the compiler from dropping a computation whose result is unused
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline bool benchSelected(const char* name, int argc, char** argv) {
+    if (argc < 2) {
+        return true;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (std::strstr(name, argv[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline int runBenchmarks(int argc, char** argv) {
+    std::printf("%-40s %14s %12s %14s\n", "Benchmark", "Time", "Iterations", "Items/s");
+    for (const BenchEntry& entry : benchRegistry()) {
+        if (!benchSelected(entry.name, argc, argv)) {
+            continue;
+        }
+
+        std::size_t iterations = 1;
+        for (;;) {
+            BenchState state(iterations);
+            entry.function(state);
+            double seconds = state.seconds();
+            if (seconds >= 0.5 || iterations >= (std::size_t(1) << 30)) {
+                double ns = seconds * 1e9 / iterations;
+                const char* unit = "ns";
+                double shown = ns;
+                if (ns >= 1e6) {
+                    shown = ns / 1e6;
+                    unit = "ms";
+                } else if (ns >= 1e3) {
+                    shown = ns / 1e3;
+                    unit = "us";
+                }
+                char time[32];
+                std::snprintf(time, sizeof(time), "%.1f %s", shown, unit);
+                if (state.itemsProcessed() > 0) {
+                    std::printf("%-40s %14s %12zu %14.3g\n", entry.name, time, iterations,
+                                state.itemsProcessed() / seconds);
+                } else {
+                    std::printf("%-40s %14s %12zu %14s\n", entry.name, time, iterations, "");
+                }
+                break;
+            }
+
+            // Aim for about 0.6 s next, growing at most 10x per step
+            double factor = seconds > 0.0 ? 0.6 / seconds : 10.0;
+            if (factor > 10.0) {
+                factor = 10.0;
+            } else if (factor < 1.5) {
+                factor = 1.5;
+            }
+            iterations = static_cast<std::size_t>(iterations * factor) + 1;
+        }
+    }
+    return 0;
+}
+
+#endif // BENCH_H
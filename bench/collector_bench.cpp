@@ -0,0 +1,242 @@
+// Benchmark suite: /proc readers, process, mount, cgroup and device
+// collectors against a synthetic host with 512 CPUs, 20k processes, 5k
+// mounts and 2k cgroups, plus HistoryData append, read and stats.
+//
+// Build and run with: make bench
+// Run a subset with: bin/collector_bench Process History
+#include "bench.h"
+#include "fixtures.h"
+#include "process_collector.h"
+#include "mount_table.h"
+#include "network_collector.h"
+#include "disk_io_collector.h"
+#include "cgroup_collector.h"
+#include "history_data.h"
+#include "resource_monitor.h"
+#include <cstdio>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/sysmacros.h>
+
+namespace {
+
+const std::size_t kCPUs = 512;
+const std::size_t kProcesses = 20000;
+const std::size_t kMounts = 5000;
+const std::size_t kCgroups = 2000;
+const std::size_t kInterfaces = 64;
+const std::size_t kDevices = 64;
+
+FixtureTree* fixture = nullptr;
+ResourceMonitor* cpuMonitor = nullptr;
+
+// ResourceMonitor::sample() on a tree with only /proc/stat, /proc/meminfo
+// and an empty mount table, so the shipped /proc/stat and /proc/meminfo
+// readers and the per-core usage make up nearly all of it
+void BM_MonitorSample512CPUs(BenchState& state) {
+    while (state.keepRunning()) {
+        cpuMonitor->sample();
+        doNotOptimize(cpuMonitor->getMemoryInfo().available);
+    }
+    state.setItemsProcessed(state.iterations() * kCPUs);
+}
+BENCHMARK(BM_MonitorSample512CPUs);
+
+void BM_ProcessSweep20k(BenchState& state) {
+    ProcessCollector collector(fixture->path("proc"));
+    collector.open();
+    collector.update();     // Opens and caches the stat fds
+    while (state.keepRunning()) {
+        collector.update();
+    }
+    state.setItemsProcessed(state.iterations() * collector.getProcessCount());
+}
+BENCHMARK(BM_ProcessSweep20k);
+
+void BM_ProcessTop15(BenchState& state) {
+    ProcessCollector collector(fixture->path("proc"));
+    collector.open();
+    collector.update();
+    std::vector<ProcessInfo> top;
+    while (state.keepRunning()) {
+        collector.topByCPU(15, top);
+        doNotOptimize(top.data());
+    }
+    state.setItemsProcessed(state.iterations() * collector.getProcessCount());
+}
+BENCHMARK(BM_ProcessTop15);
+
+void BM_MountRefresh5k(BenchState& state) {
+    MountTable table;
+    std::string mtab = fixture->path("etc/mtab");
+    while (state.keepRunning()) {
+        table.refresh(mtab.c_str());
+        doNotOptimize(table.entries().size());
+    }
+    state.setItemsProcessed(state.iterations() * kMounts);
+}
+BENCHMARK(BM_MountRefresh5k);
+
+void BM_MountFilter5k(BenchState& state) {
+    // The filter alone, on mounts parsed up front
+    std::vector<MountEntry> mounts;
+    FILE* file = std::fopen(fixture->path("etc/mtab").c_str(), "r");
+    char device[128];
+    char mountpoint[128];
+    char fstype[32];
+    while (file && std::fscanf(file, "%127s %127s %31s %*[^\n]", device, mountpoint, fstype) == 3) {
+        mounts.push_back({device, mountpoint, fstype});
+    }
+    if (file) {
+        std::fclose(file);
+    }
+
+    while (state.keepRunning()) {
+        std::size_t monitored = 0;
+        for (const MountEntry& mount : mounts) {
+            monitored += MountTable::isMonitored(mount.fstype, mount.device, mount.mountpoint);
+        }
+        doNotOptimize(monitored);
+    }
+    state.setItemsProcessed(state.iterations() * mounts.size());
+}
+BENCHMARK(BM_MountFilter5k);
+
+void BM_NetDev64(BenchState& state) {
+    NetworkCollector collector;
+    collector.open(fixture->path("proc/net/dev").c_str());
+    while (state.keepRunning()) {
+        collector.update();
+    }
+    state.setItemsProcessed(state.iterations() * kInterfaces);
+}
+BENCHMARK(BM_NetDev64);
+
+void BM_Diskstats64(BenchState& state) {
+    DiskIOCollector collector;
+    collector.open(fixture->path("proc/diskstats").c_str());
+    std::vector<dev_t> devices;
+    for (std::size_t i = 0; i < kDevices; i++) {
+        devices.push_back(makedev(259, i));
+    }
+    collector.setDevices(devices);
+    while (state.keepRunning()) {
+        collector.update();
+    }
+    state.setItemsProcessed(state.iterations() * kDevices);
+}
+BENCHMARK(BM_Diskstats64);
+
+void BM_CgroupFullPass2k(BenchState& state) {
+    // One full walk and read per iteration, without the per-update budget
+    CgroupCollector collector(fixture->path("sys/fs/cgroup"));
+    collector.open();
+    collector.update(std::chrono::seconds(60));
+    while (state.keepRunning()) {
+        collector.update(std::chrono::seconds(60));
+    }
+    state.setItemsProcessed(state.iterations() * collector.getCgroupCount());
+}
+BENCHMARK(BM_CgroupFullPass2k);
+
+void BM_CgroupBudgetedUpdate2k(BenchState& state) {
+    // What the sampler spends per tick
+    CgroupCollector collector(fixture->path("sys/fs/cgroup"));
+    collector.open();
+    while (state.keepRunning()) {
+        collector.update();
+    }
+}
+BENCHMARK(BM_CgroupBudgetedUpdate2k);
+
+void historyAppend(BenchState& state, std::size_t capacity) {
+    HistoryData history(capacity);
+    for (std::size_t i = 0; i < capacity; i++) {
+        history.addSample(static_cast<double>(i % 100));
+    }
+    double value = 0.0;
+    while (state.keepRunning()) {
+        history.addSample(value);
+        value = value < 100.0 ? value + 0.5 : 0.0;
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_HistoryAppend600(BenchState& state) {
+    historyAppend(state, 600);
+}
+BENCHMARK(BM_HistoryAppend600);
+
+void BM_HistoryAppend86400(BenchState& state) {
+    historyAppend(state, 86400);
+}
+BENCHMARK(BM_HistoryAppend86400);
+
+void BM_HistoryReadView86400(BenchState& state) {
+    // Snapshot, sum every sample, validate: what a full redraw reads
+    HistoryData history(86400);
+    for (std::size_t i = 0; i < 86400; i++) {
+        history.addSample(static_cast<double>(i % 100));
+    }
+    while (state.keepRunning()) {
+        SampleView view = history.snapshot();
+        double sum = 0.0;
+        for (double value : view) {
+            sum += value;
+        }
+        doNotOptimize(sum);
+        doNotOptimize(history.validate(view));
+    }
+    state.setItemsProcessed(state.iterations() * 86400);
+}
+BENCHMARK(BM_HistoryReadView86400);
+
+void BM_HistoryStats86400(BenchState& state) {
+    HistoryData history(86400);
+    for (std::size_t i = 0; i < 86400; i++) {
+        history.addSample(static_cast<double>(i % 100));
+    }
+    while (state.keepRunning()) {
+        HistoryStats stats = history.getStats();
+        doNotOptimize(stats.stddev);
+    }
+}
+BENCHMARK(BM_HistoryStats86400);
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // One cached fd per process and cgroup, as the agent allows itself
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    FixtureTree tree;
+    std::printf("Generating fixtures in %s ...\n", tree.root().c_str());
+    tree.writeStat(kCPUs);
+    tree.writeMeminfo();
+    tree.writeProcesses(kProcesses);
+    tree.writeMounts(kMounts);
+    tree.writeNetDev(kInterfaces);
+    tree.writeDiskstats(kDevices);
+    tree.writeCgroups(kCgroups);
+    fixture = &tree;
+
+    FixtureTree cpuTree;
+    cpuTree.writeStat(kCPUs);
+    cpuTree.writeMeminfo();
+    cpuTree.writeMounts(0);
+    cpuTree.writeNetDev(0);
+    cpuTree.writeDiskstats(0);
+    Settings settings;
+    ResourceMonitor monitor(&settings, cpuTree.root());
+    if (!monitor.initialize()) {
+        std::printf("collector_bench: cannot initialize the monitor on %s\n", cpuTree.root().c_str());
+        return 1;
+    }
+    cpuMonitor = &monitor;
+
+    return runBenchmarks(argc, argv);
+}
@@ -0,0 +1,173 @@
+#include "fixtures.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+
+FixtureTree::FixtureTree() {
+    char pattern[] = "/tmp/sysmon-bench-XXXXXX";
+    if (!mkdtemp(pattern)) {
+        throw std::runtime_error("mkdtemp failed");
+    }
+    m_root = pattern;
+    std::filesystem::create_directories(m_root + "/proc/net");
+    std::filesystem::create_directories(m_root + "/etc");
+    std::filesystem::create_directories(m_root + "/sys/fs/cgroup");
+}
+
+FixtureTree::~FixtureTree() {
+    std::error_code error;
+    std::filesystem::remove_all(m_root, error);
+}
+
+const std::string& FixtureTree::root() const {
+    return m_root;
+}
+
+std::string FixtureTree::path(const char* relative) const {
+    return m_root + "/" + relative;
+}
+
+void FixtureTree::writeFile(const std::string& path, const std::string& content) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        throw std::runtime_error("cannot write " + path);
+    }
+    std::fwrite(content.data(), 1, content.size(), file);
+    std::fclose(file);
+}
+
+void FixtureTree::writeStat(std::size_t cpus) {
+    std::string content;
+    char line[256];
+    std::snprintf(line, sizeof(line), "cpu  %zu 1200 %zu %zu 8000 0 3000 0 0 0\n",
+                  cpus * 250000, cpus * 90000, cpus * 4000000);
+    content += line;
+    for (std::size_t i = 0; i < cpus; i++) {
+        std::snprintf(line, sizeof(line), "cpu%zu %zu 2 %zu %zu 15 0 %zu 0 0 0\n",
+                      i, 250000 + i * 17, 90000 + i * 7, 4000000 + i * 101, 3000 + i);
+        content += line;
+    }
+    content += "intr 123456789 0 9 0 0 0 0 0 0 0 0 0 0 156 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+               "ctxt 987654321\nbtime 1700000000\nprocesses 4242424\n"
+               "procs_running 3\nprocs_blocked 0\nsoftirq 55555 0 1111 2 3333 44 0 5 6666 0 7777\n";
+    writeFile(path("proc/stat"), content);
+}
+
+void FixtureTree::writeMeminfo() {
+    writeFile(path("proc/meminfo"),
+              "MemTotal:       528280576 kB\nMemFree:        12345678 kB\nMemAvailable:   401234567 kB\n"
+              "Buffers:          456789 kB\nCached:         98765432 kB\nSwapCached:            0 kB\n"
+              "Active:         87654321 kB\nInactive:       45678901 kB\nActive(anon):   34567890 kB\n"
+              "Inactive(anon):   123456 kB\nActive(file):   53086431 kB\nInactive(file): 45555445 kB\n"
+              "Unevictable:       65432 kB\nMlocked:           65432 kB\nSwapTotal:              0 kB\n"
+              "SwapFree:               0 kB\nDirty:              1234 kB\nWriteback:             0 kB\n"
+              "AnonPages:      34567890 kB\nMapped:          2345678 kB\nShmem:            345678 kB\n"
+              "KReclaimable:    4567890 kB\nSlab:            6789012 kB\nSReclaimable:    4567890 kB\n"
+              "SUnreclaim:      2221122 kB\nKernelStack:       98765 kB\nPageTables:       456789 kB\n"
+              "CommitLimit:    264140288 kB\nCommitted_AS:   87654321 kB\nVmallocTotal:   34359738367 kB\n"
+              "VmallocUsed:      876543 kB\nHugePages_Total:       0\nHugePages_Free:        0\n"
+              "Hugepagesize:       2048 kB\nDirectMap4k:     1234567 kB\nDirectMap2M:    98765432 kB\n");
+}
+
+void FixtureTree::writeProcesses(std::size_t count) {
+    char directory[64];
+    char line[512];
+    for (std::size_t i = 0; i < count; i++) {
+        int pid = static_cast<int>(1000 + i);
+        std::snprintf(directory, sizeof(directory), "proc/%d", pid);
+        std::filesystem::create_directories(path(directory));
+        int length = std::snprintf(line, sizeof(line),
+            "%d (worker-%zu) S 1 %d %d 0 -1 4194560 %zu 0 12 0 %zu %zu 0 0 20 0 4 0 %zu "
+            "1234567890 %zu 18446744073709551615 1 1 0 0 0 0 0 4096 17922 0 0 0 17 %zu 0 0 0 0 0 "
+            "0 0 0 0 0 0 0 0\n",
+            pid, i % 1000, pid, pid, 1000 + i, 500 + i * 3, 200 + i, 100000 + i, 2000 + i % 50000, i % 512);
+        writeFile(path(directory) + "/stat", std::string(line, length));
+    }
+}
+
+void FixtureTree::writeMounts(std::size_t count) {
+    std::string content;
+    char line[256];
+    for (std::size_t i = 0; i < count; i++) {
+        switch (i % 10) {
+        case 0:
+            std::snprintf(line, sizeof(line), "/dev/nvme%zun1 /data/%zu ext4 rw,relatime 0 0\n", i % 8, i);
+            break;
+        case 1:
+        case 2:
+        case 3:
+            std::snprintf(line, sizeof(line),
+                          "overlay /var/lib/docker/overlay2/%016zx/merged overlay rw,relatime 0 0\n", i);
+            break;
+        case 4:
+        case 5:
+            std::snprintf(line, sizeof(line), "tmpfs /var/lib/kubelet/pods/pod-%zu/volumes tmpfs rw 0 0\n", i);
+            break;
+        case 6:
+            std::snprintf(line, sizeof(line), "proc /run/netns/ns-%zu/proc proc rw 0 0\n", i);
+            break;
+        case 7:
+            std::snprintf(line, sizeof(line), "shm /run/containerd/shm/%zu tmpfs rw 0 0\n", i);
+            break;
+        case 8:
+            std::snprintf(line, sizeof(line), "cgroup2 /run/container-%zu/cgroup cgroup2 rw 0 0\n", i);
+            break;
+        default:
+            std::snprintf(line, sizeof(line), "nsfs /run/netns/ns-%zu nsfs rw 0 0\n", i);
+            break;
+        }
+        content += line;
+    }
+    writeFile(path("etc/mtab"), content);
+}
+
+void FixtureTree::writeNetDev(std::size_t interfaces) {
+    std::string content =
+        "Inter-|   Receive                                                |  Transmit\n"
+        " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n";
+    char line[256];
+    for (std::size_t i = 0; i < interfaces; i++) {
+        std::snprintf(line, sizeof(line),
+                      "%6s%zu: %zu %zu 0 0 0 0 0 0 %zu %zu 0 0 0 0 0 0\n",
+                      i == 0 ? "eth" : "ens", i, 123456789 + i * 1000, 98765 + i, 987654321 + i * 2000, 54321 + i);
+        content += line;
+    }
+    writeFile(path("proc/net/dev"), content);
+}
+
+void FixtureTree::writeDiskstats(std::size_t devices) {
+    std::string content;
+    char line[256];
+    for (std::size_t i = 0; i < devices; i++) {
+        std::snprintf(line, sizeof(line),
+                      " 259 %zu nvme%zun1 %zu 1234 %zu 5678 %zu 4321 %zu 8765 0 %zu %zu 0 0 0 0 100 200\n",
+                      i, i, 100000 + i, 8000000 + i, 200000 + i, 16000000 + i, 54321 + i, 98765 + i);
+        content += line;
+    }
+    writeFile(path("proc/diskstats"), content);
+}
+
+void FixtureTree::writeCgroups(std::size_t count) {
+    std::string cgroupRoot = path("sys/fs/cgroup");
+    writeFile(cgroupRoot + "/cgroup.controllers", "cpuset cpu io memory hugetlb pids rdma misc\n");
+
+    char relative[128];
+    char content[256];
+    for (std::size_t i = 0; i < count; i++) {
+        std::snprintf(relative, sizeof(relative), "/kubepods.slice/pod-%zu.slice/container-%zu.scope", i / 50, i);
+        std::string directory = cgroupRoot + relative;
+        std::filesystem::create_directories(directory);
+
+        std::snprintf(content, sizeof(content), "usage_usec %zu\nuser_usec %zu\nsystem_usec %zu\n"
+                      "nr_periods 0\nnr_throttled 0\nthrottled_usec 0\n",
+                      1000000 + i * 37, 700000 + i * 20, 300000 + i * 17);
+        writeFile(directory + "/cpu.stat", content);
+        std::snprintf(content, sizeof(content), "%zu\n", 104857600 + i * 4096);
+        writeFile(directory + "/memory.current", content);
+        std::snprintf(content, sizeof(content),
+                      "259:0 rbytes=%zu wbytes=%zu rios=%zu wios=%zu dbytes=0 dios=0\n",
+                      4096 * i, 8192 * i, i, 2 * i);
+        writeFile(directory + "/io.stat", content);
+    }
+}
@@ -0,0 +1,50 @@
+// Synthetic /proc and sysfs trees for the benchmarks, so results do not
+// depend on how busy or how large the machine running them is.
+#ifndef BENCH_FIXTURES_H
+#define BENCH_FIXTURES_H
+
+#include <cstddef>
+#include <string>
+
+// A fixture tree in a fresh temporary directory, removed on destruction.
+// Paths below the root mirror the real ones: proc/stat, proc/<pid>/stat,
+// sys/fs/cgroup/..., etc/mtab. The counters are fixed, so collectors see
+// zero rates; parsing cost does not depend on the values.
+class FixtureTree {
+public:
+    FixtureTree();
+    ~FixtureTree();
+
+    FixtureTree(const FixtureTree&) = delete;
+    FixtureTree& operator=(const FixtureTree&) = delete;
+
+    const std::string& root() const;
+    std::string path(const char* relative) const;
+
+    // proc/stat with an aggregate line and one line per CPU
+    void writeStat(std::size_t cpus);
+
+    // proc/meminfo as a 6.x kernel writes it
+    void writeMeminfo();
+
+    // proc/<pid>/stat for `count` processes starting at PID 1000
+    void writeProcesses(std::size_t count);
+
+    // etc/mtab with `count` mounts, mostly container and virtual ones as on
+    // a busy container host, one in ten a real filesystem
+    void writeMounts(std::size_t count);
+
+    // proc/net/dev and proc/diskstats
+    void writeNetDev(std::size_t interfaces);
+    void writeDiskstats(std::size_t devices);
+
+    // sys/fs/cgroup v2 hierarchy with `count` leaf cgroups in slices of 50
+    void writeCgroups(std::size_t count);
+
+private:
+    std::string m_root;
+
+    void writeFile(const std::string& path, const std::string& content);
+};
+
+#endif // BENCH_FIXTURES_H
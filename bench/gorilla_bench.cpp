@@ -0,0 +1,162 @@
+// Benchmark: bytes per sample and encode/decode speed of the Gorilla block
+// format on synthetic traces shaped like what ResourceMonitor records.
+//
+//   cpu     busy/total jiffies of an 8-core machine, noisy
+//   memory  used/total kB, drifting slowly
+//   disk    used/total blocks, almost constant
+//
+// Timestamps are wall-clock milliseconds at 1 s with a few ms of jitter.
+// Every trace is encoded exact and rounded to 1/1024 (the archive setting);
+// both are checked to decode back to the input.
+//
+// Build and run with: make bench
+#include "compressed_history.h"
+#include "gorilla.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+const std::size_t kSamples = 86400;     // One day at 1 s
+const std::size_t kBlockSamples = 512;
+
+volatile double g_sink;                 // Keeps the decode loop from being optimised away
+
+struct Trace {
+    const char* name;
+    std::vector<std::int64_t> timestamps;
+    std::vector<double> values;
+};
+
+std::vector<std::int64_t> makeTimestamps(std::mt19937_64& rng) {
+    std::uniform_int_distribution<int> jitter(-3, 3);
+    std::vector<std::int64_t> timestamps(kSamples);
+    std::int64_t start = 1760000000000;
+    for (std::size_t i = 0; i < kSamples; i++) {
+        timestamps[i] = start + static_cast<std::int64_t>(i) * 1000 + jitter(rng);
+    }
+    return timestamps;
+}
+
+Trace cpuTrace(std::mt19937_64& rng) {
+    Trace trace{"cpu", makeTimestamps(rng), {}};
+    std::normal_distribution<double> noise(0.0, 40.0);
+    std::uniform_int_distribution<int> tickJitter(-2, 2);
+    double load = 0.2;
+    for (std::size_t i = 0; i < kSamples; i++) {
+        // Load wanders between idle and busy phases
+        load = std::min(0.95, std::max(0.02, load + (rng() % 1000 - 500) / 50000.0));
+        long total = 800 + tickJitter(rng);
+        long busy = std::lround(std::min(double(total), std::max(0.0, load * total + noise(rng))));
+        trace.values.push_back(100.0 * busy / total);
+    }
+    return trace;
+}
+
+Trace memoryTrace(std::mt19937_64& rng) {
+    Trace trace{"memory", makeTimestamps(rng), {}};
+    const double totalKB = 16.0 * 1024 * 1024;
+    double usedKB = 6.0 * 1024 * 1024;
+    std::normal_distribution<double> drift(0.0, 256.0);
+    for (std::size_t i = 0; i < kSamples; i++) {
+        usedKB = std::round(usedKB + drift(rng));
+        trace.values.push_back(100.0 * usedKB / totalKB);
+    }
+    return trace;
+}
+
+Trace diskTrace(std::mt19937_64& rng) {
+    Trace trace{"disk", makeTimestamps(rng), {}};
+    const double totalBlocks = 250.0 * 1024 * 1024 / 4;
+    double usedBlocks = totalBlocks * 0.41;
+    for (std::size_t i = 0; i < kSamples; i++) {
+        // Capacity is only re-read every few seconds and rarely changes
+        if (i % 10 == 0 && rng() % 4 == 0) {
+            usedBlocks += static_cast<double>(rng() % 64);
+        }
+        trace.values.push_back(100.0 * usedBlocks / totalBlocks);
+    }
+    return trace;
+}
+
+void run(const Trace& trace, double quantum) {
+    std::vector<double> input = trace.values;
+    if (quantum > 0.0) {
+        for (double& v : input) {
+            v = std::round(v / quantum) * quantum;
+        }
+    }
+
+    // Encode
+    std::vector<GorillaBlock> blocks((kSamples + kBlockSamples - 1) / kBlockSamples);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < kSamples; i++) {
+        blocks[i / kBlockSamples].append(trace.timestamps[i], input[i]);
+    }
+    double encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::size_t bytes = 0;
+    for (const GorillaBlock& block : blocks) {
+        bytes += block.byteSize();
+    }
+
+    // Decode, repeated to get a stable figure
+    const int rounds = 20;
+    double checksum = 0.0;
+    std::size_t mismatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        std::size_t i = 0;
+        for (const GorillaBlock& block : blocks) {
+            GorillaDecoder decoder(block);
+            std::int64_t timestamp;
+            double value;
+            while (decoder.next(timestamp, value)) {
+                checksum += value;
+                if (round == 0 && (timestamp != trace.timestamps[i] || value != input[i])) {
+                    mismatches++;
+                }
+                i++;
+            }
+        }
+    }
+    double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    g_sink = checksum;
+    std::printf("%-8s %-8s %8.2f %10.1f %12.1f %10zu\n",
+                trace.name, quantum > 0.0 ? "1/1024" : "exact",
+                double(bytes) / kSamples,
+                encodeSeconds * 1e9 / kSamples,
+                rounds * kSamples / decodeSeconds / 1e6,
+                mismatches);
+    if (mismatches != 0) {
+        std::exit(1);
+    }
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(42);
+    std::vector<Trace> traces = {cpuTrace(rng), memoryTrace(rng), diskTrace(rng)};
+
+    std::printf("%zu samples per trace, %zu per block; HistoryData keeps 16 bytes per sample\n\n",
+                kSamples, kBlockSamples);
+    std::printf("%-8s %-8s %8s %10s %12s %10s\n", "trace", "values", "B/sample", "enc ns", "dec Msamp/s", "mismatch");
+    for (const Trace& trace : traces) {
+        run(trace, 0.0);
+        run(trace, 1.0 / 1024.0);
+    }
+
+    // The archive as RollupHistory uses it
+    CompressedHistory archive(21600, kBlockSamples, 1.0 / 1024.0);
+    for (std::size_t i = 0; i < kSamples; i++) {
+        archive.addSample(traces[0].timestamps[i], traces[0].values[i]);
+    }
+    std::printf("\ncpu archive: %zu samples in %zu bytes\n", archive.getSize(), archive.getByteSize());
+    return 0;
+}
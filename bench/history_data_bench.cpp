@@ -0,0 +1,71 @@
+// Microbenchmark: HistoryData ring buffer vs. the previous vector front-erase
+// implementation, at history capacities from 600 to 1M samples.
+//
+// Build and run with: make bench
+#include "history_data.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// The implementation HistoryData used before the ring buffer
+class VectorEraseHistory {
+public:
+    explicit VectorEraseHistory(std::size_t capacity) : m_capacity(capacity) {
+        m_samples.reserve(capacity);
+    }
+
+    void addSample(double value) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_samples.size() >= m_capacity) {
+            m_samples.erase(m_samples.begin());
+        }
+        m_samples.push_back(value);
+    }
+
+private:
+    std::vector<double> m_samples;
+    std::size_t m_capacity;
+    std::mutex m_mutex;
+};
+
+template <typename History>
+double nsPerSample(std::size_t capacity, std::size_t iterations) {
+    History history(capacity);
+
+    // Fill to capacity first, the steady state is what matters
+    for (std::size_t i = 0; i < capacity; i++) {
+        history.addSample(static_cast<double>(i % 100));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; i++) {
+        history.addSample(static_cast<double>(i % 100));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return ns / iterations;
+}
+
+} // namespace
+
+int main() {
+    const std::size_t capacities[] = {600, 3600, 86400, 1000000};
+
+    std::printf("%-10s %18s %18s %10s\n", "capacity", "vector-erase ns", "ring ns", "speedup");
+    for (std::size_t capacity : capacities) {
+        // The erase path is O(capacity), so scale its iteration count down
+        std::size_t eraseIterations = std::max<std::size_t>(200, 20000000 / capacity);
+        std::size_t ringIterations = 5000000;
+
+        double erase = nsPerSample<VectorEraseHistory>(capacity, eraseIterations);
+        double ring = nsPerSample<HistoryData>(capacity, ringIterations);
+        std::printf("%-10zu %18.1f %18.1f %9.1fx\n", capacity, erase, ring, erase / ring);
+    }
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Benchmark: samples per second for /proc/stat + /proc/meminfo parsing, the
+// old ifstream/istringstream readers vs. ProcFile with in-place parsing.
+// Both parsers mirror ResourceMonitor::readCPUStats and readMemoryInfo.
+//
+// Build and run with: make bench
+#include "proc_reader.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+struct Sample {
+    unsigned long long cpu[10];
+    unsigned long long memTotal;
+    unsigned long long memAvailable;
+};
+
+bool legacySample(Sample& sample) {
+    std::ifstream stat("/proc/stat");
+    std::string line;
+    bool found = false;
+    while (std::getline(stat, line)) {
+        if (line.substr(0, 3) == "cpu" && line[3] == ' ') {
+            std::istringstream iss(line.substr(5));
+            for (auto& v : sample.cpu) {
+                iss >> v;
+            }
+            found = true;
+            break;
+        }
+    }
+
+    std::ifstream meminfo("/proc/meminfo");
+    while (std::getline(meminfo, line)) {
+        std::istringstream iss(line);
+        std::string key;
+        unsigned long long value;
+        std::string unit;
+        iss >> key >> value >> unit;
+        if (key == "MemTotal:") {
+            sample.memTotal = value;
+        } else if (key == "MemAvailable:") {
+            sample.memAvailable = value;
+        }
+    }
+    return found;
+}
+
+class ProcFileSampler {
+public:
+    ProcFileSampler() : m_stat(64 * 1024), m_meminfo(8 * 1024) {
+        m_stat.open("/proc/stat");
+        m_meminfo.open("/proc/meminfo");
+    }
+
+    bool sample(Sample& sample) {
+        if (!m_stat.read() || !m_meminfo.read()) {
+            return false;
+        }
+        const char* p = m_stat.data();
+        const char* end = m_stat.end();
+        if (!ProcParse::startsWith(p, end, "cpu ", 4)) {
+            return false;
+        }
+        p += 4;
+        for (auto& v : sample.cpu) {
+            p = ProcParse::parseUnsigned(p, end, v);
+        }
+
+        p = m_meminfo.data();
+        end = m_meminfo.end();
+        while (p < end) {
+            if (ProcParse::startsWith(p, end, "MemTotal:", 9)) {
+                ProcParse::parseUnsigned(p + 9, end, sample.memTotal);
+            } else if (ProcParse::startsWith(p, end, "MemAvailable:", 13)) {
+                ProcParse::parseUnsigned(p + 13, end, sample.memAvailable);
+                break;
+            }
+            p = ProcParse::nextLine(p, end);
+        }
+        return true;
+    }
+
+private:
+    ProcFile m_stat;
+    ProcFile m_meminfo;
+};
+
+template <typename Fn>
+double samplesPerSecond(Fn&& fn) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::seconds(1);
+    std::size_t samples = 0;
+    while (Clock::now() < deadline) {
+        for (int i = 0; i < 64; i++) {
+            fn();
+        }
+        samples += 64;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return samples / seconds;
+}
+
+} // namespace
+
+int main() {
+    Sample sample = {};
+    volatile unsigned long long sink = 0;
+
+    double legacy = samplesPerSecond([&] {
+        legacySample(sample);
+        sink = sample.cpu[0] + sample.memAvailable;
+    });
+
+    ProcFileSampler sampler;
+    double procFile = samplesPerSecond([&] {
+        sampler.sample(sample);
+        sink = sample.cpu[0] + sample.memAvailable;
+    });
+
+    std::printf("%-24s %14s\n", "parser", "samples/s");
+    std::printf("%-24s %14.0f\n", "ifstream + istringstream", legacy);
+    std::printf("%-24s %14.0f\n", "ProcFile + pread", procFile);
+    std::printf("%-24s %13.1fx\n", "speedup", procFile / legacy);
+    (void)sink;
+    return 0;
+}
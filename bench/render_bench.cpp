@@ -0,0 +1,140 @@
+// Benchmark suite: ResourceGraph and CPUHeatmap rendering into an offscreen
+// cairo image surface, one new sample per frame as in the running monitor.
+//
+// Build and run with: make bench-render. Needs GTK and, for the widgets, a
+// display; on a headless box run it under xvfb-run.
+#include "bench.h"
+#include "resource_graphs.h"
+#include "history_data.h"
+#include "rollup_history.h"
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const int kWidth = 800;
+const int kHeight = 200;
+
+// Offscreen target for one benchmark
+class Canvas {
+public:
+    Canvas(int width, int height)
+        : m_surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height)),
+          m_cr(cairo_create(m_surface))
+    {
+    }
+
+    ~Canvas() {
+        cairo_destroy(m_cr);
+        cairo_surface_destroy(m_surface);
+    }
+
+    cairo_t* get() const { return m_cr; }
+
+private:
+    cairo_surface_t* m_surface;
+    cairo_t* m_cr;
+};
+
+double wave(std::size_t i) {
+    return 50.0 + 40.0 * ((i * 7919) % 100) / 100.0 - 20.0;
+}
+
+void graphFrames(BenchState& state, std::size_t capacity, bool scroll) {
+    HistoryData history(capacity);
+    for (std::size_t i = 0; i < capacity; i++) {
+        history.addSample(wave(i));
+    }
+    ResourceGraph graph;
+    graph.setDataSource(&history);
+    graph.setScrollMode(scroll);
+    Canvas canvas(kWidth, kHeight);
+
+    std::size_t i = capacity;
+    while (state.keepRunning()) {
+        history.addSample(wave(i++));
+        graph.draw(canvas.get(), kWidth, kHeight);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_GraphFullRedraw600(BenchState& state) {
+    graphFrames(state, 600, false);
+}
+BENCHMARK(BM_GraphFullRedraw600);
+
+void BM_GraphScroll600(BenchState& state) {
+    graphFrames(state, 600, true);
+}
+BENCHMARK(BM_GraphScroll600);
+
+void BM_GraphFullRedraw86400(BenchState& state) {
+    // Far more samples than pixels, so the min/max downsampling dominates
+    graphFrames(state, 86400, false);
+}
+BENCHMARK(BM_GraphFullRedraw86400);
+
+void BM_GraphRollupBytesWithSecondary(BenchState& state) {
+    // Autoscaled bytes over rollup tiers, one series filled, the other as a line
+    RollupHistory rx(600, 1.0);
+    RollupHistory tx(600, 1.0);
+    std::int64_t timestamp = 1700000000000;
+    for (std::size_t i = 0; i < 3600; i++) {
+        rx.addSample(wave(i) * 1e6, timestamp);
+        tx.addSample(wave(i + 13) * 2e5, timestamp);
+        timestamp += 1000;
+    }
+    ResourceGraph graph;
+    graph.setValueFormat(ResourceGraph::ValueFormat::BytesPerSecond);
+    graph.setDataSource(&rx);
+    graph.setSecondaryDataSource(&tx);
+    Canvas canvas(kWidth, kHeight);
+
+    std::size_t i = 3600;
+    while (state.keepRunning()) {
+        rx.addSample(wave(i) * 1e6, timestamp);
+        tx.addSample(wave(i + 13) * 2e5, timestamp);
+        timestamp += 1000;
+        i++;
+        graph.draw(canvas.get(), kWidth, kHeight);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GraphRollupBytesWithSecondary);
+
+void BM_Heatmap512Cores(BenchState& state) {
+    std::vector<std::unique_ptr<HistoryData>> cores;
+    std::vector<HistoryData*> sources;
+    for (std::size_t c = 0; c < 512; c++) {
+        cores.push_back(std::make_unique<HistoryData>(600));
+        for (std::size_t i = 0; i < 600; i++) {
+            cores.back()->addSample(wave(i + c));
+        }
+        sources.push_back(cores.back().get());
+    }
+    CPUHeatmap heatmap;
+    heatmap.setDataSources(sources);
+    Canvas canvas(kWidth, 600);
+
+    std::size_t i = 600;
+    while (state.keepRunning()) {
+        for (std::size_t c = 0; c < cores.size(); c++) {
+            cores[c]->addSample(wave(i + c));
+        }
+        i++;
+        heatmap.draw(canvas.get(), kWidth, 600);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Heatmap512Cores);
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!gtk_init_check(&argc, &argv)) {
+        std::printf("render_bench: no display (try xvfb-run make bench-render)\n");
+        return 1;
+    }
+    return runBenchmarks(argc, argv);
+}
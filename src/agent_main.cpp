@@ -0,0 +1,281 @@
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <cerrno>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <functional>
+#include <map>
+#include <pthread.h>
+#include <sys/resource.h>
+#include "resource_monitor.h"
+#include "alert_engine.h"
+#include "settings.h"
+#include "sampler.h"
+#include "pressure_triggers.h"
+#include "metrics_exporter.h"
+#include "diagnostics.h"
+#include "monitor_clock.h"
+#include "trace.h"
+
+// Headless collector: the same sampling as the GUI, without GTK or libnotify.
+// Histories are persisted as usual; alert rules and PSI alerts go to stderr.
+// With --metrics (or metrics_address in the settings) current values are
+// served to Prometheus. SIGUSR1 prints the monitor's own timings to stderr.
+// Runs in the foreground until SIGINT or SIGTERM, as a service manager expects.
+//
+// --root reads another /proc, /sys and /etc tree. --record writes the raw
+// inputs of every sample to a trace; --replay plays one back at --speed
+// times the recorded rate (0: as fast as possible), then prints the timings
+// and exits.
+
+// Latency and allocation table of every probe
+static void printDiagnostics() {
+    std::cerr << "Монитор использует ЦП: " << Diagnostics::processCPUPercent() << "%" << std::endl;
+    for (std::size_t i = 0; i < kProbeCount; i++) {
+        Probe probe = static_cast<Probe>(i);
+        ProbeStats stats = Diagnostics::stats(probe);
+        std::cerr << Diagnostics::probeName(probe)
+                  << ": count=" << stats.latency.count
+                  << " p50=" << stats.latency.percentileNs(0.5) / 1000 << "us"
+                  << " p99=" << stats.latency.percentileNs(0.99) / 1000 << "us"
+                  << " max=" << stats.latency.maxNs / 1000 << "us"
+                  << " allocations=" << stats.lastAllocations << "/" << stats.maxAllocations << std::endl;
+    }
+}
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--interval MS] [--metrics PORT|SOCKET] [--root DIR]"
+              << " [--record FILE] [--replay FILE [--speed N]]" << std::endl;
+}
+
+// Evaluate the alert rules against a snapshot and print what changed. A rule
+// that fires again is printed once per cooldown; the cooldown runs on the
+// monitor's clock, so replays keep the recorded spacing.
+struct AlertState {
+    AlertEngine engine;
+    std::vector<AlertEvent> events;
+    std::map<std::string, std::chrono::steady_clock::time_point> lastAlert;
+};
+
+static void reportAlerts(AlertState& alerts, const ResourceMonitor& monitor, const ResourceSnapshot& snapshot,
+                         const Settings& settings) {
+    alerts.engine.evaluate(snapshot, monitor, alerts.events);
+    auto now = MonitorClock::now();
+    auto cooldown = std::chrono::seconds(settings.getNotificationCooldown());
+    if (!alerts.events.empty()) {
+        // Keys name instances, which come and go; entries past the cooldown
+        // hold nothing back any more
+        for (auto it = alerts.lastAlert.begin(); it != alerts.lastAlert.end();) {
+            if (now - it->second >= cooldown) {
+                it = alerts.lastAlert.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (const AlertEvent& event : alerts.events) {
+        if (!event.firing) {
+            if (event.absent) {
+                alerts.lastAlert.erase(event.key);
+            }
+            std::cerr << event.message << std::endl;
+            continue;
+        }
+        auto it = alerts.lastAlert.find(event.key);
+        if (it == alerts.lastAlert.end() || now - it->second >= cooldown) {
+            alerts.lastAlert[event.key] = now;
+            std::cerr << event.message << std::endl;
+        }
+    }
+}
+
+// Whole trace without pauses between samples, for benchmarking the pipeline
+static void replayUnthrottled(TraceReplayer& replayer, ResourceMonitor& monitor, const Settings& settings,
+                              AlertState& alerts, const std::function<void(const ResourceSnapshot&)>& sampleCallback) {
+    ResourceSnapshot snapshot;
+    auto start = std::chrono::steady_clock::now();
+    while (replayer.step()) {
+        monitor.sample();
+        monitor.fillSnapshot(snapshot);
+        if (sampleCallback) {
+            sampleCallback(snapshot);
+        }
+        reportAlerts(alerts, monitor, snapshot, settings);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Воспроизведено " << replayer.ticks() << " отсчётов за " << seconds << " с" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    // Block the stop signals and SIGUSR1 before any thread starts, so that only
+    // sigtimedwait() below ever sees them
+    sigset_t handledSignals;
+    sigemptyset(&handledSignals);
+    sigaddset(&handledSignals, SIGINT);
+    sigaddset(&handledSignals, SIGTERM);
+    sigaddset(&handledSignals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &handledSignals, nullptr);
+    
+    // Let the process collector keep one fd per process on large hosts
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    
+    Settings settings;
+    settings.load();
+    int interval = settings.getSampleInterval();
+    std::string metricsAddress = settings.getMetricsAddress();
+    std::string root;
+    std::string recordPath;
+    std::string replayPath;
+    int speed = 100;
+    
+    for (int i = 1; i < argc; i++) {
+        if ((std::strcmp(argv[i], "--interval") == 0 || std::strcmp(argv[i], "-i") == 0) && i + 1 < argc) {
+            interval = std::atoi(argv[++i]);
+        } else if ((std::strcmp(argv[i], "--metrics") == 0 || std::strcmp(argv[i], "-m") == 0) && i + 1 < argc) {
+            metricsAddress = argv[++i];
+        } else if (std::strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            root = argv[++i];
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = std::atoi(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (interval <= 0 || speed < 0 || (!root.empty() && !replayPath.empty())) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    
+    // Declared before the monitor, which reads the files it writes
+    TraceReplayer replayer;
+    if (!replayPath.empty()) {
+        if (!replayer.open(replayPath)) {
+            return 1;
+        }
+        root = replayer.root();
+    }
+    
+    // The built-in thresholds plus the rules file; a bad rule is fatal here,
+    // where nobody would see it scroll past
+    AlertState alerts;
+    std::string ruleError;
+    if (!alerts.engine.compile(AlertEngine::loadRules(settings), ruleError)) {
+        std::cerr << "Invalid alert rule in " << settings.getAlertRulesPath() << ": " << ruleError << std::endl;
+        return 1;
+    }
+    
+    ResourceMonitor monitor(&settings, root);
+    monitor.setDiskPollInterval(settings.getDiskPollInterval());
+    if (!monitor.initialize()) {
+        std::cerr << "Failed to initialize resource monitor" << std::endl;
+        return 1;
+    }
+    
+    // Declared before the sampler, which renders into it until stopped
+    MetricsExporter exporter;
+    if (!metricsAddress.empty() && !exporter.start(metricsAddress)) {
+        return 1;
+    }
+    
+    TraceRecorder recorder;
+    if (!recordPath.empty() && !recorder.open(recordPath, root)) {
+        return 1;
+    }
+    
+    std::function<void(const ResourceSnapshot&)> sampleCallback;
+    if (exporter.isRunning() || recorder.isOpen()) {
+        sampleCallback = [&](const ResourceSnapshot& snapshot) {
+            if (exporter.isRunning()) {
+                exporter.render(snapshot, monitor);
+            }
+            if (recorder.isOpen()) {
+                recorder.capture(snapshot);
+            }
+        };
+    }
+    
+    if (!replayPath.empty() && speed == 0) {
+        replayUnthrottled(replayer, monitor, settings, alerts, sampleCallback);
+        printDiagnostics();
+        return 0;
+    }
+    
+    // A replay samples `speed` times faster and advances the trace before each sample
+    if (!replayPath.empty()) {
+        interval = std::max(1, interval / speed);
+    }
+    Sampler sampler(&monitor, interval);
+    sampler.setSampleCallback(sampleCallback);
+    if (!replayPath.empty()) {
+        sampler.setTickCallback([&replayer]() {
+            return replayer.step();
+        });
+    }
+    sampler.start();
+    
+    // Stalls are reported from the watcher thread as soon as the kernel
+    // flags them; the cooldown state is only touched there. The triggers
+    // watch the running kernel, so not with another root.
+    std::chrono::steady_clock::time_point lastPressureAlert[kPressureResourceCount];
+    PressureTriggers pressureTriggers;
+    if (root.empty()) {
+        pressureTriggers.start(settings.getPressureThreshold(), [&](PressureResource resource) {
+            auto now = std::chrono::steady_clock::now();
+            auto& last = lastPressureAlert[static_cast<std::size_t>(resource)];
+            if (last.time_since_epoch().count() == 0 ||
+                now - last >= std::chrono::seconds(settings.getNotificationCooldown())) {
+                last = now;
+                std::cerr << "Ожидание ресурса " << PressureCollector::resourceName(resource) << " больше "
+                          << settings.getPressureThreshold() << "% времени" << std::endl;
+            }
+        });
+    }
+    
+    // Wake once per interval to look at the newest snapshot; a stop signal
+    // ends the wait early
+    struct timespec timeout;
+    timeout.tv_sec = interval / 1000;
+    timeout.tv_nsec = (interval % 1000) * 1000000L;
+    
+    for (;;) {
+        int signal = sigtimedwait(&handledSignals, nullptr, &timeout);
+        if (signal == SIGUSR1) {
+            printDiagnostics();
+            continue;
+        }
+        if (signal > 0) {
+            break;
+        }
+        if (signal < 0 && errno != EAGAIN && errno != EINTR) {
+            std::cerr << "sigtimedwait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        
+        if (sampler.poll()) {
+            reportAlerts(alerts, monitor, sampler.latest(), settings);
+        }
+        
+        if (replayer.finished()) {
+            std::cerr << "Воспроизведено " << replayer.ticks() << " отсчётов" << std::endl;
+            printDiagnostics();
+            break;
+        }
+    }
+    
+    // Stop sampling before the monitor flushes its history files
+    pressureTriggers.stop();
+    sampler.stop();
+    return 0;
+}
@@ -0,0 +1,863 @@
+#include "alert_engine.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include "diagnostics.h"
+#include "monitor_clock.h"
+
+static const double kAbsent = std::numeric_limits<double>::quiet_NaN();
+
+// Points between a built-in threshold and the value at which its alert clears
+static const double kDefaultHysteresis = 5.0;
+
+// Instances absent this long lose their "*" rows and their histories
+static const std::int64_t kInstanceExpiryMs = 10 * 60 * 1000;
+
+// How often absent instances are looked for
+static const std::int64_t kExpiryIntervalMs = 60 * 1000;
+
+static std::string trim(const std::string& text) {
+    std::size_t begin = 0;
+    std::size_t end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) {
+        begin++;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        end--;
+    }
+    return text.substr(begin, end - begin);
+}
+
+// A number with an optional K, M or G suffix (powers of 1024) or a percent sign
+static bool parseNumber(const std::string& text, double& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str()) {
+        return false;
+    }
+    std::string suffix(end);
+    if (suffix == "K" || suffix == "k") {
+        value *= 1024.0;
+    } else if (suffix == "M") {
+        value *= 1024.0 * 1024.0;
+    } else if (suffix == "G") {
+        value *= 1024.0 * 1024.0 * 1024.0;
+    } else if (!suffix.empty() && suffix != "%") {
+        return false;
+    }
+    return std::isfinite(value);
+}
+
+static std::string formatNumber(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%g", value);
+    return buffer;
+}
+
+AlertEngine::AlertEngine()
+    : m_firingCount(0),
+      m_now(0),
+      m_lastExpiry(0)
+{
+    std::fill(std::begin(m_metricUsed), std::end(m_metricUsed), false);
+}
+
+AlertEngine::~AlertEngine() {
+}
+
+std::vector<std::string> AlertEngine::builtInRules(const Settings& settings) {
+    std::vector<std::string> rules;
+    const struct {
+        const char* metric;
+        double threshold;
+    } builtIn[] = {
+        {"cpu", settings.getCPUThreshold()},
+        {"memory", settings.getMemoryThreshold()},
+        {"disk:*", settings.getDiskThreshold()},
+    };
+    for (const auto& rule : builtIn) {
+        double clear = std::max(0.0, rule.threshold - kDefaultHysteresis);
+        rules.push_back(std::string(rule.metric) + " >= " + formatNumber(rule.threshold) +
+                        " clear " + formatNumber(clear));
+    }
+    return rules;
+}
+
+std::vector<std::string> AlertEngine::readRulesFile(const std::string& path) {
+    std::vector<std::string> rules;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (!line.empty() && line[0] != '#') {
+            rules.push_back(line);
+        }
+    }
+    return rules;
+}
+
+std::vector<std::string> AlertEngine::loadRules(const Settings& settings) {
+    std::vector<std::string> rules = builtInRules(settings);
+    std::vector<std::string> fileRules = readRulesFile(settings.getAlertRulesPath());
+    rules.insert(rules.end(), fileRules.begin(), fileRules.end());
+    return rules;
+}
+
+bool AlertEngine::parseDuration(const std::string& text, std::int64_t& milliseconds) {
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || !std::isfinite(value) || value < 0) {
+        return false;
+    }
+    std::string unit(end);
+    double scale;
+    if (unit.empty() || unit == "s") {
+        scale = 1000.0;
+    } else if (unit == "ms") {
+        scale = 1.0;
+    } else if (unit == "m") {
+        scale = 60000.0;
+    } else if (unit == "h") {
+        scale = 3600000.0;
+    } else {
+        return false;
+    }
+    milliseconds = static_cast<std::int64_t>(value * scale);
+    return true;
+}
+
+bool AlertEngine::parseRule(const std::string& text, Rule& rule, std::string& error) {
+    static const struct {
+        const char* name;
+        Metric metric;
+        bool instanced;
+        bool hasHistory;
+    } metrics[] = {
+        {"cpu", Metric::CPU, false, true},
+        {"core", Metric::Core, true, true},
+        {"memory", Metric::Memory, false, true},
+        {"disk", Metric::Disk, true, true},
+        {"disk_read", Metric::DiskRead, true, true},
+        {"disk_write", Metric::DiskWrite, true, true},
+        {"disk_util", Metric::DiskUtil, true, false},
+        {"net_rx", Metric::NetRx, true, true},
+        {"net_tx", Metric::NetTx, true, true},
+        {"psi_cpu", Metric::PressureCPU, false, true},
+        {"psi_memory", Metric::PressureMemory, false, true},
+        {"psi_io", Metric::PressureIO, false, true},
+        {"cgroup_cpu", Metric::CgroupCPU, true, true},
+        {"cgroup_memory", Metric::CgroupMemory, true, false},
+    };
+    static const struct {
+        const char* name;
+        Stat stat;
+    } stats[] = {
+        {"avg", Stat::Average},
+        {"min", Stat::Minimum},
+        {"max", Stat::Maximum},
+        {"ewma", Stat::EWMA},
+    };
+
+    rule.text = text;
+    error = "\"" + text + "\": ";
+
+    // The comparator splits the metric from the rest
+    std::size_t op = text.find_first_of("<>");
+    if (op == std::string::npos) {
+        error += "no comparator";
+        return false;
+    }
+    rule.below = text[op] == '<';
+    rule.strict = op + 1 >= text.size() || text[op + 1] != '=';
+    std::string expression = trim(text.substr(0, op));
+    std::string rest = text.substr(op + (rule.strict ? 1 : 2));
+
+    rule.stat = Stat::Value;
+    std::size_t open = expression.find('(');
+    if (open != std::string::npos) {
+        if (expression.back() != ')') {
+            error += "unbalanced parentheses";
+            return false;
+        }
+        std::string name = trim(expression.substr(0, open));
+        bool known = false;
+        for (const auto& stat : stats) {
+            if (name == stat.name) {
+                rule.stat = stat.stat;
+                known = true;
+            }
+        }
+        if (!known) {
+            error += "unknown statistic " + name;
+            return false;
+        }
+        expression = trim(expression.substr(open + 1, expression.size() - open - 2));
+    }
+
+    std::string name = expression;
+    rule.instance.clear();
+    std::size_t colon = expression.find(':');
+    if (colon != std::string::npos) {
+        name = trim(expression.substr(0, colon));
+        rule.instance = trim(expression.substr(colon + 1));
+    }
+    bool known = false;
+    for (const auto& metric : metrics) {
+        if (name != metric.name) {
+            continue;
+        }
+        known = true;
+        rule.metric = metric.metric;
+        if (metric.instanced && rule.instance.empty()) {
+            error += name + " needs an instance, e.g. " + name + ":*";
+            return false;
+        }
+        if (!metric.instanced && colon != std::string::npos) {
+            error += name + " has no instances";
+            return false;
+        }
+        if (rule.stat != Stat::Value && !metric.hasHistory) {
+            error += name + " has no history for statistics";
+            return false;
+        }
+    }
+    if (!known) {
+        error += "unknown metric " + name;
+        return false;
+    }
+    if (rule.metric == Metric::Core && rule.instance != "*" &&
+        rule.instance.find_first_not_of("0123456789") != std::string::npos) {
+        error += "core instance must be a number or *";
+        return false;
+    }
+
+    // Threshold, then "for" and "clear" in any order
+    std::vector<std::string> tokens;
+    std::size_t position = 0;
+    while (position < rest.size()) {
+        std::size_t begin = rest.find_first_not_of(" \t", position);
+        if (begin == std::string::npos) {
+            break;
+        }
+        std::size_t end = rest.find_first_of(" \t", begin);
+        if (end == std::string::npos) {
+            end = rest.size();
+        }
+        tokens.push_back(rest.substr(begin, end - begin));
+        position = end;
+    }
+    if (tokens.empty() || !parseNumber(tokens[0], rule.threshold)) {
+        error += "bad threshold";
+        return false;
+    }
+    rule.clearThreshold = rule.threshold;
+    rule.forMs = 0;
+    bool hasFor = false;
+    bool hasClear = false;
+    for (std::size_t i = 1; i < tokens.size(); i += 2) {
+        if (i + 1 >= tokens.size()) {
+            error += "missing value after " + tokens[i];
+            return false;
+        }
+        if (tokens[i] == "for" && !hasFor) {
+            if (!parseDuration(tokens[i + 1], rule.forMs)) {
+                error += "bad duration " + tokens[i + 1];
+                return false;
+            }
+            hasFor = true;
+        } else if (tokens[i] == "clear" && !hasClear) {
+            if (!parseNumber(tokens[i + 1], rule.clearThreshold)) {
+                error += "bad clear threshold " + tokens[i + 1];
+                return false;
+            }
+            hasClear = true;
+        } else {
+            error += "unexpected " + tokens[i];
+            return false;
+        }
+    }
+
+    // The clear threshold may only widen the firing band
+    if (rule.below ? rule.clearThreshold < rule.threshold : rule.clearThreshold > rule.threshold) {
+        error += "clear threshold is on the wrong side of the threshold";
+        return false;
+    }
+
+    error.clear();
+    return true;
+}
+
+bool AlertEngine::compile(const std::vector<std::string>& rules, std::string& error) {
+    std::vector<Rule> parsed(rules.size());
+    for (std::size_t i = 0; i < rules.size(); i++) {
+        if (!parseRule(rules[i], parsed[i], error)) {
+            return false;
+        }
+    }
+
+    m_rules = std::move(parsed);
+    m_slots.clear();
+    m_values.clear();
+    for (std::size_t m = 0; m < kMetricCount; m++) {
+        m_slotIndex[m].clear();
+        m_wildcardRules[m].clear();
+        m_knownInstances[m].clear();
+        m_metricUsed[m] = false;
+    }
+    m_rowRule.clear();
+    m_rowSlot.clear();
+    m_rowSign.clear();
+    m_rowThreshold.clear();
+    m_rowClear.clear();
+    m_rowStrict.clear();
+    m_rowForMs.clear();
+    m_rowPendingSince.clear();
+    m_rowFiring.clear();
+    m_firingCount = 0;
+    m_lastExpiry = 0;
+
+    for (std::size_t i = 0; i < m_rules.size(); i++) {
+        const Rule& rule = m_rules[i];
+        std::size_t m = static_cast<std::size_t>(rule.metric);
+        m_metricUsed[m] = true;
+        if (rule.instance == "*") {
+            m_wildcardRules[m].push_back(static_cast<std::uint32_t>(i));
+        } else {
+            addRow(static_cast<std::uint32_t>(i), slotFor(rule.metric, rule.stat, rule.instance));
+        }
+    }
+    return true;
+}
+
+std::uint32_t AlertEngine::slotFor(Metric metric, Stat stat, const std::string& instance) {
+    auto& index = m_slotIndex[static_cast<std::size_t>(metric)];
+    auto it = index.find(instance);
+    if (it == index.end()) {
+        std::array<std::uint32_t, kStatCount> none;
+        none.fill(kNoSlot);
+        it = index.emplace(instance, none).first;
+    }
+    std::uint32_t& id = it->second[static_cast<std::size_t>(stat)];
+    if (id == kNoSlot) {
+        id = static_cast<std::uint32_t>(m_slots.size());
+        m_slots.push_back(Slot{metric, stat, instance, nullptr, nullptr, m_now});
+        m_values.push_back(kAbsent);
+    }
+    return id;
+}
+
+void AlertEngine::addRow(std::uint32_t rule, std::uint32_t slot) {
+    const Rule& r = m_rules[rule];
+    double sign = r.below ? -1.0 : 1.0;
+    m_rowRule.push_back(rule);
+    m_rowSlot.push_back(slot);
+    m_rowSign.push_back(sign);
+    m_rowThreshold.push_back(sign * r.threshold);
+    m_rowClear.push_back(sign * r.clearThreshold);
+    m_rowStrict.push_back(r.strict);
+    m_rowForMs.push_back(r.forMs);
+    m_rowPendingSince.push_back(-1);
+    m_rowFiring.push_back(0);
+}
+
+void AlertEngine::bindHistory(Slot& slot, const ResourceMonitor& monitor) {
+    RollupHistory* rollup = nullptr;
+    switch (slot.metric) {
+        case Metric::CPU:
+            rollup = monitor.getCPUHistory();
+            break;
+        case Metric::Core:
+            slot.history = monitor.getCoreHistory(std::strtoul(slot.instance.c_str(), nullptr, 10));
+            return;
+        case Metric::Memory:
+            rollup = monitor.getMemoryHistory();
+            break;
+        case Metric::Disk: {
+            // Shares ownership of the whole rollup, which frees with the disk
+            std::shared_ptr<RollupHistory> usage = monitor.getDiskHistory(slot.instance);
+            slot.ownedHistory = usage ? std::shared_ptr<HistoryData>(usage, usage->raw()) : nullptr;
+            slot.history = slot.ownedHistory.get();
+            return;
+        }
+        case Metric::DiskRead:
+            slot.ownedHistory = monitor.getDiskReadHistory(slot.instance);
+            slot.history = slot.ownedHistory.get();
+            return;
+        case Metric::DiskWrite:
+            slot.ownedHistory = monitor.getDiskWriteHistory(slot.instance);
+            slot.history = slot.ownedHistory.get();
+            return;
+        case Metric::NetRx:
+            slot.ownedHistory = monitor.getNetworkRxHistory(slot.instance);
+            slot.history = slot.ownedHistory.get();
+            return;
+        case Metric::NetTx:
+            slot.ownedHistory = monitor.getNetworkTxHistory(slot.instance);
+            slot.history = slot.ownedHistory.get();
+            return;
+        case Metric::PressureCPU:
+            slot.history = monitor.getPressureAvg10History(PressureResource::CPU);
+            return;
+        case Metric::PressureMemory:
+            slot.history = monitor.getPressureAvg10History(PressureResource::Memory);
+            return;
+        case Metric::PressureIO:
+            slot.history = monitor.getPressureAvg10History(PressureResource::IO);
+            return;
+        case Metric::CgroupCPU:
+            slot.ownedHistory = monitor.getCgroupCPUHistory(slot.instance);
+            slot.history = slot.ownedHistory.get();
+            return;
+        case Metric::DiskUtil:
+        case Metric::CgroupMemory:
+            return;
+    }
+    slot.history = rollup ? rollup->raw() : nullptr;
+}
+
+void AlertEngine::observe(Metric metric, const std::string& instance, double value, const ResourceMonitor& monitor,
+                          bool wildcard) {
+    std::size_t m = static_cast<std::size_t>(metric);
+    if (wildcard && !m_wildcardRules[m].empty()) {
+        auto known = m_knownInstances[m].emplace(instance, m_now);
+        if (known.second) {
+            for (std::uint32_t rule : m_wildcardRules[m]) {
+                addRow(rule, slotFor(metric, m_rules[rule].stat, instance));
+            }
+        } else {
+            known.first->second = m_now;
+        }
+    }
+
+    auto it = m_slotIndex[m].find(instance);
+    if (it == m_slotIndex[m].end()) {
+        return;
+    }
+    const std::array<std::uint32_t, kStatCount>& ids = it->second;
+    for (std::uint32_t id : ids) {
+        if (id != kNoSlot) {
+            m_slots[id].lastSeen = m_now;
+        }
+    }
+    if (ids[0] != kNoSlot) {
+        m_values[ids[0]] = value;
+    }
+
+    // All statistics of an instance come from one history, read once
+    HistoryStats stats = {};
+    bool haveStats = false;
+    for (std::size_t s = 1; s < kStatCount; s++) {
+        std::uint32_t id = ids[s];
+        if (id == kNoSlot) {
+            continue;
+        }
+        if (!haveStats) {
+            Slot& slot = m_slots[id];
+            if (!slot.history) {
+                bindHistory(slot, monitor);
+            }
+            if (!slot.history) {
+                continue;
+            }
+            stats = slot.history->getStats();
+            haveStats = true;
+        }
+        if (stats.count == 0) {
+            continue;
+        }
+        switch (static_cast<Stat>(s)) {
+            case Stat::Average:
+                m_values[id] = stats.average;
+                break;
+            case Stat::Minimum:
+                m_values[id] = stats.minimum;
+                break;
+            case Stat::Maximum:
+                m_values[id] = stats.maximum;
+                break;
+            case Stat::EWMA:
+                m_values[id] = stats.ewma;
+                break;
+            case Stat::Value:
+                break;
+        }
+    }
+}
+
+void AlertEngine::evaluate(const ResourceSnapshot& snapshot, const ResourceMonitor& monitor, std::vector<AlertEvent>& events) {
+    ScopedProbe probe(Probe::Alerts);
+    events.clear();
+    m_now = snapshot.timestamp != 0 ? snapshot.timestamp : MonitorClock::wallMillis();
+    std::fill(m_values.begin(), m_values.end(), kAbsent);
+
+    // Gather every metric some rule reads; instances missing from the
+    // snapshot keep NaN
+    auto used = [this](Metric metric) {
+        return m_metricUsed[static_cast<std::size_t>(metric)];
+    };
+    if (used(Metric::CPU)) {
+        observe(Metric::CPU, std::string(), snapshot.cpuUsage, monitor);
+    }
+    if (used(Metric::Core)) {
+        for (std::size_t i = 0; i < snapshot.coreUsage.size(); i++) {
+            observe(Metric::Core, std::to_string(i), snapshot.coreUsage[i], monitor);
+        }
+    }
+    if (used(Metric::Memory)) {
+        observe(Metric::Memory, std::string(), snapshot.memInfo.percent, monitor);
+    }
+    for (const auto& disk : snapshot.diskInfo) {
+        if (used(Metric::Disk)) {
+            observe(Metric::Disk, disk.mountpoint, disk.percent, monitor);
+        }
+        if (used(Metric::DiskRead)) {
+            observe(Metric::DiskRead, disk.mountpoint, disk.readBytesPerSec, monitor);
+        }
+        if (used(Metric::DiskWrite)) {
+            observe(Metric::DiskWrite, disk.mountpoint, disk.writeBytesPerSec, monitor);
+        }
+        if (used(Metric::DiskUtil)) {
+            observe(Metric::DiskUtil, disk.mountpoint, disk.ioUtilization, monitor);
+        }
+    }
+    if (used(Metric::NetRx) || used(Metric::NetTx)) {
+        for (const auto& interface : snapshot.networkInfo) {
+            std::string name(interface.name);
+            if (used(Metric::NetRx)) {
+                observe(Metric::NetRx, name, interface.rxBytesPerSec, monitor);
+            }
+            if (used(Metric::NetTx)) {
+                observe(Metric::NetTx, name, interface.txBytesPerSec, monitor);
+            }
+        }
+    }
+    const Metric pressureMetrics[kPressureResourceCount] = {
+        Metric::PressureCPU, Metric::PressureMemory, Metric::PressureIO
+    };
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        if (used(pressureMetrics[i]) && monitor.getPressureAvg10History(static_cast<PressureResource>(i))) {
+            observe(pressureMetrics[i], std::string(), snapshot.pressure[i].someAvg10, monitor);
+        }
+    }
+    if (used(Metric::CgroupCPU) || used(Metric::CgroupMemory)) {
+        // The whole table rather than the busiest cgroups of the snapshot,
+        // so a cgroup growing in memory while idle is still seen. Instances
+        // are full paths; CgroupInfo::path may be shortened.
+        monitor.getCgroups(m_cgroups, m_cgroupPaths);
+        for (std::size_t i = 0; i < m_cgroups.size(); i++) {
+            const CgroupInfo& cgroup = m_cgroups[i];
+            const std::string& path = m_cgroupPaths[i];
+            if (used(Metric::CgroupCPU)) {
+                observe(Metric::CgroupCPU, path, cgroup.cpuPercent, monitor, cgroup.leaf);
+            }
+            if (used(Metric::CgroupMemory)) {
+                observe(Metric::CgroupMemory, path, static_cast<double>(cgroup.memoryBytes), monitor, cgroup.leaf);
+            }
+        }
+    }
+
+    // One pass over the table. A row waits in pending until its condition
+    // has held for the duration, then fires until the clear threshold is
+    // passed. A missing instance resets its rows; a firing one resolves.
+    std::int64_t now = m_now;
+    auto emit = [&](std::size_t r, bool firing, double value) {
+        const Slot& slot = m_slots[m_rowSlot[r]];
+        events.push_back(AlertEvent{firing, std::isnan(value), resourceTypeOf(slot.metric),
+                                    m_rules[m_rowRule[r]].text + "|" + slot.instance,
+                                    describe(r, value * m_rowSign[r], firing, snapshot)});
+    };
+    std::size_t rows = m_rowSlot.size();
+    for (std::size_t r = 0; r < rows; r++) {
+        double value = m_values[m_rowSlot[r]] * m_rowSign[r];
+        if (std::isnan(value)) {
+            if (m_rowFiring[r]) {
+                m_rowFiring[r] = 0;
+                m_firingCount--;
+                emit(r, false, value);
+            }
+            m_rowPendingSince[r] = -1;
+            continue;
+        }
+        if (!m_rowFiring[r]) {
+            bool holds = m_rowStrict[r] ? value > m_rowThreshold[r] : value >= m_rowThreshold[r];
+            if (!holds) {
+                m_rowPendingSince[r] = -1;
+                continue;
+            }
+            if (m_rowPendingSince[r] < 0) {
+                m_rowPendingSince[r] = now;
+            }
+            if (now - m_rowPendingSince[r] >= m_rowForMs[r]) {
+                m_rowFiring[r] = 1;
+                m_firingCount++;
+                emit(r, true, value);
+            }
+        } else {
+            bool holds = m_rowStrict[r] ? value > m_rowClear[r] : value >= m_rowClear[r];
+            if (!holds) {
+                m_rowFiring[r] = 0;
+                m_firingCount--;
+                m_rowPendingSince[r] = -1;
+                emit(r, false, value);
+            }
+        }
+    }
+
+    // After the pass, so every instance of this snapshot counts as seen
+    // even after a long pause between snapshots
+    if (m_now - m_lastExpiry >= kExpiryIntervalMs) {
+        expireInstances();
+        m_lastExpiry = m_now;
+    }
+}
+
+void AlertEngine::expireInstances() {
+    std::int64_t horizon = m_now - kInstanceExpiryMs;
+
+    // Absent instances let go of their histories, which the monitor may have
+    // freed already; one that comes back binds its new history
+    for (Slot& slot : m_slots) {
+        if (slot.lastSeen < horizon) {
+            slot.history = nullptr;
+            slot.ownedHistory.reset();
+        }
+    }
+
+    bool expired = false;
+    for (auto& known : m_knownInstances) {
+        for (auto it = known.begin(); it != known.end();) {
+            if (it->second < horizon) {
+                it = known.erase(it);
+                expired = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (!expired) {
+        return;
+    }
+
+    // Drop the "*" rows of instances no longer known. Their rows resolved
+    // when the instance went away, so a firing one only remains for a
+    // cgroup that stopped being a leaf.
+    std::size_t kept = 0;
+    for (std::size_t r = 0; r < m_rowSlot.size(); r++) {
+        const Slot& slot = m_slots[m_rowSlot[r]];
+        if (m_rules[m_rowRule[r]].instance == "*" &&
+            m_knownInstances[static_cast<std::size_t>(slot.metric)].count(slot.instance) == 0) {
+            if (m_rowFiring[r]) {
+                m_firingCount--;
+            }
+            continue;
+        }
+        m_rowRule[kept] = m_rowRule[r];
+        m_rowSlot[kept] = m_rowSlot[r];
+        m_rowSign[kept] = m_rowSign[r];
+        m_rowThreshold[kept] = m_rowThreshold[r];
+        m_rowClear[kept] = m_rowClear[r];
+        m_rowStrict[kept] = m_rowStrict[r];
+        m_rowForMs[kept] = m_rowForMs[r];
+        m_rowPendingSince[kept] = m_rowPendingSince[r];
+        m_rowFiring[kept] = m_rowFiring[r];
+        kept++;
+    }
+    m_rowRule.resize(kept);
+    m_rowSlot.resize(kept);
+    m_rowSign.resize(kept);
+    m_rowThreshold.resize(kept);
+    m_rowClear.resize(kept);
+    m_rowStrict.resize(kept);
+    m_rowForMs.resize(kept);
+    m_rowPendingSince.resize(kept);
+    m_rowFiring.resize(kept);
+
+    // Then the slots no row reads, renumbering the rest
+    std::vector<std::uint32_t> remap(m_slots.size(), kNoSlot);
+    for (std::uint32_t slot : m_rowSlot) {
+        remap[slot] = 0;
+    }
+    std::uint32_t next = 0;
+    for (std::size_t s = 0; s < m_slots.size(); s++) {
+        if (remap[s] == kNoSlot) {
+            continue;
+        }
+        remap[s] = next;
+        if (next != s) {
+            m_slots[next] = std::move(m_slots[s]);
+        }
+        next++;
+    }
+    m_slots.resize(next);
+    m_values.resize(next);
+    for (std::uint32_t& slot : m_rowSlot) {
+        slot = remap[slot];
+    }
+    for (auto& index : m_slotIndex) {
+        index.clear();
+    }
+    for (std::uint32_t s = 0; s < next; s++) {
+        const Slot& slot = m_slots[s];
+        auto& index = m_slotIndex[static_cast<std::size_t>(slot.metric)];
+        auto it = index.find(slot.instance);
+        if (it == index.end()) {
+            std::array<std::uint32_t, kStatCount> none;
+            none.fill(kNoSlot);
+            it = index.emplace(slot.instance, none).first;
+        }
+        it->second[static_cast<std::size_t>(slot.stat)] = s;
+    }
+}
+
+std::string AlertEngine::describe(std::size_t row, double value, bool firing, const ResourceSnapshot& snapshot) const {
+    const Rule& rule = m_rules[m_rowRule[row]];
+    const Slot& slot = m_slots[m_rowSlot[row]];
+
+    // The messages of the built-in thresholds stay as they were
+    if (firing && slot.stat == Stat::Value && !rule.below) {
+        std::string percent = std::to_string(static_cast<int>(value)) + "%";
+        switch (slot.metric) {
+            case Metric::CPU: {
+                std::string message = "Высокая загрузка ЦП: " + percent;
+                if (!snapshot.topProcesses.empty()) {
+                    const ProcessInfo& top = snapshot.topProcesses.front();
+                    message += ", больше всех: " + std::string(top.name) + " (" + std::to_string(top.pid) + ", " +
+                               std::to_string(static_cast<int>(top.cpuPercent)) + "%)";
+                }
+                return message;
+            }
+            case Metric::Memory:
+                return "Высокое использование памяти: " + percent;
+            case Metric::Disk:
+                return "Высокое использование диска " + slot.instance + ": " + percent;
+            default:
+                break;
+        }
+    }
+
+    std::string label;
+    switch (slot.metric) {
+        case Metric::CPU:
+            label = "ЦП";
+            break;
+        case Metric::Core:
+            label = "Ядро " + slot.instance;
+            break;
+        case Metric::Memory:
+            label = "Память";
+            break;
+        case Metric::Disk:
+            label = "Диск " + slot.instance;
+            break;
+        case Metric::DiskRead:
+            label = "Чтение " + slot.instance;
+            break;
+        case Metric::DiskWrite:
+            label = "Запись " + slot.instance;
+            break;
+        case Metric::DiskUtil:
+            label = "Занятость диска " + slot.instance;
+            break;
+        case Metric::NetRx:
+            label = "Приём " + slot.instance;
+            break;
+        case Metric::NetTx:
+            label = "Передача " + slot.instance;
+            break;
+        case Metric::PressureCPU:
+            label = "Ожидание ЦП";
+            break;
+        case Metric::PressureMemory:
+            label = "Ожидание памяти";
+            break;
+        case Metric::PressureIO:
+            label = "Ожидание ввода-вывода";
+            break;
+        case Metric::CgroupCPU:
+            label = "ЦП группы " + slot.instance;
+            break;
+        case Metric::CgroupMemory:
+            label = "Память группы " + slot.instance;
+            break;
+    }
+    switch (slot.stat) {
+        case Stat::Average:
+            label += " (среднее)";
+            break;
+        case Stat::Minimum:
+            label += " (минимум)";
+            break;
+        case Stat::Maximum:
+            label += " (максимум)";
+            break;
+        case Stat::EWMA:
+            label += " (сглаженное)";
+            break;
+        case Stat::Value:
+            break;
+    }
+
+    char formatted[64];
+    switch (slot.metric) {
+        case Metric::DiskRead:
+        case Metric::DiskWrite:
+        case Metric::NetRx:
+        case Metric::NetTx:
+            std::snprintf(formatted, sizeof(formatted), "%.1f МБ/с", value / (1024.0 * 1024.0));
+            break;
+        case Metric::CgroupMemory:
+            std::snprintf(formatted, sizeof(formatted), "%.1f МБ", value / (1024.0 * 1024.0));
+            break;
+        default:
+            std::snprintf(formatted, sizeof(formatted), "%.1f%%", value);
+            break;
+    }
+    if (std::isnan(value)) {
+        return "Нет данных, оповещение снято: " + label + " (" + rule.text + ")";
+    }
+    std::string message = label + ": " + formatted + " (" + rule.text + ")";
+    return firing ? message : "В норме: " + message;
+}
+
+ResourceType AlertEngine::resourceTypeOf(Metric metric) {
+    switch (metric) {
+        case Metric::CPU:
+        case Metric::Core:
+        case Metric::PressureCPU:
+        case Metric::CgroupCPU:
+            return ResourceType::CPU;
+        case Metric::Memory:
+        case Metric::PressureMemory:
+        case Metric::CgroupMemory:
+            return ResourceType::Memory;
+        case Metric::Disk:
+        case Metric::DiskRead:
+        case Metric::DiskWrite:
+        case Metric::DiskUtil:
+        case Metric::PressureIO:
+            return ResourceType::Disk;
+        case Metric::NetRx:
+        case Metric::NetTx:
+            return ResourceType::Other;
+    }
+    return ResourceType::Other;
+}
+
+std::size_t AlertEngine::getRuleCount() const {
+    return m_rules.size();
+}
+
+std::size_t AlertEngine::getRowCount() const {
+    return m_rowSlot.size();
+}
+
+std::size_t AlertEngine::getFiringCount() const {
+    return m_firingCount;
+}
@@ -0,0 +1,192 @@
+#ifndef ALERT_ENGINE_H
+#define ALERT_ENGINE_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "resource_monitor.h"
+#include "resource_type.h"
+#include "settings.h"
+
+// A rule changing state: it has held for its duration, or it has cleared
+struct AlertEvent {
+    bool firing;                // false when the alert resolved
+    bool absent;                // Resolved because the instance disappeared
+    ResourceType resourceType;
+    std::string key;            // Rule and instance, stable while the rules stay the same
+    std::string message;
+};
+
+// Alert rules, compiled into a flat table and evaluated once per snapshot.
+//
+// One rule per line:
+//
+//   metric comparator threshold [for duration] [clear threshold]
+//
+//   cpu >= 90 for 30s clear 80
+//   avg(memory) > 85
+//   disk:* >= 95 clear 90
+//   net_rx:eth0 > 100M for 1m
+//
+// Metrics: cpu, core:N, memory, disk:MOUNT, disk_read:MOUNT,
+// disk_write:MOUNT, disk_util:MOUNT, net_rx:IF, net_tx:IF, psi_cpu,
+// psi_memory, psi_io, cgroup_cpu:PATH, cgroup_memory:PATH. An instance of
+// "*" applies the rule to every instance as it appears; for cgroups, to
+// every leaf cgroup, since inner ones include their children. Cgroup
+// metrics are read from the full cgroup table, not only the busiest ones.
+// avg(), min(), max() and ewma() read the incremental statistics of the
+// metric's 10-minute history instead of the current value.
+// Rates are bytes per second; numbers take K, M and G suffixes (1024).
+//
+// A rule fires once its condition has held for the duration, and resolves
+// only when the value no longer passes the clear threshold, which defaults
+// to the threshold itself. A firing rule whose instance disappears (an
+// unmounted disk, a removed interface or cgroup) resolves with an `absent`
+// event. Rows that "*" added for an instance gone for 10 minutes are
+// dropped, and added again if it comes back.
+// Every rule is evaluated on every snapshot; each distinct metric is read
+// once per snapshot however many rules use it.
+class AlertEngine {
+public:
+    AlertEngine();
+    ~AlertEngine();
+
+    AlertEngine(const AlertEngine&) = delete;
+    AlertEngine& operator=(const AlertEngine&) = delete;
+
+    // The rules for the CPU, memory and disk thresholds in the settings
+    static std::vector<std::string> builtInRules(const Settings& settings);
+
+    // The rule lines of a rules file, without comments and blank lines;
+    // none if it cannot be read
+    static std::vector<std::string> readRulesFile(const std::string& path);
+
+    // The built-in rules followed by the lines of the rules file, if any
+    static std::vector<std::string> loadRules(const Settings& settings);
+
+    // Replace the rule set; all state starts over. On a syntax error the
+    // previous rules are kept and `error` names the offending rule.
+    bool compile(const std::vector<std::string>& rules, std::string& error);
+
+    // Evaluate every rule against the snapshot. State changes are written
+    // to `events`, which is cleared first and keeps its storage.
+    void evaluate(const ResourceSnapshot& snapshot, const ResourceMonitor& monitor, std::vector<AlertEvent>& events);
+
+    std::size_t getRuleCount() const;
+
+    // Rules after expanding "*" over the instances seen so far
+    std::size_t getRowCount() const;
+    std::size_t getFiringCount() const;
+
+    // Parse a duration like "30s", "5m", "1h" or "500ms" into milliseconds
+    static bool parseDuration(const std::string& text, std::int64_t& milliseconds);
+
+private:
+    enum class Metric : std::uint8_t {
+        CPU,
+        Core,
+        Memory,
+        Disk,
+        DiskRead,
+        DiskWrite,
+        DiskUtil,
+        NetRx,
+        NetTx,
+        PressureCPU,
+        PressureMemory,
+        PressureIO,
+        CgroupCPU,
+        CgroupMemory
+    };
+    static constexpr std::size_t kMetricCount = 14;
+
+    enum class Stat : std::uint8_t {
+        Value,
+        Average,
+        Minimum,
+        Maximum,
+        EWMA
+    };
+    static constexpr std::size_t kStatCount = 5;
+    static constexpr std::uint32_t kNoSlot = 0xffffffff;
+
+    struct Rule {
+        std::string text;
+        Metric metric;
+        std::string instance;       // Empty for system-wide metrics, "*" for every instance
+        Stat stat;
+        bool below;                 // < or <=
+        bool strict;                // > or <
+        double threshold;
+        double clearThreshold;
+        std::int64_t forMs;
+    };
+
+    // One distinct metric value read per snapshot
+    struct Slot {
+        Metric metric;
+        Stat stat;
+        std::string instance;
+        const HistoryData* history;                 // For the statistics, nullptr if none yet
+        std::shared_ptr<HistoryData> ownedHistory;  // Keeps the history of a removed instance alive
+        std::int64_t lastSeen;                      // Snapshot time the instance was last present
+    };
+
+    std::vector<Rule> m_rules;
+    std::vector<Slot> m_slots;
+    std::vector<double> m_values;   // By slot, NaN when the instance is absent
+
+    // Slots of each instance by Stat, kNoSlot where no rule reads it
+    std::unordered_map<std::string, std::array<std::uint32_t, kStatCount>> m_slotIndex[kMetricCount];
+
+    // Rules with "*" per metric, and whether any rule uses the metric at all
+    std::vector<std::uint32_t> m_wildcardRules[kMetricCount];
+    bool m_metricUsed[kMetricCount];
+
+    // Instances already expanded for the "*" rules, per metric, with the
+    // snapshot time each was last present
+    std::unordered_map<std::string, std::int64_t> m_knownInstances[kMetricCount];
+
+    // The flat evaluation table, one entry per rule and instance. Values of
+    // "below" rows are negated at compile time, so every row tests
+    // value > threshold (or >=).
+    std::vector<std::uint32_t> m_rowRule;
+    std::vector<std::uint32_t> m_rowSlot;
+    std::vector<double> m_rowSign;
+    std::vector<double> m_rowThreshold;
+    std::vector<double> m_rowClear;
+    std::vector<std::uint8_t> m_rowStrict;
+    std::vector<std::int64_t> m_rowForMs;
+    std::vector<std::int64_t> m_rowPendingSince;    // -1 while the condition does not hold
+    std::vector<std::uint8_t> m_rowFiring;
+    std::size_t m_firingCount;
+
+    std::int64_t m_now;                 // Time of the snapshot being evaluated
+    std::int64_t m_lastExpiry;          // Last expireInstances() pass
+    std::vector<CgroupInfo> m_cgroups;  // Full cgroup table, reused between snapshots
+    std::vector<std::string> m_cgroupPaths;
+
+    static bool parseRule(const std::string& text, Rule& rule, std::string& error);
+
+    std::uint32_t slotFor(Metric metric, Stat stat, const std::string& instance);
+    void addRow(std::uint32_t rule, std::uint32_t slot);
+
+    // See a metric instance in this snapshot: expand the "*" rules for it
+    // the first time (unless `wildcard` is false), then store its value and
+    // statistics
+    void observe(Metric metric, const std::string& instance, double value, const ResourceMonitor& monitor,
+                 bool wildcard = true);
+    void bindHistory(Slot& slot, const ResourceMonitor& monitor);
+
+    // Drop the "*" rows of instances gone for a while, and the slots no row
+    // reads any more; release the histories of absent instances
+    void expireInstances();
+
+    std::string describe(std::size_t row, double value, bool firing, const ResourceSnapshot& snapshot) const;
+    static ResourceType resourceTypeOf(Metric metric);
+};
+
+#endif // ALERT_ENGINE_H
@@ -0,0 +1,422 @@
+#include "cgroup_collector.h"
+#include "proc_reader.h"
+#include "monitor_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+// A new walk starts this long after the previous one completed
+static const std::chrono::seconds kWalkInterval(5);
+
+// Samples per cgroup history: 5 minutes at 1 second interval. Kept short,
+// as a busy host has thousands of cgroups.
+static const std::size_t kHistorySize = 300;
+
+// A control file that does not exist, e.g. memory.current with the memory
+// controller disabled for the subtree; not retried until the cgroup is recreated
+static const int kMissingFd = -2;
+
+CgroupCollector::CgroupCollector(const std::string& root)
+    : m_rootPath(root),
+      m_rootFd(-1),
+      m_nextId(1),
+      m_buffer(64 * 1024),
+      m_generation(0),
+      m_cachedFds(0),
+      m_fdBudget(0)
+{
+    // io.stat has one line per device; 64 KB is plenty
+}
+
+CgroupCollector::~CgroupCollector() {
+    close();
+}
+
+bool CgroupCollector::open() {
+    close();
+
+    m_rootFd = ::open(m_rootPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (m_rootFd < 0) {
+        return false;
+    }
+    // Only the v2 root has cgroup.controllers
+    if (faccessat(m_rootFd, "cgroup.controllers", F_OK, 0) != 0) {
+        close();
+        return false;
+    }
+
+    // Share the fd limit with the process collector, which takes half
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        m_fdBudget = limit.rlim_cur > 512 ? (limit.rlim_cur - 256) / 4 : 0;
+    } else {
+        m_fdBudget = 32768;
+    }
+
+    // The first update starts a walk right away
+    m_lastWalk = MonitorClock::now() - kWalkInterval;
+    return true;
+}
+
+void CgroupCollector::close() {
+    for (auto& pair : m_entries) {
+        closeEntry(pair.second);
+    }
+    m_entries.clear();
+    m_paths.clear();
+    m_walkQueue.clear();
+    m_readCursor.clear();
+    if (m_rootFd >= 0) {
+        ::close(m_rootFd);
+        m_rootFd = -1;
+    }
+}
+
+bool CgroupCollector::isOpen() const {
+    return m_rootFd >= 0;
+}
+
+void CgroupCollector::cacheFd(int& slot, int fd) {
+    if (m_cachedFds < m_fdBudget) {
+        slot = fd;
+        m_cachedFds++;
+    } else {
+        ::close(fd);
+        slot = -1;
+    }
+}
+
+void CgroupCollector::closeEntry(Entry& entry) {
+    for (int* fd : {&entry.dirFd, &entry.cpuFd, &entry.memoryFd, &entry.ioFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            m_cachedFds--;
+        }
+        *fd = -1;
+    }
+}
+
+void CgroupCollector::resetEntry(Entry& entry, int parentFd, const char* name, ino_t inode) {
+    // Also forgets the files marked missing, the new cgroup may have them
+    closeEntry(entry);
+    int fd = openat(parentFd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        cacheFd(entry.dirFd, fd);
+    }
+    entry.inode = inode;
+    entry.hasPrevious = false;
+    entry.info.cpuPercent = 0.0;
+    entry.info.memoryBytes = 0;
+    entry.info.readBytesPerSec = 0.0;
+    entry.info.writeBytesPerSec = 0.0;
+
+    // A graph may still hold the histories of the removed cgroup
+    entry.cpuHistory = std::make_shared<HistoryData>(kHistorySize);
+    entry.memoryHistory = std::make_shared<HistoryData>(kHistorySize);
+}
+
+bool CgroupCollector::update(std::chrono::microseconds budget) {
+    if (m_rootFd < 0) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + budget;
+
+    // Up to half of the budget goes to the walk, so reads always progress
+    if (m_walkQueue.empty() && MonitorClock::now() - m_lastWalk >= kWalkInterval) {
+        m_generation++;
+        m_walkQueue.push_back(std::string());
+    }
+    auto walkDeadline = start + budget / 2;
+    while (!m_walkQueue.empty() && std::chrono::steady_clock::now() < walkDeadline) {
+        std::string path = std::move(m_walkQueue.back());
+        m_walkQueue.pop_back();
+        walkDirectory(path);
+        if (m_walkQueue.empty()) {
+            finishWalk();
+        }
+    }
+
+    // Read each cgroup at most once, resuming after the last one read
+    std::size_t remaining = m_entries.size();
+    auto it = m_entries.upper_bound(m_readCursor);
+    while (remaining > 0 && std::chrono::steady_clock::now() < deadline) {
+        if (it == m_entries.end()) {
+            it = m_entries.begin();
+        }
+        readCgroup(it->first, it->second);
+        m_readCursor = it->first;
+        ++it;
+        remaining--;
+    }
+    return true;
+}
+
+int CgroupCollector::openDirectory(const std::string& path) {
+    if (path.empty()) {
+        return openat(m_rootFd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    auto it = m_entries.find(path);
+    if (it != m_entries.end() && it->second.dirFd >= 0) {
+        return openat(it->second.dirFd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    return openat(m_rootFd, path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+void CgroupCollector::walkDirectory(const std::string& path) {
+    // A fresh fd per listing, so the cached one keeps no directory offset
+    int fd = openDirectory(path);
+    if (fd < 0) {
+        return;
+    }
+    DIR* dir = fdopendir(fd);
+    if (!dir) {
+        ::close(fd);
+        return;
+    }
+
+    bool hasChildren = false;
+    while (struct dirent* de = readdir(dir)) {
+        if (de->d_type != DT_DIR || de->d_name[0] == '.') {
+            continue;
+        }
+        struct stat st;
+        if (fstatat(dirfd(dir), de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            continue;   // Removed while listing
+        }
+        hasChildren = true;
+        std::string child = path.empty() ? std::string(de->d_name) : path + "/" + de->d_name;
+
+        auto it = m_entries.find(child);
+        if (it == m_entries.end()) {
+            Entry entry{};
+            entry.dirFd = -1;
+            entry.cpuFd = -1;
+            entry.memoryFd = -1;
+            entry.ioFd = -1;
+            entry.info.id = m_nextId++;
+            entry.info.leaf = true;
+            std::size_t skip = child.size() >= sizeof(entry.info.path) ? child.size() - sizeof(entry.info.path) + 1 : 0;
+            std::memcpy(entry.info.path, child.c_str() + skip, child.size() - skip + 1);
+            resetEntry(entry, dirfd(dir), de->d_name, st.st_ino);
+            it = m_entries.emplace(child, std::move(entry)).first;
+            m_paths[it->second.info.id] = &it->first;
+        } else if (it->second.inode != st.st_ino) {
+            // Removed and created again since the last walk: the cached fds
+            // still point at the old, dead cgroup
+            resetEntry(it->second, dirfd(dir), de->d_name, st.st_ino);
+        }
+        it->second.generation = m_generation;
+        m_walkQueue.push_back(child);
+    }
+    closedir(dir);
+
+    if (!path.empty()) {
+        auto it = m_entries.find(path);
+        if (it != m_entries.end()) {
+            it->second.info.leaf = !hasChildren;
+        }
+    }
+}
+
+void CgroupCollector::finishWalk() {
+    // Forget cgroups that were removed
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.generation != m_generation) {
+            closeEntry(it->second);
+            m_paths.erase(it->second.info.id);
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_lastWalk = MonitorClock::now();
+}
+
+bool CgroupCollector::readFile(const std::string& path, Entry& entry, const char* name, int& fd, std::size_t& length) {
+    length = 0;
+    if (fd == kMissingFd) {
+        return true;
+    }
+
+    bool cached = fd >= 0;
+    int file = fd;
+    if (!cached) {
+        file = entry.dirFd >= 0 ? openat(entry.dirFd, name, O_RDONLY | O_CLOEXEC)
+                                : openat(m_rootFd, (path + "/" + name).c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0) {
+            if (errno == ENOENT) {
+                fd = kMissingFd;
+                return true;
+            }
+            return false;
+        }
+    }
+
+    ssize_t n = pread(file, m_buffer.data(), m_buffer.size() - 1, 0);
+    if (!cached) {
+        if (n >= 0) {
+            cacheFd(fd, file);
+        } else {
+            ::close(file);
+        }
+    }
+    if (n < 0) {
+        return false;
+    }
+    m_buffer[n] = '\0';
+    length = static_cast<std::size_t>(n);
+    return true;
+}
+
+bool CgroupCollector::readCgroup(const std::string& path, Entry& entry) {
+    using namespace ProcParse;
+
+    auto now = MonitorClock::now();
+
+    // "usage_usec 123\nuser_usec ...". Every cgroup has cpu.stat, so an empty
+    // one is as much a failed read as an error.
+    unsigned long long usageUsec = 0;
+    std::size_t n = 0;
+    bool ok = readFile(path, entry, "cpu.stat", entry.cpuFd, n) &&
+              startsWith(m_buffer.data(), m_buffer.data() + n, "usage_usec ", 11);
+    if (ok) {
+        parseUnsigned(m_buffer.data() + 11, m_buffer.data() + n, usageUsec);
+    }
+
+    unsigned long long memory = 0;
+    ok = ok && readFile(path, entry, "memory.current", entry.memoryFd, n);
+    if (ok && n > 0) {
+        parseUnsigned(m_buffer.data(), m_buffer.data() + n, memory);
+    }
+
+    // "8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0", one line per device
+    unsigned long long readBytes = 0;
+    unsigned long long writeBytes = 0;
+    ok = ok && readFile(path, entry, "io.stat", entry.ioFd, n);
+    const char* end = m_buffer.data() + n;
+    for (const char* p = m_buffer.data(); ok && p < end; p = nextLine(p, end)) {
+        const char* q = skipToken(p, end);
+        unsigned long long value;
+        q = skipSpaces(q, end);
+        if (startsWith(q, end, "rbytes=", 7)) {
+            q = parseUnsigned(q + 7, end, value);
+            readBytes += value;
+            q = skipSpaces(q, end);
+        }
+        if (startsWith(q, end, "wbytes=", 7)) {
+            parseUnsigned(q + 7, end, value);
+            writeBytes += value;
+        }
+    }
+
+    // Zeros from a failed read would make the next delta a reset or a
+    // spike; leave the cgroup without a sample until a read succeeds
+    if (!ok) {
+        entry.hasPrevious = false;
+        entry.info.cpuPercent = 0.0;
+        entry.info.readBytesPerSec = 0.0;
+        entry.info.writeBytesPerSec = 0.0;
+        return false;
+    }
+
+    double elapsed = std::chrono::duration<double>(now - entry.prevRead).count();
+    if (entry.hasPrevious && elapsed > 0.0) {
+        entry.info.cpuPercent = 100.0 * counterDelta(usageUsec, entry.prevUsageUsec) / (elapsed * 1e6);
+        entry.info.readBytesPerSec = counterDelta(readBytes, entry.prevReadBytes) / elapsed;
+        entry.info.writeBytesPerSec = counterDelta(writeBytes, entry.prevWriteBytes) / elapsed;
+    }
+    entry.info.memoryBytes = memory;
+    entry.prevUsageUsec = usageUsec;
+    entry.prevReadBytes = readBytes;
+    entry.prevWriteBytes = writeBytes;
+    entry.prevRead = now;
+
+    if (entry.hasPrevious) {
+        entry.cpuHistory->addSample(entry.info.cpuPercent);
+        entry.memoryHistory->addSample(static_cast<double>(memory));
+    }
+    entry.hasPrevious = true;
+    return true;
+}
+
+std::size_t CgroupCollector::getCgroupCount() const {
+    return m_entries.size();
+}
+
+std::shared_ptr<HistoryData> CgroupCollector::getCPUHistory(const std::string& path) const {
+    auto it = m_entries.find(path);
+    return it != m_entries.end() ? it->second.cpuHistory : nullptr;
+}
+
+std::shared_ptr<HistoryData> CgroupCollector::getCPUHistory(std::uint64_t id) const {
+    auto it = m_paths.find(id);
+    return it != m_paths.end() ? getCPUHistory(*it->second) : nullptr;
+}
+
+std::shared_ptr<HistoryData> CgroupCollector::getMemoryHistory(const std::string& path) const {
+    auto it = m_entries.find(path);
+    return it != m_entries.end() ? it->second.memoryHistory : nullptr;
+}
+
+template <typename Less>
+void CgroupCollector::selectTop(std::size_t n, std::vector<CgroupInfo>& out, Less less) const {
+    out.clear();
+    if (n == 0) {
+        return;
+    }
+
+    // Min-heap of the n best so far: its top is the one to beat
+    auto greater = [&less](const CgroupInfo& a, const CgroupInfo& b) { return less(b, a); };
+    for (const auto& pair : m_entries) {
+        if (!pair.second.info.leaf || !pair.second.hasPrevious) {
+            continue;
+        }
+        const CgroupInfo& info = pair.second.info;
+        if (out.size() < n) {
+            out.push_back(info);
+            std::push_heap(out.begin(), out.end(), greater);
+        } else if (less(out.front(), info)) {
+            std::pop_heap(out.begin(), out.end(), greater);
+            out.back() = info;
+            std::push_heap(out.begin(), out.end(), greater);
+        }
+    }
+    std::sort_heap(out.begin(), out.end(), greater);
+}
+
+void CgroupCollector::getAll(std::vector<CgroupInfo>& out, std::vector<std::string>& paths) const {
+    // Strings are assigned rather than rebuilt, so `paths` keeps its storage
+    out.clear();
+    std::size_t count = 0;
+    for (const auto& pair : m_entries) {
+        if (pair.second.hasPrevious) {
+            out.push_back(pair.second.info);
+            if (count < paths.size()) {
+                paths[count] = pair.first;
+            } else {
+                paths.push_back(pair.first);
+            }
+            count++;
+        }
+    }
+    paths.resize(count);
+}
+
+void CgroupCollector::topByCPU(std::size_t n, std::vector<CgroupInfo>& out) const {
+    selectTop(n, out, [](const CgroupInfo& a, const CgroupInfo& b) {
+        return a.cpuPercent < b.cpuPercent || (a.cpuPercent == b.cpuPercent && a.memoryBytes < b.memoryBytes);
+    });
+}
+
+void CgroupCollector::topByMemory(std::size_t n, std::vector<CgroupInfo>& out) const {
+    selectTop(n, out, [](const CgroupInfo& a, const CgroupInfo& b) {
+        return a.memoryBytes < b.memoryBytes;
+    });
+}
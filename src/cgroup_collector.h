@@ -0,0 +1,129 @@
+#ifndef CGROUP_COLLECTOR_H
+#define CGROUP_COLLECTOR_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+#include "history_data.h"
+
+// One cgroup as of its last read. Fixed size, so vectors of it can be
+// copied between threads without allocating.
+struct CgroupInfo {
+    std::uint64_t id;               // Unique while the cgroup exists; the key for lookups
+    char path[128];                 // Relative to the cgroup root, for display; long paths keep their tail
+    double cpuPercent;              // Of one CPU, as top shows it
+    unsigned long long memoryBytes;
+    double readBytesPerSec;
+    double writeBytesPerSec;
+    bool leaf;                      // No child cgroups as of the last walk
+};
+
+// Per-cgroup accounting from the cgroup v2 hierarchy.
+//
+// Every directory below the root is a cgroup; its directory fd and the fds
+// of cpu.stat, memory.current and io.stat are opened once with openat() and
+// re-read with pread(). The number of cached fds is capped by RLIMIT_NOFILE;
+// cgroups beyond the cap open and close their files on every read.
+//
+// Each update() gets a fixed time budget. The tree walk and the reads both
+// continue where the previous update stopped, so with thousands of cgroups
+// a full pass takes several updates; an update overruns its budget by at
+// most one directory listing.
+// Rates use the time since each cgroup's own previous read, so partial
+// passes do not skew them. Cgroups not seen by a completed walk are dropped.
+// A read that fails (a removed cgroup answers ENODEV on its cached fds)
+// gives no sample, and the next read starts the deltas over. A directory
+// with a new inode is a cgroup recreated under the same path; the walk
+// drops its cached fds and starts it over as well.
+class CgroupCollector {
+public:
+    explicit CgroupCollector(const std::string& root = "/sys/fs/cgroup");
+    ~CgroupCollector();
+
+    CgroupCollector(const CgroupCollector&) = delete;
+    CgroupCollector& operator=(const CgroupCollector&) = delete;
+
+    // Fails unless the root is a cgroup v2 hierarchy
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    // Walk and read for at most `budget`
+    bool update(std::chrono::microseconds budget = std::chrono::milliseconds(5));
+
+    // Number of cgroups known
+    std::size_t getCgroupCount() const;
+
+    // The n busiest (or largest) leaf cgroups, in descending order. Inner
+    // cgroups are left out since they include their children.
+    void topByCPU(std::size_t n, std::vector<CgroupInfo>& out) const;
+    void topByMemory(std::size_t n, std::vector<CgroupInfo>& out) const;
+
+    // Every cgroup with a sample, inner ones included, in path order.
+    // `paths` gets the full path of each, which CgroupInfo::path may shorten.
+    void getAll(std::vector<CgroupInfo>& out, std::vector<std::string>& paths) const;
+
+    // CPU% and memory of a cgroup by full path or by id, one sample per
+    // read. Shared, so a graph can keep showing a cgroup that has just
+    // been removed.
+    std::shared_ptr<HistoryData> getCPUHistory(const std::string& path) const;
+    std::shared_ptr<HistoryData> getCPUHistory(std::uint64_t id) const;
+    std::shared_ptr<HistoryData> getMemoryHistory(const std::string& path) const;
+
+private:
+    struct Entry {
+        int dirFd;                      // Cached fds, -1 if over the fd budget
+        int cpuFd;
+        int memoryFd;
+        int ioFd;
+        ino_t inode;                    // Of the directory, identifies the cgroup
+        std::size_t generation;         // Walk that last saw the cgroup
+        unsigned long long prevUsageUsec;
+        unsigned long long prevReadBytes;
+        unsigned long long prevWriteBytes;
+        std::chrono::steady_clock::time_point prevRead;
+        bool hasPrevious;
+        CgroupInfo info;
+        std::shared_ptr<HistoryData> cpuHistory;
+        std::shared_ptr<HistoryData> memoryHistory;
+    };
+
+    std::string m_rootPath;
+    int m_rootFd;
+    std::map<std::string, Entry> m_entries;     // Ordered, so the read cursor survives inserts
+    std::unordered_map<std::uint64_t, const std::string*> m_paths;  // m_entries keys by CgroupInfo::id
+    std::uint64_t m_nextId;
+    std::vector<std::string> m_walkQueue;       // Directories still to list in this walk
+    std::string m_readCursor;                   // Last cgroup read, reads resume after it
+    std::vector<char> m_buffer;
+    std::size_t m_generation;
+    std::size_t m_cachedFds;
+    std::size_t m_fdBudget;
+    std::chrono::steady_clock::time_point m_lastWalk;
+
+    // List one directory, adding the cgroups below it to the walk
+    void walkDirectory(const std::string& path);
+    void finishWalk();
+
+    bool readCgroup(const std::string& path, Entry& entry);
+
+    // Read a control file into m_buffer through the cached fd, or a temporary
+    // one. A file the cgroup does not have reads as empty; false on errors.
+    bool readFile(const std::string& path, Entry& entry, const char* name, int& fd, std::size_t& length);
+
+    int openDirectory(const std::string& path);
+    void cacheFd(int& slot, int fd);
+    void closeEntry(Entry& entry);
+    void resetEntry(Entry& entry, int parentFd, const char* name, ino_t inode);
+
+    template <typename Less>
+    void selectTop(std::size_t n, std::vector<CgroupInfo>& out, Less less) const;
+};
+
+#endif // CGROUP_COLLECTOR_H
@@ -0,0 +1,96 @@
+#include "compressed_history.h"
+#include <cmath>
+#include <limits>
+
+CompressedHistory::CompressedHistory(std::size_t capacity, std::size_t blockSamples, double quantum)
+    : m_capacity(capacity),
+      m_blockSamples(blockSamples > 0 ? blockSamples : 1),
+      m_quantum(quantum),
+      m_size(0)
+{
+}
+
+void CompressedHistory::addSample(std::int64_t timestamp, double value) {
+    if (m_quantum > 0.0) {
+        value = std::round(value / m_quantum) * m_quantum;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_blocks.empty() || m_blocks.back().size() >= m_blockSamples) {
+        m_blocks.push_back(std::move(m_spare));
+        m_blocks.back().clear();
+        m_spare = GorillaBlock();
+    }
+    m_blocks.back().append(timestamp, value);
+    m_size++;
+
+    // Drop the oldest block once the rest still covers the capacity
+    while (m_blocks.size() > 1 && m_size - m_blocks.front().size() >= m_capacity) {
+        m_size -= m_blocks.front().size();
+        m_spare = std::move(m_blocks.front());
+        m_blocks.pop_front();
+    }
+}
+
+std::size_t CompressedHistory::getSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size < m_capacity ? m_size : m_capacity;
+}
+
+std::size_t CompressedHistory::getCapacity() const {
+    return m_capacity;
+}
+
+std::size_t CompressedHistory::getByteSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::size_t bytes = 0;
+    for (const GorillaBlock& block : m_blocks) {
+        bytes += block.byteSize();
+    }
+    return bytes;
+}
+
+HistoryStats CompressedHistory::getStats() const {
+    HistoryStats stats{};
+    stats.minimum = std::numeric_limits<double>::max();
+    stats.maximum = std::numeric_limits<double>::lowest();
+
+    // Welford's update keeps the variance stable over long histories
+    double mean = 0.0;
+    double m2 = 0.0;
+    double ewma = 0.0;
+    std::size_t count = 0;
+    forEachLast(m_capacity, [&](std::int64_t, double value) {
+        if (std::isnan(value)) {
+            return;
+        }
+        count++;
+        double delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+        ewma = count == 1 ? value : ewma + 0.1 * (value - ewma);
+        if (value < stats.minimum) {
+            stats.minimum = value;
+        }
+        if (value > stats.maximum) {
+            stats.maximum = value;
+        }
+    });
+
+    if (count == 0) {
+        return HistoryStats{};
+    }
+    stats.count = count;
+    stats.average = mean;
+    stats.variance = m2 / count;
+    stats.stddev = std::sqrt(stats.variance);
+    stats.ewma = ewma;
+    return stats;
+}
+
+void CompressedHistory::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_blocks.clear();
+    m_size = 0;
+}
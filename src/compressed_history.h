@@ -0,0 +1,87 @@
+#ifndef COMPRESSED_HISTORY_H
+#define COMPRESSED_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include "gorilla.h"
+#include "history_data.h"
+
+// Long raw history kept as a chain of Gorilla-compressed blocks.
+//
+// Samples are appended to the newest block; once it holds blockSamples it is
+// sealed and a new one is started. Whole blocks are dropped from the front
+// when the oldest one is no longer needed for the capacity, so between
+// capacity and capacity + blockSamples samples are retained.
+//
+// Readers decode on the fly with forEachLast() and never see a decoded copy.
+// Values can be rounded to a multiple of `quantum` before encoding; a power
+// of two leaves trailing zero bits in every value and compresses far better
+// (1/1024 is well below what a percentage graph can show). 0 keeps values
+// exact.
+class CompressedHistory {
+public:
+    CompressedHistory(std::size_t capacity, std::size_t blockSamples = 512, double quantum = 0.0);
+
+    // Append a sample (single writer thread)
+    void addSample(std::int64_t timestamp, double value);
+
+    // Number of samples kept
+    std::size_t getSize() const;
+    std::size_t getCapacity() const;
+
+    // Encoded size of all blocks, in bytes
+    std::size_t getByteSize() const;
+
+    // Decode the newest `count` samples, oldest first, calling
+    // fn(timestamp, value) for each one
+    template <typename Fn>
+    void forEachLast(std::size_t count, Fn fn) const;
+
+    // Statistics over all kept samples except gaps (NaN), computed with one
+    // streaming pass
+    HistoryStats getStats() const;
+
+    // Clear all samples
+    void clear();
+
+private:
+    mutable std::mutex m_mutex;         // Writer vs. decoding readers
+    std::deque<GorillaBlock> m_blocks;  // Oldest first, the back one is open
+    GorillaBlock m_spare;               // Storage of the last dropped block, reused
+    std::size_t m_capacity;
+    std::size_t m_blockSamples;
+    double m_quantum;
+    std::size_t m_size;
+};
+
+template <typename Fn>
+void CompressedHistory::forEachLast(std::size_t count, Fn fn) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Skip whole blocks that lie entirely before the requested range. The
+    // surplus of the oldest block beyond the capacity is never shown.
+    std::size_t kept = m_size < m_capacity ? m_size : m_capacity;
+    std::size_t skip = m_size - (count < kept ? count : kept);
+    auto block = m_blocks.begin();
+    while (block != m_blocks.end() && skip >= block->size()) {
+        skip -= block->size();
+        ++block;
+    }
+
+    std::int64_t timestamp;
+    double value;
+    for (; block != m_blocks.end(); ++block) {
+        GorillaDecoder decoder(*block);
+        while (decoder.next(timestamp, value)) {
+            if (skip > 0) {
+                skip--;
+                continue;
+            }
+            fn(timestamp, value);
+        }
+    }
+}
+
+#endif // COMPRESSED_HISTORY_H
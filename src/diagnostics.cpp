@@ -0,0 +1,224 @@
+#include "diagnostics.h"
+#include <cstdlib>
+#include <ctime>
+#include <new>
+
+// Allocations made by the current thread through the C++ operators below
+static thread_local std::uint64_t t_allocations = 0;
+
+void* operator new(std::size_t size) {
+    t_allocations++;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    t_allocations++;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+LatencyHistogram::LatencyHistogram()
+    : m_sumNs(0),
+      m_maxNs(0)
+{
+    for (auto& count : m_counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration) {
+    std::uint64_t ns = duration.count() > 0 ? static_cast<std::uint64_t>(duration.count()) : 0;
+    std::uint64_t us = ns / 1000;
+
+    // Values in [2^(k-1), 2^k) us go to bucket k
+    std::size_t bucket = us == 0 ? 0 : 64 - __builtin_clzll(us);
+    if (bucket >= kBucketCount) {
+        bucket = kBucketCount - 1;
+    }
+    m_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(ns, std::memory_order_relaxed);
+
+    std::uint64_t max = m_maxNs.load(std::memory_order_relaxed);
+    while (ns > max && !m_maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        // max was reloaded
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.count = 0;
+    for (std::size_t i = 0; i < kBucketCount; i++) {
+        snapshot.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.counts[i];
+    }
+    snapshot.sumNs = m_sumNs.load(std::memory_order_relaxed);
+    snapshot.maxNs = m_maxNs.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+std::uint64_t LatencyHistogram::bucketBoundNs(std::size_t bucket) {
+    return (std::uint64_t(1) << bucket) * 1000;
+}
+
+std::uint64_t LatencyHistogram::Snapshot::percentileNs(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    std::uint64_t rank = static_cast<std::uint64_t>(q * count);
+    if (rank >= count) {
+        rank = count - 1;
+    }
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i + 1 < kBucketCount; i++) {
+        seen += counts[i];
+        if (seen > rank) {
+            // The bucket bound overestimates; the true maximum is tighter
+            std::uint64_t bound = bucketBoundNs(i);
+            return bound < maxNs ? bound : maxNs;
+        }
+    }
+    return maxNs;
+}
+
+std::uint64_t LatencyHistogram::Snapshot::meanNs() const {
+    return count ? sumNs / count : 0;
+}
+
+struct ProbeState {
+    LatencyHistogram latency;
+    std::atomic<std::uint64_t> lastAllocations{0};
+    std::atomic<std::uint64_t> maxAllocations{0};
+};
+
+static ProbeState s_probes[kProbeCount];
+
+// Process CPU time at the previous updateProcessCPU(), sampling thread only
+static std::chrono::nanoseconds s_lastCPUTime{0};
+static std::chrono::steady_clock::time_point s_lastCPUCheck;
+static std::atomic<double> s_processCPUPercent{0.0};
+
+static std::chrono::nanoseconds processCPUTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+}
+
+void Diagnostics::record(Probe probe, std::chrono::nanoseconds duration, std::uint64_t allocations) {
+    ProbeState& state = s_probes[static_cast<std::size_t>(probe)];
+    state.latency.record(duration);
+    state.lastAllocations.store(allocations, std::memory_order_relaxed);
+    if (allocations > state.maxAllocations.load(std::memory_order_relaxed)) {
+        state.maxAllocations.store(allocations, std::memory_order_relaxed);
+    }
+}
+
+ProbeStats Diagnostics::stats(Probe probe) {
+    const ProbeState& state = s_probes[static_cast<std::size_t>(probe)];
+    ProbeStats stats;
+    stats.latency = state.latency.snapshot();
+    stats.lastAllocations = state.lastAllocations.load(std::memory_order_relaxed);
+    stats.maxAllocations = state.maxAllocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+const char* Diagnostics::probeName(Probe probe) {
+    switch (probe) {
+        case Probe::Sample:
+            return "sample";
+        case Probe::CPUStats:
+            return "cpu_stats";
+        case Probe::MemoryInfo:
+            return "memory_info";
+        case Probe::DiskInfo:
+            return "disk_info";
+        case Probe::DiskIO:
+            return "disk_io";
+        case Probe::Processes:
+            return "processes";
+        case Probe::Cgroups:
+            return "cgroups";
+        case Probe::Pressure:
+            return "pressure";
+        case Probe::Network:
+            return "network";
+        case Probe::MetricsRender:
+            return "metrics_render";
+        case Probe::GraphDraw:
+            return "graph_draw";
+        case Probe::HeatmapDraw:
+            return "heatmap_draw";
+        case Probe::UpdateUI:
+            return "update_ui";
+        case Probe::Alerts:
+            return "alerts";
+    }
+    return "";
+}
+
+std::uint64_t Diagnostics::threadAllocations() {
+    return t_allocations;
+}
+
+void Diagnostics::updateProcessCPU() {
+    auto cpuTime = processCPUTime();
+    auto now = std::chrono::steady_clock::now();
+    if (s_lastCPUCheck.time_since_epoch().count() != 0) {
+        auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(now - s_lastCPUCheck);
+        if (wall.count() > 0) {
+            s_processCPUPercent.store(100.0 * (cpuTime - s_lastCPUTime).count() / wall.count(),
+                                      std::memory_order_relaxed);
+        }
+    }
+    s_lastCPUTime = cpuTime;
+    s_lastCPUCheck = now;
+}
+
+double Diagnostics::processCPUPercent() {
+    return s_processCPUPercent.load(std::memory_order_relaxed);
+}
+
+ScopedProbe::ScopedProbe(Probe probe)
+    : m_probe(probe),
+      m_start(std::chrono::steady_clock::now()),
+      m_startAllocations(t_allocations)
+{
+}
+
+ScopedProbe::~ScopedProbe() {
+    Diagnostics::record(m_probe, std::chrono::steady_clock::now() - m_start, t_allocations - m_startAllocations);
+}
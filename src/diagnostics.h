@@ -0,0 +1,102 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// What the monitor times about itself
+enum class Probe {
+    Sample,             // One whole ResourceMonitor::sample()
+    CPUStats,
+    MemoryInfo,
+    DiskInfo,
+    DiskIO,
+    Processes,
+    Cgroups,
+    Pressure,
+    Network,
+    MetricsRender,
+    GraphDraw,          // Any ResourceGraph::draw()
+    HeatmapDraw,
+    UpdateUI,
+    Alerts              // One AlertEngine::evaluate()
+};
+constexpr std::size_t kProbeCount = 14;
+
+// Latency histogram with fixed power-of-two buckets: bucket i counts
+// durations below 2^i us, the last one everything longer. Recording is a
+// few relaxed atomic adds, so any thread may record while another reads.
+class LatencyHistogram {
+public:
+    static constexpr std::size_t kBucketCount = 24;    // Up to 4.2 s, then overflow
+
+    struct Snapshot {
+        std::uint64_t counts[kBucketCount];
+        std::uint64_t count;
+        std::uint64_t sumNs;
+        std::uint64_t maxNs;
+
+        // Upper bound of the bucket holding the q quantile, in ns
+        std::uint64_t percentileNs(double q) const;
+        std::uint64_t meanNs() const;
+    };
+
+    LatencyHistogram();
+
+    void record(std::chrono::nanoseconds duration);
+    Snapshot snapshot() const;
+
+    // Exclusive upper bound of bucket i in ns; the last bucket has none
+    static std::uint64_t bucketBoundNs(std::size_t bucket);
+
+private:
+    std::atomic<std::uint64_t> m_counts[kBucketCount];
+    std::atomic<std::uint64_t> m_sumNs;
+    std::atomic<std::uint64_t> m_maxNs;
+};
+
+// Latency and allocations of one probe
+struct ProbeStats {
+    LatencyHistogram::Snapshot latency;
+    std::uint64_t lastAllocations;      // C++ heap allocations of the latest run
+    std::uint64_t maxAllocations;
+};
+
+// Process-wide self-instrumentation.
+//
+// Allocations are counted by replacing the global operator new in
+// diagnostics.cpp, per thread, so a probe sees only its own thread's
+// allocations. Memory allocated by C libraries (GLib, cairo) is not counted.
+class Diagnostics {
+public:
+    static void record(Probe probe, std::chrono::nanoseconds duration, std::uint64_t allocations);
+    static ProbeStats stats(Probe probe);
+    static const char* probeName(Probe probe);
+
+    // operator new calls made by the calling thread so far
+    static std::uint64_t threadAllocations();
+
+    // Measure the CPU time the process used since the previous call, as a
+    // percentage of one CPU. Called once per sample by the sampling thread.
+    static void updateProcessCPU();
+    static double processCPUPercent();
+};
+
+// Times its scope into a probe
+class ScopedProbe {
+public:
+    explicit ScopedProbe(Probe probe);
+    ~ScopedProbe();
+
+    ScopedProbe(const ScopedProbe&) = delete;
+    ScopedProbe& operator=(const ScopedProbe&) = delete;
+
+private:
+    Probe m_probe;
+    std::chrono::steady_clock::time_point m_start;
+    std::uint64_t m_startAllocations;
+};
+
+#endif // DIAGNOSTICS_H
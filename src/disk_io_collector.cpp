@@ -0,0 +1,124 @@
+#include "disk_io_collector.h"
+#include "monitor_clock.h"
+#include <sys/sysmacros.h>
+
+// /proc/diskstats counts in 512-byte sectors whatever the device block size
+static const double kSectorSize = 512.0;
+
+// Column of each counter among the numbers after the device name
+static const int kCounterColumns[] = {0, 2, 3, 4, 6, 7, 9};
+
+DiskIOCollector::DiskIOCollector()
+    : m_file(64 * 1024),
+      m_lastUpdate(MonitorClock::now())
+{
+    // Room for several hundred devices
+}
+
+bool DiskIOCollector::open(const char* path) {
+    m_lastUpdate = MonitorClock::now();
+    return m_file.open(path);
+}
+
+bool DiskIOCollector::isOpen() const {
+    return m_file.isOpen();
+}
+
+void DiskIOCollector::setDevices(const std::vector<dev_t>& devices) {
+    std::vector<DiskIOInfo> info;
+    std::vector<State> states;
+    for (dev_t device : devices) {
+        bool duplicate = false;
+        for (const DiskIOInfo& existing : info) {
+            duplicate = duplicate || existing.device == device;
+        }
+        if (duplicate || device == 0) {
+            continue;
+        }
+
+        DiskIOInfo entry{};
+        entry.device = device;
+        State state{};
+        for (std::size_t i = 0; i < m_info.size(); i++) {
+            if (m_info[i].device == device) {
+                entry = m_info[i];
+                state = m_states[i];
+                break;
+            }
+        }
+        info.push_back(entry);
+        states.push_back(state);
+    }
+    m_info.swap(info);
+    m_states.swap(states);
+}
+
+bool DiskIOCollector::update() {
+    using namespace ProcParse;
+
+    if (!m_file.read()) {
+        return false;
+    }
+
+    auto now = MonitorClock::now();
+    double elapsed = std::chrono::duration<double>(now - m_lastUpdate).count();
+    m_lastUpdate = now;
+
+    // "   8       0 sda 11 counters or more"
+    const char* end = m_file.end();
+    for (const char* p = m_file.data(); p < end; p = nextLine(p, end)) {
+        unsigned long long major;
+        unsigned long long minor;
+        const char* q = parseUnsigned(p, end, major);
+        q = parseUnsigned(q, end, minor);
+        dev_t device = makedev(static_cast<unsigned int>(major), static_cast<unsigned int>(minor));
+
+        std::size_t index = 0;
+        while (index < m_info.size() && m_info[index].device != device) {
+            index++;
+        }
+        if (index == m_info.size()) {
+            continue;
+        }
+
+        q = skipToken(skipSpaces(q, end), end);
+        unsigned long long columns[10];
+        for (auto& column : columns) {
+            q = parseUnsigned(q, end, column);
+        }
+
+        DiskIOInfo& info = m_info[index];
+        State& state = m_states[index];
+        unsigned long long delta[CounterCount] = {};
+        for (int counter = 0; counter < CounterCount; counter++) {
+            unsigned long long value = columns[kCounterColumns[counter]];
+            if (state.valid) {
+                delta[counter] = counterDelta(value, state.counters[counter]);
+            }
+            state.counters[counter] = value;
+        }
+
+        if (state.valid && elapsed > 0.0) {
+            info.readOpsPerSec = delta[ReadsCompleted] / elapsed;
+            info.writeOpsPerSec = delta[WritesCompleted] / elapsed;
+            info.readBytesPerSec = delta[SectorsRead] * kSectorSize / elapsed;
+            info.writeBytesPerSec = delta[SectorsWritten] * kSectorSize / elapsed;
+            unsigned long long requests = delta[ReadsCompleted] + delta[WritesCompleted];
+            info.awaitMs = requests > 0 ?
+                static_cast<double>(delta[ReadTicks] + delta[WriteTicks]) / requests : 0.0;
+            double utilization = 100.0 * delta[IOTicks] / (elapsed * 1000.0);
+            info.utilization = utilization < 100.0 ? utilization : 100.0;
+        }
+        state.valid = true;
+    }
+    return true;
+}
+
+const DiskIOInfo* DiskIOCollector::find(dev_t device) const {
+    for (std::size_t i = 0; i < m_info.size(); i++) {
+        if (m_info[i].device == device) {
+            return m_states[i].valid ? &m_info[i] : nullptr;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,62 @@
+#ifndef DISK_IO_COLLECTOR_H
+#define DISK_IO_COLLECTOR_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+#include <sys/types.h>
+#include "proc_reader.h"
+
+// I/O rates of one block device over the last update
+struct DiskIOInfo {
+    dev_t device;
+    double readOpsPerSec;
+    double writeOpsPerSec;
+    double readBytesPerSec;
+    double writeBytesPerSec;
+    double awaitMs;                 // Average time per completed request, 0 when idle
+    double utilization;             // Percent of the time the device was busy
+};
+
+// Block device statistics from /proc/diskstats.
+//
+// Only the devices passed to setDevices() are tracked; the other lines are
+// dropped after comparing the major:minor numbers, so a host with many
+// loop or dm devices pays a few integer parses per line. The file is read
+// through a ProcFile and parsed in one pass without allocation.
+class DiskIOCollector {
+public:
+    DiskIOCollector();
+
+    bool open(const char* path = "/proc/diskstats");
+    bool isOpen() const;
+
+    // Track these devices from now on; known devices keep their counters
+    void setDevices(const std::vector<dev_t>& devices);
+
+    // Read the counters and compute rates since the previous update
+    bool update();
+
+    // Rates of a tracked device, nullptr if it is unknown or not seen yet
+    const DiskIOInfo* find(dev_t device) const;
+
+private:
+    enum Counter {
+        ReadsCompleted, SectorsRead, ReadTicks,
+        WritesCompleted, SectorsWritten, WriteTicks,
+        IOTicks,
+        CounterCount
+    };
+
+    struct State {
+        unsigned long long counters[CounterCount];
+        bool valid;                     // Counters hold a previous read
+    };
+
+    ProcFile m_file;
+    std::vector<DiskIOInfo> m_info;     // Parallel to m_states
+    std::vector<State> m_states;
+    std::chrono::steady_clock::time_point m_lastUpdate;
+};
+
+#endif // DISK_IO_COLLECTOR_H
@@ -0,0 +1,50 @@
+#include "downsample.h"
+
+void downsampleM4(const double* values, std::size_t count, std::size_t columns,
+                  std::vector<DownsamplePoint>& out) {
+    out.clear();
+    if (count == 0 || columns == 0) {
+        return;
+    }
+
+    // Nothing to gain when there are fewer samples than four per column
+    if (count <= columns * 4) {
+        for (std::size_t i = 0; i < count; i++) {
+            out.push_back({i, values[i]});
+        }
+        return;
+    }
+
+    for (std::size_t column = 0; column < columns; column++) {
+        std::size_t begin = column * count / columns;
+        std::size_t end = (column + 1) * count / columns;
+        if (begin >= end) {
+            continue;
+        }
+
+        std::size_t minIndex = begin;
+        std::size_t maxIndex = begin;
+        for (std::size_t i = begin + 1; i < end; i++) {
+            if (values[i] < values[minIndex]) {
+                minIndex = i;
+            }
+            if (values[i] > values[maxIndex]) {
+                maxIndex = i;
+            }
+        }
+
+        // Emit in time order, skipping duplicates
+        std::size_t first = minIndex < maxIndex ? minIndex : maxIndex;
+        std::size_t second = minIndex < maxIndex ? maxIndex : minIndex;
+        out.push_back({begin, values[begin]});
+        if (first != begin) {
+            out.push_back({first, values[first]});
+        }
+        if (second != first && second != end - 1) {
+            out.push_back({second, values[second]});
+        }
+        if (end - 1 != begin) {
+            out.push_back({end - 1, values[end - 1]});
+        }
+    }
+}
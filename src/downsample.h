@@ -0,0 +1,25 @@
+#ifndef DOWNSAMPLE_H
+#define DOWNSAMPLE_H
+
+#include <cstddef>
+#include <vector>
+
+// A sample kept by the downsampler, with its index in the input span
+struct DownsamplePoint {
+    std::size_t index;
+    double value;
+};
+
+// M4 min/max downsampling for line rendering.
+//
+// Splits the samples into `columns` equal buckets (one per pixel column) and
+// keeps at most four samples per bucket, in time order: the first, the
+// minimum, the maximum and the last. A polyline through those points covers
+// exactly the same pixels as one through every sample, so peaks stay visible
+// while the path length is bounded by the width instead of the history length.
+//
+// `out` is cleared and refilled; reuse it across calls to avoid allocation.
+void downsampleM4(const double* values, std::size_t count, std::size_t columns,
+                  std::vector<DownsamplePoint>& out);
+
+#endif // DOWNSAMPLE_H
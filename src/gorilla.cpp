@@ -0,0 +1,217 @@
+#include "gorilla.h"
+#include <cstring>
+
+static std::uint64_t doubleBits(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bitsDouble(std::uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+GorillaBlock::GorillaBlock()
+    : m_bitCount(0),
+      m_count(0),
+      m_firstTimestamp(0),
+      m_prevTimestamp(0),
+      m_prevDelta(0),
+      m_prevValue(0),
+      m_prevLeading(-1),
+      m_prevTrailing(0)
+{
+}
+
+void GorillaBlock::clear() {
+    m_words.clear();
+    m_bitCount = 0;
+    m_count = 0;
+    m_firstTimestamp = 0;
+    m_prevTimestamp = 0;
+    m_prevDelta = 0;
+    m_prevValue = 0;
+    m_prevLeading = -1;
+    m_prevTrailing = 0;
+}
+
+void GorillaBlock::writeBits(std::uint64_t value, int bits) {
+    if (bits < 64) {
+        value &= (std::uint64_t(1) << bits) - 1;
+    }
+
+    std::size_t word = m_bitCount >> 6;
+    int free = 64 - static_cast<int>(m_bitCount & 63);
+    if (word >= m_words.size()) {
+        m_words.push_back(0);
+    }
+
+    if (bits <= free) {
+        m_words[word] |= value << (free - bits);
+    } else {
+        m_words[word] |= value >> (bits - free);
+        m_words.push_back(value << (64 - (bits - free)));
+    }
+    m_bitCount += bits;
+}
+
+void GorillaBlock::append(std::int64_t timestamp, double value) {
+    std::uint64_t bits = doubleBits(value);
+
+    // The first sample is stored verbatim
+    if (m_count == 0) {
+        writeBits(static_cast<std::uint64_t>(timestamp), 64);
+        writeBits(bits, 64);
+        m_firstTimestamp = timestamp;
+        m_prevTimestamp = timestamp;
+        m_prevDelta = 0;
+        m_prevValue = bits;
+        m_count = 1;
+        return;
+    }
+
+    // Timestamp: delta-of-delta with prefix codes 0, 10, 110, 1110, 1111
+    std::int64_t delta = timestamp - m_prevTimestamp;
+    std::int64_t dod = delta - m_prevDelta;
+    if (dod == 0) {
+        writeBits(0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        writeBits(0x2, 2);
+        writeBits(static_cast<std::uint64_t>(dod + 63), 7);
+    } else if (dod >= -255 && dod <= 256) {
+        writeBits(0x6, 3);
+        writeBits(static_cast<std::uint64_t>(dod + 255), 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        writeBits(0xe, 4);
+        writeBits(static_cast<std::uint64_t>(dod + 2047), 12);
+    } else {
+        writeBits(0xf, 4);
+        writeBits(static_cast<std::uint64_t>(dod), 64);
+    }
+    m_prevTimestamp = timestamp;
+    m_prevDelta = delta;
+
+    // Value: XOR with the previous one, reusing the previous bit window
+    // when the meaningful bits fit in it
+    std::uint64_t diff = bits ^ m_prevValue;
+    if (diff == 0) {
+        writeBits(0, 1);
+    } else {
+        int leading = __builtin_clzll(diff);
+        int trailing = __builtin_ctzll(diff);
+        if (leading > 31) {
+            leading = 31;
+        }
+
+        if (m_prevLeading >= 0 && leading >= m_prevLeading && trailing >= m_prevTrailing) {
+            writeBits(0x2, 2);
+            writeBits(diff >> m_prevTrailing, 64 - m_prevLeading - m_prevTrailing);
+        } else {
+            int meaningful = 64 - leading - trailing;
+            writeBits(0x3, 2);
+            writeBits(static_cast<std::uint64_t>(leading), 5);
+            writeBits(static_cast<std::uint64_t>(meaningful - 1), 6);
+            writeBits(diff >> trailing, meaningful);
+            m_prevLeading = leading;
+            m_prevTrailing = trailing;
+        }
+    }
+    m_prevValue = bits;
+    m_count++;
+}
+
+std::size_t GorillaBlock::size() const {
+    return m_count;
+}
+
+std::size_t GorillaBlock::byteSize() const {
+    return (m_bitCount + 7) / 8;
+}
+
+std::int64_t GorillaBlock::firstTimestamp() const {
+    return m_firstTimestamp;
+}
+
+std::int64_t GorillaBlock::lastTimestamp() const {
+    return m_prevTimestamp;
+}
+
+GorillaDecoder::GorillaDecoder(const GorillaBlock& block)
+    : m_words(block.m_words.data()),
+      m_position(0),
+      m_remaining(block.m_count),
+      m_started(false),
+      m_timestamp(0),
+      m_delta(0),
+      m_value(0),
+      m_leading(0),
+      m_trailing(0)
+{
+}
+
+std::uint64_t GorillaDecoder::readBits(int bits) {
+    std::size_t word = m_position >> 6;
+    int offset = static_cast<int>(m_position & 63);
+    int available = 64 - offset;
+    m_position += bits;
+
+    if (bits <= available) {
+        return (m_words[word] << offset) >> (64 - bits);
+    }
+    std::uint64_t high = m_words[word] & ((std::uint64_t(1) << available) - 1);
+    int rest = bits - available;
+    return (high << rest) | (m_words[word + 1] >> (64 - rest));
+}
+
+bool GorillaDecoder::readBit() {
+    bool bit = (m_words[m_position >> 6] >> (63 - (m_position & 63))) & 1;
+    m_position++;
+    return bit;
+}
+
+bool GorillaDecoder::next(std::int64_t& timestamp, double& value) {
+    if (m_remaining == 0) {
+        return false;
+    }
+    m_remaining--;
+
+    if (!m_started) {
+        m_started = true;
+        m_timestamp = static_cast<std::int64_t>(readBits(64));
+        m_value = readBits(64);
+        timestamp = m_timestamp;
+        value = bitsDouble(m_value);
+        return true;
+    }
+
+    std::int64_t dod = 0;
+    if (readBit()) {
+        if (!readBit()) {
+            dod = static_cast<std::int64_t>(readBits(7)) - 63;
+        } else if (!readBit()) {
+            dod = static_cast<std::int64_t>(readBits(9)) - 255;
+        } else if (!readBit()) {
+            dod = static_cast<std::int64_t>(readBits(12)) - 2047;
+        } else {
+            dod = static_cast<std::int64_t>(readBits(64));
+        }
+    }
+    m_delta += dod;
+    m_timestamp += m_delta;
+
+    if (readBit()) {
+        if (readBit()) {
+            m_leading = static_cast<int>(readBits(5));
+            int meaningful = static_cast<int>(readBits(6)) + 1;
+            m_trailing = 64 - m_leading - meaningful;
+        }
+        int meaningful = 64 - m_leading - m_trailing;
+        m_value ^= readBits(meaningful) << m_trailing;
+    }
+
+    timestamp = m_timestamp;
+    value = bitsDouble(m_value);
+    return true;
+}
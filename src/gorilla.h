@@ -0,0 +1,73 @@
+#ifndef GORILLA_H
+#define GORILLA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Gorilla time-series compression (Pelkonen et al., VLDB 2015).
+//
+// Timestamps are stored as delta-of-delta in a variable-length code, so a
+// regular sampling interval costs one bit per sample. Values are XORed with
+// the previous value and only the meaningful bits are kept, so an unchanged
+// value costs one bit and a slowly changing one a few bits more.
+//
+// A block is append-only; decode it from the start with GorillaDecoder.
+class GorillaBlock {
+public:
+    GorillaBlock();
+
+    // Drop the contents but keep the allocated storage
+    void clear();
+
+    // Append a sample; timestamps should not go backwards
+    void append(std::int64_t timestamp, double value);
+
+    std::size_t size() const;
+    std::size_t byteSize() const;
+    std::int64_t firstTimestamp() const;
+    std::int64_t lastTimestamp() const;
+
+private:
+    friend class GorillaDecoder;
+
+    std::vector<std::uint64_t> m_words;     // Bit stream, most significant bit first
+    std::size_t m_bitCount;
+    std::size_t m_count;
+
+    // Encoder state
+    std::int64_t m_firstTimestamp;
+    std::int64_t m_prevTimestamp;
+    std::int64_t m_prevDelta;
+    std::uint64_t m_prevValue;
+    int m_prevLeading;
+    int m_prevTrailing;
+
+    void writeBits(std::uint64_t value, int bits);
+};
+
+// Streaming decoder over one block
+class GorillaDecoder {
+public:
+    explicit GorillaDecoder(const GorillaBlock& block);
+
+    // Decode the next sample. Returns false after the last one.
+    bool next(std::int64_t& timestamp, double& value);
+
+private:
+    const std::uint64_t* m_words;
+    std::size_t m_position;
+    std::size_t m_remaining;
+    bool m_started;
+
+    std::int64_t m_timestamp;
+    std::int64_t m_delta;
+    std::uint64_t m_value;
+    int m_leading;
+    int m_trailing;
+
+    std::uint64_t readBits(int bits);
+    bool readBit();
+};
+
+#endif // GORILLA_H
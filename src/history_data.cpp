@@ -1,9 +1,22 @@
 #include "history_data.h"
 #include <algorithm>
-#include <numeric>
+#include <cmath>
 
-HistoryData::HistoryData(std::size_t capacity) : m_capacity(capacity) {
-    m_samples.reserve(capacity);
+constexpr std::size_t HistoryData::kSlack;
+
+HistoryData::HistoryData(std::size_t capacity, double ewmaAlpha)
+    : m_capacity(capacity),
+      m_ringSize(capacity + kSlack),
+      m_count(0),
+      m_base(0),
+      m_ewmaAlpha(ewmaAlpha),
+      m_statsSeq(0)
+{
+    // Storage is allocated once, addSample never reallocates
+    m_samples.assign(2 * m_ringSize, 0.0);
+    m_minQueue.seqs.assign(capacity, 0);
+    m_maxQueue.seqs.assign(capacity, 0);
+    resetStats();
 }
 
 HistoryData::~HistoryData() {
@@ -11,47 +24,249 @@ HistoryData::~HistoryData() {
 }
 
 void HistoryData::addSample(double value) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    // If we've reached capacity, remove the oldest sample
-    if (m_samples.size() >= m_capacity) {
-        m_samples.erase(m_samples.begin());
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (m_capacity == 0) {
+        return;
+    }
+
+    std::uint64_t count = m_count.load(std::memory_order_relaxed);
+    std::uint64_t base = m_base.load(std::memory_order_relaxed);
+    std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(count - base, m_capacity));
+
+    // Update the running mean and M2 (Welford), sliding the window once full.
+    // The evicted sample is still in its slot, the new one goes to a spare slot.
+    // Gaps enter and leave the window without touching the moments.
+    bool adding = !std::isnan(value);
+    bool evicting = false;
+    double evicted = 0.0;
+    if (size == m_capacity) {
+        evicted = sampleAt(count - m_capacity);
+        evicting = !std::isnan(evicted);
+    } else {
+        size++;
+    }
+    if (adding && evicting) {
+        double oldMean = m_mean;
+        double delta = value - evicted;
+        m_mean += delta / m_valid;
+        m_m2 += delta * (value - m_mean + evicted - oldMean);
+    } else if (adding) {
+        m_valid++;
+        double delta = value - m_mean;
+        m_mean += delta / m_valid;
+        m_m2 += delta * (value - m_mean);
+    } else if (evicting) {
+        m_valid--;
+        if (m_valid == 0) {
+            m_mean = 0.0;
+            m_m2 = 0.0;
+        } else {
+            double oldMean = m_mean;
+            m_mean -= (evicted - m_mean) / m_valid;
+            m_m2 -= (evicted - oldMean) * (evicted - m_mean);
+        }
+    }
+    if (m_m2 < 0.0) {
+        m_m2 = 0.0;
+    }
+
+    if (adding) {
+        m_ewma = m_ewmaStarted ? m_ewma + m_ewmaAlpha * (value - m_ewma) : value;
+        m_ewmaStarted = true;
+    }
+
+    // Write both mirrors before publishing the new count
+    std::size_t slot = static_cast<std::size_t>(count % m_ringSize);
+    m_samples[slot] = value;
+    m_samples[slot + m_ringSize] = value;
+
+    // Sliding-window min/max over the last `size` samples
+    std::uint64_t oldest = count + 1 - size;
+    expireMonotonic(m_minQueue, oldest);
+    expireMonotonic(m_maxQueue, oldest);
+    if (adding) {
+        pushMonotonic(m_minQueue, count, value, [](double a, double b) { return a < b; });
+        pushMonotonic(m_maxQueue, count, value, [](double a, double b) { return a > b; });
+    }
+
+    m_count.store(count + 1, std::memory_order_release);
+
+    // Sliding updates accumulate rounding error, so re-derive the moments exactly
+    // once per window. That is one O(n) pass every n samples, O(1) amortized.
+    if (++m_sinceRecompute >= m_capacity) {
+        recomputeMoments(count + 1, size);
+    }
+
+    publishStats();
+}
+
+double HistoryData::sampleAt(std::uint64_t seq) const {
+    return m_samples[static_cast<std::size_t>(seq % m_ringSize)];
+}
+
+template <typename Less>
+void HistoryData::pushMonotonic(MonotonicQueue& queue, std::uint64_t seq, double value, Less less) {
+    // Drop samples from the back that can no longer be the extreme
+    std::size_t cap = queue.seqs.size();
+    while (queue.size > 0) {
+        std::size_t back = (queue.head + queue.size - 1) % cap;
+        if (less(sampleAt(queue.seqs[back]), value)) {
+            break;
+        }
+        queue.size--;
+    }
+    queue.seqs[(queue.head + queue.size) % cap] = seq;
+    queue.size++;
+}
+
+void HistoryData::expireMonotonic(MonotonicQueue& queue, std::uint64_t oldestSeq) {
+    // Drop samples from the front that have left the window
+    while (queue.size > 0 && queue.seqs[queue.head] < oldestSeq) {
+        queue.head = (queue.head + 1) % queue.seqs.size();
+        queue.size--;
+    }
+}
+
+void HistoryData::recomputeMoments(std::uint64_t count, std::size_t size) {
+    m_sinceRecompute = 0;
+    std::size_t start = static_cast<std::size_t>((count - size) % m_ringSize);
+    const double* data = m_samples.data() + start;
+    std::size_t valid = 0;
+    double sum = 0.0;
+    for (std::size_t i = 0; i < size; i++) {
+        if (!std::isnan(data[i])) {
+            sum += data[i];
+            valid++;
+        }
+    }
+    m_valid = valid;
+    if (valid == 0) {
+        m_mean = 0.0;
+        m_m2 = 0.0;
+        return;
     }
-    
-    m_samples.push_back(value);
+
+    double mean = sum / valid;
+    double m2 = 0.0;
+    for (std::size_t i = 0; i < size; i++) {
+        if (!std::isnan(data[i])) {
+            double d = data[i] - mean;
+            m2 += d * d;
+        }
+    }
+    m_mean = mean;
+    m_m2 = m2;
+}
+
+void HistoryData::resetStats() {
+    m_mean = 0.0;
+    m_m2 = 0.0;
+    m_ewma = 0.0;
+    m_ewmaStarted = false;
+    m_valid = 0;
+    m_sinceRecompute = 0;
+    m_minQueue.head = m_minQueue.size = 0;
+    m_maxQueue.head = m_maxQueue.size = 0;
+    publishStats();
+}
+
+void HistoryData::publishStats() {
+    // Seqlock write side: odd sequence while the fields are inconsistent
+    std::uint64_t seq = m_statsSeq.load(std::memory_order_relaxed);
+    m_statsSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_pubCount.store(m_valid, std::memory_order_relaxed);
+    m_pubMean.store(m_mean, std::memory_order_relaxed);
+    m_pubMin.store(m_minQueue.size ? sampleAt(m_minQueue.seqs[m_minQueue.head]) : 0.0,
+                   std::memory_order_relaxed);
+    m_pubMax.store(m_maxQueue.size ? sampleAt(m_maxQueue.seqs[m_maxQueue.head]) : 0.0,
+                   std::memory_order_relaxed);
+    m_pubVariance.store(m_valid ? m_m2 / m_valid : 0.0, std::memory_order_relaxed);
+    m_pubEwma.store(m_ewma, std::memory_order_relaxed);
+
+    m_statsSeq.store(seq + 2, std::memory_order_release);
+}
+
+SampleView HistoryData::snapshot() const {
+    std::uint64_t count = m_count.load(std::memory_order_acquire);
+    std::uint64_t base = m_base.load(std::memory_order_acquire);
+    std::size_t size = static_cast<std::size_t>(
+        std::min<std::uint64_t>(count - std::min(base, count), m_capacity));
+
+    // The oldest sample sits in the first half, so the span never runs off the end
+    std::size_t start = static_cast<std::size_t>((count - size) % m_ringSize);
+    return SampleView(m_samples.data() + start, size, count);
+}
+
+bool HistoryData::validate(const SampleView& view) const {
+    // Order the caller's reads of the view before re-checking the counter
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::uint64_t count = m_count.load(std::memory_order_relaxed);
+
+    // The oldest sample of the view is overwritten by sample number oldest + ringSize.
+    // Sample number `count` may be being written right now, since m_count is
+    // only bumped afterwards, so it must not be that one either.
+    std::uint64_t oldest = view.endSequence() - view.size();
+    return count < oldest + m_ringSize;
 }
 
 std::vector<double> HistoryData::getSamples() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_samples;
+    std::vector<double> result;
+    for (;;) {
+        SampleView view = snapshot();
+        result.assign(view.begin(), view.end());
+        if (validate(view)) {
+            return result;
+        }
+    }
 }
 
-double HistoryData::getAverage() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_samples.empty()) {
-        return 0.0;
+HistoryStats HistoryData::getStats() const {
+    HistoryStats stats;
+    for (;;) {
+        // Seqlock read side: retry while a write is in progress or happened meanwhile
+        std::uint64_t seq = m_statsSeq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            continue;
+        }
+        stats.count = m_pubCount.load(std::memory_order_relaxed);
+        stats.average = m_pubMean.load(std::memory_order_relaxed);
+        stats.minimum = m_pubMin.load(std::memory_order_relaxed);
+        stats.maximum = m_pubMax.load(std::memory_order_relaxed);
+        stats.variance = m_pubVariance.load(std::memory_order_relaxed);
+        stats.ewma = m_pubEwma.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_statsSeq.load(std::memory_order_relaxed) == seq) {
+            break;
+        }
     }
-    
-    double sum = std::accumulate(m_samples.begin(), m_samples.end(), 0.0);
-    return sum / m_samples.size();
+    stats.stddev = std::sqrt(stats.variance);
+    return stats;
+}
+
+double HistoryData::getAverage() const {
+    return m_pubMean.load(std::memory_order_acquire);
 }
 
 double HistoryData::getMaximum() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_samples.empty()) {
-        return 0.0;
-    }
-    
-    return *std::max_element(m_samples.begin(), m_samples.end());
+    return m_pubMax.load(std::memory_order_acquire);
 }
 
 double HistoryData::getMinimum() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_samples.empty()) {
-        return 0.0;
-    }
-    
-    return *std::min_element(m_samples.begin(), m_samples.end());
+    return m_pubMin.load(std::memory_order_acquire);
+}
+
+double HistoryData::getVariance() const {
+    return m_pubVariance.load(std::memory_order_acquire);
+}
+
+double HistoryData::getStdDev() const {
+    return std::sqrt(getVariance());
+}
+
+double HistoryData::getEwma() const {
+    return m_pubEwma.load(std::memory_order_acquire);
 }
 
 std::size_t HistoryData::getCapacity() const {
@@ -59,11 +274,11 @@ std::size_t HistoryData::getCapacity() const {
 }
 
 std::size_t HistoryData::getSize() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_samples.size();
+    return snapshot().size();
 }
 
 void HistoryData::clear() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_samples.clear();
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_base.store(m_count.load(std::memory_order_relaxed), std::memory_order_release);
+    resetStats();
 }
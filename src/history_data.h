@@ -3,40 +3,159 @@
 
 #include <vector>
 #include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 
+// Read-only, contiguous span of samples from a HistoryData, oldest sample first.
+// The view points straight into the history storage; nothing is copied.
+class SampleView {
+public:
+    SampleView() : m_data(nullptr), m_size(0), m_endSequence(0) {}
+    SampleView(const double* data, std::size_t size, std::uint64_t endSequence)
+        : m_data(data), m_size(size), m_endSequence(endSequence) {}
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const double* data() const { return m_data; }
+
+    // Sample by age order, 0 is the oldest
+    double operator[](std::size_t index) const { return m_data[index]; }
+    double front() const { return m_data[0]; }
+    double back() const { return m_data[m_size - 1]; }
+
+    const double* begin() const { return m_data; }
+    const double* end() const { return m_data + m_size; }
+
+    // Total number of samples written to the history when the view was taken
+    std::uint64_t endSequence() const { return m_endSequence; }
+
+private:
+    const double* m_data;
+    std::size_t m_size;
+    std::uint64_t m_endSequence;
+};
+
+// Statistics over the samples currently in a HistoryData
+struct HistoryStats {
+    std::size_t count;  // Samples in the window, not counting gaps
+    double average;
+    double minimum;
+    double maximum;
+    double variance;    // Population variance of the window
+    double stddev;
+    double ewma;        // Exponentially weighted moving average of all samples since clear()
+};
+
+// Fixed-capacity circular buffer of samples with constant-time append.
+//
+// Every sample is stored twice, at slot i and at slot i + N, so the newest
+// samples are always contiguous in memory and snapshot() can hand out a plain
+// span without copying or locking. The ring has kSlack more slots than the
+// capacity: a snapshot stays intact until the writer has appended kSlack more
+// samples, which validate() checks in seqlock fashion.
+//
+// Statistics are maintained incrementally on every addSample() and published
+// through a seqlock, so all the stat getters are O(1) and lock-free.
+//
+// A NaN sample marks a gap, e.g. while the monitor was not running: it takes
+// its slot so later samples keep their place in time, but no statistic
+// counts it.
+//
+// addSample()/clear() must be called from a single writer thread; any number
+// of threads may read concurrently and never block the writer.
 class HistoryData {
 public:
-    HistoryData(std::size_t capacity);
+    HistoryData(std::size_t capacity, double ewmaAlpha = 0.1);
     ~HistoryData();
-    
+
     // Add a sample to the history
     void addSample(double value);
-    
-    // Get all samples
+
+    // Get a zero-copy view of the current samples
+    SampleView snapshot() const;
+
+    // Check that none of the samples in the view have been overwritten yet.
+    // Call after reading from the view; retry or discard the result if false.
+    bool validate(const SampleView& view) const;
+
+    // Get all samples (copies them, oldest first)
     std::vector<double> getSamples() const;
-    
+
+    // Get a consistent set of statistics
+    HistoryStats getStats() const;
+
     // Get the average value of all samples
     double getAverage() const;
-    
+
     // Get the maximum value
     double getMaximum() const;
-    
+
     // Get the minimum value
     double getMinimum() const;
-    
+
+    // Get the variance and standard deviation of the samples
+    double getVariance() const;
+    double getStdDev() const;
+
+    // Get the exponentially weighted moving average
+    double getEwma() const;
+
     // Get the capacity
     std::size_t getCapacity() const;
-    
+
     // Get the current size
     std::size_t getSize() const;
-    
+
     // Clear all samples
     void clear();
 
+    // Extra ring slots that keep snapshots valid while the writer advances
+    static constexpr std::size_t kSlack = 64;
+
 private:
-    std::vector<double> m_samples;
+    std::vector<double> m_samples;          // 2 * m_ringSize slots, mirrored halves
     std::size_t m_capacity;
-    mutable std::mutex m_mutex;
+    std::size_t m_ringSize;                 // m_capacity + kSlack
+    std::atomic<std::uint64_t> m_count;     // Samples ever written
+    std::atomic<std::uint64_t> m_base;      // Value of m_count at the last clear()
+    std::mutex m_writeMutex;                // Serializes writers only, readers never take it
+
+    // Sequence numbers of window samples, kept monotonic in value so the
+    // front is always the window minimum (or maximum)
+    struct MonotonicQueue {
+        std::vector<std::uint64_t> seqs;
+        std::size_t head = 0;
+        std::size_t size = 0;
+    };
+
+    // Writer-side running state
+    double m_mean;
+    double m_m2;                            // Sum of squared deviations from the mean
+    double m_ewma;
+    double m_ewmaAlpha;
+    bool m_ewmaStarted;
+    std::size_t m_valid;                    // Samples in the window that are not gaps
+    std::size_t m_sinceRecompute;
+    MonotonicQueue m_minQueue;
+    MonotonicQueue m_maxQueue;
+
+    // Published statistics, guarded by the m_statsSeq seqlock
+    std::atomic<std::uint64_t> m_statsSeq;
+    std::atomic<std::size_t> m_pubCount;
+    std::atomic<double> m_pubMean;
+    std::atomic<double> m_pubMin;
+    std::atomic<double> m_pubMax;
+    std::atomic<double> m_pubVariance;
+    std::atomic<double> m_pubEwma;
+
+    double sampleAt(std::uint64_t seq) const;
+    template <typename Less>
+    void pushMonotonic(MonotonicQueue& queue, std::uint64_t seq, double value, Less less);
+    void expireMonotonic(MonotonicQueue& queue, std::uint64_t oldestSeq);
+    void recomputeMoments(std::uint64_t count, std::size_t size);
+    void resetStats();
+    void publishStats();
 };
 
 #endif // HISTORY_DATA_H
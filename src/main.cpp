@@ -1,5 +1,8 @@
 #include <gtk/gtk.h>
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 #include "main_window.h"
 
 int main(int argc, char *argv[]) {
@@ -9,8 +12,22 @@ int main(int argc, char *argv[]) {
     // Set application name
     g_set_application_name("System Resource Monitor");
     
+    // --replay FILE [--speed N] shows a recorded trace instead of this machine
+    std::string replayPath;
+    int replaySpeed = 100;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            replaySpeed = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--replay FILE [--speed N]]" << std::endl;
+            return 2;
+        }
+    }
+    
     // Create main window
-    MainWindow* mainWindow = new MainWindow();
+    MainWindow* mainWindow = new MainWindow(replayPath, replaySpeed);
     if (!mainWindow->initialize()) {
         std::cerr << "Failed to initialize main window!" << std::endl;
         delete mainWindow;
@@ -2,17 +2,40 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
-#include <set>
 #include <vector>
+#include <algorithm>
+#include <cstdio>
 
-MainWindow::MainWindow()
+MainWindow::MainWindow(const std::string& replayPath, int replaySpeed)
     : m_window(nullptr),
+      m_cpuHeatmap(nullptr),
+      m_diskBox(nullptr),
+      m_noDisksLabel(nullptr),
+      m_networkBox(nullptr),
+      m_noNetworkLabel(nullptr),
+      m_timeRangeCombo(nullptr),
+      m_timeRange(600.0),
+      m_processStore(nullptr),
+      m_cgroupsPage(nullptr),
+      m_cgroupStore(nullptr),
+      m_cgroupSelection(nullptr),
+      m_cgroupGraph(nullptr),
+      m_selectedCgroup(0),
+      m_diagnosticsPage(nullptr),
+      m_diagnosticsStore(nullptr),
+      m_selfCPULabel(nullptr),
+      m_replayPath(replayPath),
+      m_replaySpeed(replaySpeed > 0 ? replaySpeed : 1),
+      m_pressureThreshold(0),
+      m_pendingPressure(0),
       m_updateTimerId(0)
 {
     // Create components
     m_settings = std::make_unique<Settings>();
-    m_resourceMonitor = std::make_unique<ResourceMonitor>(m_settings.get());
     m_notificationManager = std::make_unique<NotificationManager>();
+    m_alertEngine = std::make_unique<AlertEngine>();
+    m_pressureTriggers = std::make_unique<PressureTriggers>();
+    m_metricsExporter = std::make_unique<MetricsExporter>();
 }
 
 MainWindow::~MainWindow() {
@@ -22,23 +45,61 @@ MainWindow::~MainWindow() {
         m_updateTimerId = 0;
     }
     
+    // No more trigger callbacks into this window
+    m_pressureTriggers->stop();
+    
+    // Stop sampling before the histories the graphs point at go away
+    if (m_sampler) {
+        m_sampler->stop();
+    }
+    
     // Clean up resource graphs for CPU and memory
     for (auto* graph : m_resourceGraphs) {
         delete graph;
     }
     m_resourceGraphs.clear();
     
+    delete m_cpuHeatmap;
+    m_cpuHeatmap = nullptr;
+    
     // Clean up disk resource graphs
     for (auto& pair : m_diskGraphs) {
         delete pair.second;
     }
     m_diskGraphs.clear();
+    for (auto& pair : m_diskIOGraphs) {
+        delete pair.second;
+    }
+    m_diskIOGraphs.clear();
     
     // Clean up disk graph panels
     for (auto& pair : m_diskPanels) {
         delete pair.second;
     }
     m_diskPanels.clear();
+    
+    // Clean up network graphs, their frames belong to GTK
+    for (auto& pair : m_networkGraphs) {
+        delete pair.second;
+    }
+    m_networkGraphs.clear();
+    m_networkFrames.clear();
+    
+    delete m_cgroupGraph;
+    m_cgroupGraph = nullptr;
+    
+    if (m_processStore) {
+        g_object_unref(m_processStore);
+        m_processStore = nullptr;
+    }
+    if (m_cgroupStore) {
+        g_object_unref(m_cgroupStore);
+        m_cgroupStore = nullptr;
+    }
+    if (m_diagnosticsStore) {
+        g_object_unref(m_diagnosticsStore);
+        m_diagnosticsStore = nullptr;
+    }
 }
 
 bool MainWindow::initialize() {
@@ -51,14 +112,65 @@ bool MainWindow::initialize() {
     // Load settings
     m_settings->load();
     
+    // Воспроизведение читает записанные файлы из своего каталога
+    std::string root;
+    if (!m_replayPath.empty()) {
+        m_traceReplayer = std::make_unique<TraceReplayer>();
+        if (!m_traceReplayer->open(m_replayPath)) {
+            return false;
+        }
+        root = m_traceReplayer->root();
+    }
+    m_resourceMonitor = std::make_unique<ResourceMonitor>(m_settings.get(), root);
+    m_resourceMonitor->setDiskPollInterval(m_settings->getDiskPollInterval());
+    
     if (!m_resourceMonitor->initialize()) {
         std::cerr << "Failed to initialize resource monitor" << std::endl;
         return false;
     }
     
+    reloadAlertRules();
+    
     // Setup GUI
     setupWindow();
     
+    // Sample on a background thread, the timer below only redraws
+    m_sampler = std::make_unique<Sampler>(m_resourceMonitor.get(), samplerInterval());
+    if (m_traceReplayer) {
+        m_sampler->setTickCallback([this]() {
+            return m_traceReplayer->step();
+        });
+    }
+    
+    // Prometheus exporter, rendered on the sampling thread after every sample
+    const std::string& metricsAddress = m_settings->getMetricsAddress();
+    if (!metricsAddress.empty() && m_metricsExporter->start(metricsAddress)) {
+        m_sampler->setSampleCallback([this](const ResourceSnapshot& snapshot) {
+            m_metricsExporter->render(snapshot, *m_resourceMonitor);
+        });
+    }
+    m_sampler->start();
+    
+    // Stalls are reported by the kernel as they happen, not on the next sample
+    startPressureTriggers();
+    
+    // Pass interval changes on to the sampling side
+    m_settings->registerChangeCallback([this]() {
+        m_resourceMonitor->setDiskPollInterval(m_settings->getDiskPollInterval());
+        m_sampler->setInterval(samplerInterval());
+        if (m_settings->getPressureThreshold() != m_pressureThreshold) {
+            startPressureTriggers();
+        }
+        
+        // Вызывается на каждое движение ползунка: файл правил перечитываем
+        // только при смене пути, а компилируем, только если правила изменились
+        if (m_settings->getAlertRulesPath() != m_alertRulesPath) {
+            reloadAlertRules();
+        } else {
+            compileAlertRules();
+        }
+    });
+    
     // Start update timer
     m_updateTimerId = g_timeout_add(m_settings->getUpdateInterval(),
                                     onUpdateTimer, this);
@@ -69,7 +181,11 @@ bool MainWindow::initialize() {
 void MainWindow::setupWindow() {
     // Create the main window
     m_window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
-    gtk_window_set_title(GTK_WINDOW(m_window), "Монитор системных ресурсов");
+    std::string title = "Монитор системных ресурсов";
+    if (m_traceReplayer) {
+        title += " — воспроизведение " + m_replayPath;
+    }
+    gtk_window_set_title(GTK_WINDOW(m_window), title.c_str());
     gtk_window_set_default_size(GTK_WINDOW(m_window), 800, 600);
     gtk_window_set_position(GTK_WINDOW(m_window), GTK_WIN_POS_CENTER);
     gtk_container_set_border_width(GTK_CONTAINER(m_window), 10);
@@ -90,6 +206,24 @@ void MainWindow::setupWindow() {
                              m_monitoringPage,
                              gtk_label_new("Мониторинг"));
     
+    // Create processes tab
+    m_processesPage = createProcessesTab();
+    gtk_notebook_append_page(GTK_NOTEBOOK(m_notebook),
+                             m_processesPage,
+                             gtk_label_new("Процессы"));
+    
+    // Create cgroups tab
+    m_cgroupsPage = createCgroupsTab();
+    gtk_notebook_append_page(GTK_NOTEBOOK(m_notebook),
+                             m_cgroupsPage,
+                             gtk_label_new("Контейнеры"));
+    
+    // Create diagnostics tab
+    m_diagnosticsPage = createDiagnosticsTab();
+    gtk_notebook_append_page(GTK_NOTEBOOK(m_notebook),
+                             m_diagnosticsPage,
+                             gtk_label_new("Диагностика"));
+    
     // Create settings tab
     m_settingsPage = createSettingsTab();
     gtk_notebook_append_page(GTK_NOTEBOOK(m_notebook),
@@ -117,11 +251,26 @@ GtkWidget* MainWindow::createMonitoringTab() {
     GtkWidget* mainBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
     gtk_container_set_border_width(GTK_CONTAINER(mainBox), 10);
     
+    // Выбор периода; длинные периоды рисуются по агрегированным данным
+    GtkWidget* rangeBox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_box_pack_start(GTK_BOX(rangeBox), gtk_label_new("Период:"), FALSE, FALSE, 0);
+    m_timeRangeCombo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(m_timeRangeCombo), "600", "10 минут");
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(m_timeRangeCombo), "3600", "1 час");
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(m_timeRangeCombo), "21600", "6 часов");
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(m_timeRangeCombo), "86400", "24 часа");
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(m_timeRangeCombo), "604800", "7 дней");
+    gtk_combo_box_set_active_id(GTK_COMBO_BOX(m_timeRangeCombo), "600");
+    g_signal_connect(G_OBJECT(m_timeRangeCombo), "changed", G_CALLBACK(onTimeRangeChanged), this);
+    gtk_box_pack_start(GTK_BOX(rangeBox), m_timeRangeCombo, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(mainBox), rangeBox, FALSE, FALSE, 0);
+    
     // Create CPU graph
     ResourceGraph* cpuGraph = new ResourceGraph();
     cpuGraph->setTitle("Использование ЦП");
     cpuGraph->setColor(0.2, 0.7, 1.0);
     cpuGraph->setDataSource(m_resourceMonitor->getCPUHistory());
+    cpuGraph->setScrollMode(true);
     m_resourceGraphs.push_back(cpuGraph);
     
     // Create Memory graph
@@ -129,6 +278,7 @@ GtkWidget* MainWindow::createMonitoringTab() {
     memGraph->setTitle("Использование памяти");
     memGraph->setColor(0.8, 0.4, 0.2);
     memGraph->setDataSource(m_resourceMonitor->getMemoryHistory());
+    memGraph->setScrollMode(true);
     m_resourceGraphs.push_back(memGraph);
     
     // Add CPU and memory graphs to a horizontal box
@@ -137,19 +287,170 @@ GtkWidget* MainWindow::createMonitoringTab() {
     gtk_box_pack_start(GTK_BOX(topGraphsBox), createGraphContainer("Память", memGraph), TRUE, TRUE, 0);
     gtk_box_pack_start(GTK_BOX(mainBox), topGraphsBox, TRUE, TRUE, 0);
     
+    // Per-core heatmap, one row per core instead of one graph per core
+    m_cpuHeatmap = new CPUHeatmap();
+    std::vector<HistoryData*> coreHistories;
+    for (std::size_t i = 0; i < m_resourceMonitor->getCoreCount(); i++) {
+        coreHistories.push_back(m_resourceMonitor->getCoreHistory(i));
+    }
+    m_cpuHeatmap->setDataSources(coreHistories);
+    
+    GtkWidget* heatmapFrame = gtk_frame_new("Ядра ЦП");
+    GtkWidget* heatmapBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_container_set_border_width(GTK_CONTAINER(heatmapBox), 10);
+    gtk_box_pack_start(GTK_BOX(heatmapBox), m_cpuHeatmap->getWidget(), TRUE, TRUE, 0);
+    gtk_container_add(GTK_CONTAINER(heatmapFrame), heatmapBox);
+    gtk_box_pack_start(GTK_BOX(mainBox), heatmapFrame, TRUE, TRUE, 0);
+    
+    // Network section, one graph per interface: receive filled, transmit as a line
+    GtkWidget* networkFrame = gtk_frame_new("Сеть");
+    m_networkBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_container_set_border_width(GTK_CONTAINER(m_networkBox), 10);
+    gtk_container_add(GTK_CONTAINER(networkFrame), m_networkBox);
+    
+    m_noNetworkLabel = gtk_label_new("Нет сетевых интерфейсов для отображения.");
+    gtk_widget_set_halign(m_noNetworkLabel, GTK_ALIGN_CENTER);
+    gtk_widget_set_valign(m_noNetworkLabel, GTK_ALIGN_CENTER);
+    gtk_box_pack_start(GTK_BOX(m_networkBox), m_noNetworkLabel, TRUE, TRUE, 10);
+    
+    gtk_box_pack_start(GTK_BOX(mainBox), networkFrame, TRUE, TRUE, 0);
+    
+    // Pressure stall section: avg10 filled, avg60 as a line
+    if (m_resourceMonitor->getPressureAvg10History(PressureResource::CPU)) {
+        GtkWidget* pressureFrame = gtk_frame_new("Ожидание ресурсов (PSI)");
+        GtkWidget* pressureBox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+        gtk_container_set_border_width(GTK_CONTAINER(pressureBox), 10);
+        const char* labels[] = {"ЦП", "Память", "Ввод-вывод"};
+        for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+            PressureResource resource = static_cast<PressureResource>(i);
+            ResourceGraph* graph = new ResourceGraph();
+            graph->setTitle(std::string("Простой задач: ") + labels[i]);
+            graph->setColor(0.9, 0.3, 0.3);
+            graph->setSecondaryColor(1.0, 0.8, 0.3);
+            graph->setValueFormat(ResourceGraph::ValueFormat::ScaledPercent);
+            graph->setDataSource(m_resourceMonitor->getPressureAvg10History(resource));
+            graph->setSecondaryDataSource(m_resourceMonitor->getPressureAvg60History(resource));
+            m_resourceGraphs.push_back(graph);
+            gtk_box_pack_start(GTK_BOX(pressureBox), createGraphContainer(labels[i], graph), TRUE, TRUE, 0);
+        }
+        gtk_container_add(GTK_CONTAINER(pressureFrame), pressureBox);
+        gtk_box_pack_start(GTK_BOX(mainBox), pressureFrame, TRUE, TRUE, 0);
+    }
+    
     // Create disk usage section
     GtkWidget* diskFrame = gtk_frame_new("Использование дисков");
-    GtkWidget* diskBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
-    gtk_container_set_border_width(GTK_CONTAINER(diskBox), 10);
-    gtk_container_add(GTK_CONTAINER(diskFrame), diskBox);
+    m_diskBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_container_set_border_width(GTK_CONTAINER(m_diskBox), 10);
+    gtk_container_add(GTK_CONTAINER(diskFrame), m_diskBox);
     
-    // We'll add disk graphs dynamically in updateUI
+    // Disk panels are added and removed in updateDiskPanels as mounts change
+    m_noDisksLabel = gtk_label_new("Нет доступных физических дисков для отображения.");
+    gtk_widget_set_halign(m_noDisksLabel, GTK_ALIGN_CENTER);
+    gtk_widget_set_valign(m_noDisksLabel, GTK_ALIGN_CENTER);
+    gtk_box_pack_start(GTK_BOX(m_diskBox), m_noDisksLabel, TRUE, TRUE, 10);
     
     gtk_box_pack_start(GTK_BOX(mainBox), diskFrame, TRUE, TRUE, 0);
     
     return mainBox;
 }
 
+GtkWidget* MainWindow::createProcessesTab() {
+    GtkWidget* mainBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_container_set_border_width(GTK_CONTAINER(mainBox), 10);
+    
+    GtkWidget* label = gtk_label_new("Процессы с наибольшей загрузкой ЦП");
+    gtk_widget_set_halign(label, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(mainBox), label, FALSE, FALSE, 0);
+    
+    // PID, имя, ЦП, память; значения уже отформатированы
+    m_processStore = gtk_list_store_new(4, G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+    GtkWidget* treeView = gtk_tree_view_new_with_model(GTK_TREE_MODEL(m_processStore));
+    const char* titles[] = {"PID", "Имя", "ЦП, %", "Память"};
+    for (int i = 0; i < 4; i++) {
+        GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
+        GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(titles[i], renderer, "text", i, NULL);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(treeView), column);
+    }
+    
+    GtkWidget* scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_container_add(GTK_CONTAINER(scrolled), treeView);
+    gtk_box_pack_start(GTK_BOX(mainBox), scrolled, TRUE, TRUE, 0);
+    
+    return mainBox;
+}
+
+GtkWidget* MainWindow::createCgroupsTab() {
+    GtkWidget* mainBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_container_set_border_width(GTK_CONTAINER(mainBox), 10);
+    
+    GtkWidget* label = gtk_label_new("Контрольные группы с наибольшей загрузкой ЦП");
+    gtk_widget_set_halign(label, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(mainBox), label, FALSE, FALSE, 0);
+    
+    // Группа, ЦП, память, чтение, запись; значения уже отформатированы.
+    // Скрытый последний столбец - id группы: длинный путь показан не целиком
+    m_cgroupStore = gtk_list_store_new(6, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                       G_TYPE_UINT64);
+    GtkWidget* treeView = gtk_tree_view_new_with_model(GTK_TREE_MODEL(m_cgroupStore));
+    const char* titles[] = {"Группа", "ЦП, %", "Память", "Чтение", "Запись"};
+    for (int i = 0; i < 5; i++) {
+        GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
+        GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(titles[i], renderer, "text", i, NULL);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(treeView), column);
+    }
+    m_cgroupSelection = gtk_tree_view_get_selection(GTK_TREE_VIEW(treeView));
+    g_signal_connect(G_OBJECT(m_cgroupSelection), "changed", G_CALLBACK(onCgroupSelectionChanged), this);
+    
+    GtkWidget* scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_container_add(GTK_CONTAINER(scrolled), treeView);
+    gtk_box_pack_start(GTK_BOX(mainBox), scrolled, TRUE, TRUE, 0);
+    
+    // График ЦП выбранной группы, пуст до первого выбора
+    m_cgroupGraph = new ResourceGraph();
+    m_cgroupGraph->setTitle("ЦП группы");
+    m_cgroupGraph->setColor(0.3, 0.8, 0.5);
+    m_cgroupGraph->setValueFormat(ResourceGraph::ValueFormat::ScaledPercent);
+    gtk_box_pack_start(GTK_BOX(mainBox), createGraphContainer("Выбранная группа", m_cgroupGraph), TRUE, TRUE, 0);
+    
+    return mainBox;
+}
+
+GtkWidget* MainWindow::createDiagnosticsTab() {
+    GtkWidget* mainBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_container_set_border_width(GTK_CONTAINER(mainBox), 10);
+    
+    m_selfCPULabel = gtk_label_new("Монитор использует ЦП: —");
+    gtk_widget_set_halign(m_selfCPULabel, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(mainBox), m_selfCPULabel, FALSE, FALSE, 0);
+    
+    // Замер, число вызовов, медиана, p99, максимум, выделения памяти
+    m_diagnosticsStore = gtk_list_store_new(6, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                            G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+    GtkWidget* treeView = gtk_tree_view_new_with_model(GTK_TREE_MODEL(m_diagnosticsStore));
+    const char* titles[] = {"Замер", "Вызовов", "Медиана", "p99", "Макс.", "Выделений (посл./макс.)"};
+    for (int i = 0; i < 6; i++) {
+        GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
+        GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(titles[i], renderer, "text", i, NULL);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(treeView), column);
+    }
+    
+    // Строки постоянные, обновляются только значения
+    GtkTreeIter iter;
+    for (std::size_t i = 0; i < kProbeCount; i++) {
+        gtk_list_store_append(m_diagnosticsStore, &iter);
+        gtk_list_store_set(m_diagnosticsStore, &iter, 0, Diagnostics::probeName(static_cast<Probe>(i)), -1);
+    }
+    
+    GtkWidget* scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_container_add(GTK_CONTAINER(scrolled), treeView);
+    gtk_box_pack_start(GTK_BOX(mainBox), scrolled, TRUE, TRUE, 0);
+    
+    return mainBox;
+}
+
 GtkWidget* MainWindow::createSettingsTab() {
     // Create a vertical box as the main container for the settings tab
     GtkWidget* mainBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
@@ -213,6 +514,32 @@ GtkWidget* MainWindow::createSettingsTab() {
     gtk_grid_attach(GTK_GRID(grid), cooldownLabel, 0, 3, 1, 1);
     gtk_grid_attach(GTK_GRID(grid), m_notificationCooldownSpinner, 1, 3, 1, 1);
     
+    // Disk capacity polling interval setting
+    GtkWidget* diskPollLabel = gtk_label_new("Интервал опроса заполнения дисков (сек.):");
+    gtk_widget_set_halign(diskPollLabel, GTK_ALIGN_START);
+    
+    m_diskPollIntervalSpinner = gtk_spin_button_new_with_range(1, 600, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(m_diskPollIntervalSpinner),
+                             m_settings->getDiskPollInterval());
+    g_signal_connect(G_OBJECT(m_diskPollIntervalSpinner), "value-changed",
+                     G_CALLBACK(onDiskPollIntervalChanged), this);
+    
+    gtk_grid_attach(GTK_GRID(grid), diskPollLabel, 0, 4, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), m_diskPollIntervalSpinner, 1, 4, 1, 1);
+    
+    // PSI trigger threshold setting
+    GtkWidget* pressureLabel = gtk_label_new("Порог ожидания ресурсов PSI (% времени за 2 сек.):");
+    gtk_widget_set_halign(pressureLabel, GTK_ALIGN_START);
+    
+    m_pressureThresholdSpinner = gtk_spin_button_new_with_range(1, 100, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(m_pressureThresholdSpinner),
+                             m_settings->getPressureThreshold());
+    g_signal_connect(G_OBJECT(m_pressureThresholdSpinner), "value-changed",
+                     G_CALLBACK(onPressureThresholdChanged), this);
+    
+    gtk_grid_attach(GTK_GRID(grid), pressureLabel, 0, 5, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), m_pressureThresholdSpinner, 1, 5, 1, 1);
+    
     // Add the grid to the main box
     gtk_box_pack_start(GTK_BOX(mainBox), grid, FALSE, FALSE, 0);
     
@@ -254,138 +581,119 @@ GtkWidget* MainWindow::createGraphContainer(const std::string& label, ResourceGr
 
 gboolean MainWindow::onUpdateTimer(gpointer user_data) {
     MainWindow* window = static_cast<MainWindow*>(user_data);
-    window->m_resourceMonitor->update();
-    window->updateUI();
+    
+    // Nothing to do until the sampler publishes a new snapshot
+    if (window->m_sampler->poll()) {
+        window->updateUI(window->m_sampler->latest());
+    }
     
     // Continue the timer
     return TRUE;
 }
 
-void MainWindow::updateUI() {
+int MainWindow::samplerInterval() const {
+    int interval = m_settings->getSampleInterval();
+    return m_traceReplayer ? std::max(1, interval / m_replaySpeed) : interval;
+}
+
+void MainWindow::startPressureTriggers() {
+    m_pressureThreshold = m_settings->getPressureThreshold();
+    
+    // Триггеры следят за ядром этой машины, а не за записью
+    if (m_traceReplayer) {
+        return;
+    }
+    m_pressureTriggers->start(m_pressureThreshold, [this](PressureResource resource) {
+        // Runs on the watcher thread: hand over to the GTK thread, once per batch
+        unsigned bit = 1u << static_cast<unsigned>(resource);
+        if (m_pendingPressure.fetch_or(bit) == 0) {
+            g_idle_add(onPressureTriggered, this);
+        }
+    });
+}
+
+void MainWindow::reloadAlertRules() {
+    m_alertRulesPath = m_settings->getAlertRulesPath();
+    m_alertFileRules = AlertEngine::readRulesFile(m_alertRulesPath);
+    compileAlertRules();
+}
+
+void MainWindow::compileAlertRules() {
+    std::vector<std::string> rules = AlertEngine::builtInRules(*m_settings);
+    rules.insert(rules.end(), m_alertFileRules.begin(), m_alertFileRules.end());
+    if (rules == m_alertRules) {
+        return;
+    }
+    
+    // С ошибкой в файле правил остаются хотя бы встроенные пороги
+    std::string error;
+    if (!m_alertEngine->compile(rules, error)) {
+        std::cerr << "Invalid alert rule in " << m_settings->getAlertRulesPath() << ": " << error << std::endl;
+        if (!m_alertEngine->compile(AlertEngine::builtInRules(*m_settings), error)) {
+            std::cerr << "Invalid alert rule: " << error << std::endl;
+        }
+    }
+    m_alertRules = std::move(rules);
+}
+
+gboolean MainWindow::onPressureTriggered(gpointer user_data) {
+    MainWindow* window = static_cast<MainWindow*>(user_data);
+    unsigned pending = window->m_pendingPressure.exchange(0);
+    
+    const char* resources[] = {"ЦП", "памяти", "ввода-вывода"};
+    const ResourceSnapshot& snapshot = window->m_sampler->latest();
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        if (!(pending & (1u << i))) {
+            continue;
+        }
+        
+        // Отдельная категория на ресурс, чтобы не глушить обычные пороги
+        std::string title = std::string("Ожидание ") + resources[i];
+        if (window->m_notificationManager->wasRecentlySent(title, window->m_settings->getNotificationCooldown())) {
+            continue;
+        }
+        std::stringstream message;
+        message << "Задачи простаивают в ожидании " << resources[i] << " больше "
+                << window->m_pressureThreshold << "% времени (за 10 с: "
+                << std::fixed << std::setprecision(1) << snapshot.pressure[i].someAvg10 << "%)";
+        window->m_notificationManager->sendNotification(title, message.str(), NOTIFY_URGENCY_CRITICAL);
+    }
+    
+    // One-shot
+    return FALSE;
+}
+
+void MainWindow::updateUI(const ResourceSnapshot& snapshot) {
+    ScopedProbe probe(Probe::UpdateUI);
+    
     // Update existing CPU and memory graphs
     for (auto* graph : m_resourceGraphs) {
         graph->redraw();
     }
+    m_cpuHeatmap->redraw();
     
-    // Находим контейнер для графиков дисков
-    GtkWidget* diskFrame = gtk_notebook_get_nth_page(GTK_NOTEBOOK(m_notebook), 0);
-    if (diskFrame) {
-        GList* children = gtk_container_get_children(GTK_CONTAINER(diskFrame));
-        if (children) {
-            GtkWidget* mainBox = reinterpret_cast<GtkWidget*>(children->data);
-            g_list_free(children);
-            
-            // Проверяем, есть ли контейнер для дисков
-            children = gtk_container_get_children(GTK_CONTAINER(mainBox));
-            if (children && g_list_length(children) >= 3) {
-                // Третий элемент - это фрейм с дисками
-                GtkWidget* diskFrame = reinterpret_cast<GtkWidget*>(g_list_nth_data(children, 2));
-                
-                // Получаем данные о дисках
-                const std::vector<DiskInfo>& diskInfo = m_resourceMonitor->getDiskInfo();
-                
-                // Получаем контейнер внутри фрейма
-                GList* frameChildren = gtk_container_get_children(GTK_CONTAINER(diskFrame));
-                if (frameChildren) {
-                    GtkWidget* diskBox = reinterpret_cast<GtkWidget*>(frameChildren->data);
-                    g_list_free(frameChildren);
-                    
-                    // Очищаем текущие виджеты
-                    GList* diskBoxChildren = gtk_container_get_children(GTK_CONTAINER(diskBox));
-                    if (diskBoxChildren) {
-                        for (GList* item = diskBoxChildren; item != nullptr; item = item->next) {
-                            gtk_widget_destroy(reinterpret_cast<GtkWidget*>(item->data));
-                        }
-                        g_list_free(diskBoxChildren);
-                    }
-                    
-                    // Добавляем графики для каждого диска
-                    if (diskInfo.empty()) {
-                        // Если нет доступных дисков, показываем сообщение
-                        GtkWidget* infoLabel = gtk_label_new("Нет доступных физических дисков для отображения.");
-                        gtk_widget_set_halign(infoLabel, GTK_ALIGN_CENTER);
-                        gtk_widget_set_valign(infoLabel, GTK_ALIGN_CENTER);
-                        gtk_box_pack_start(GTK_BOX(diskBox), infoLabel, TRUE, TRUE, 10);
-                    } else {
-                        // Создаем список существующих дисков для отслеживания удаленных дисков
-                        std::set<std::string> currentDisks;
-                        
-                        for (const auto& disk : diskInfo) {
-                            currentDisks.insert(disk.mountpoint);
-                            
-                            // Создаем новый граф, если его еще нет
-                            if (m_diskGraphs.find(disk.mountpoint) == m_diskGraphs.end()) {
-                                ResourceGraph* diskGraph = new ResourceGraph();
-                                std::string title = "Диск: " + disk.mountpoint;
-                                diskGraph->setTitle(title);
-                                
-                                // Устанавливаем разные цвета для разных дисков
-                                // Используем хеш от имени диска для получения уникального цвета
-                                size_t hash = std::hash<std::string>{}(disk.mountpoint);
-                                double r = 0.3 + (hash % 100) / 200.0;
-                                double g = 0.4 + ((hash / 100) % 100) / 200.0;
-                                double b = 0.5 + ((hash / 10000) % 100) / 200.0;
-                                diskGraph->setColor(r, g, b);
-                                
-                                // Устанавливаем источник данных
-                                diskGraph->setDataSource(m_resourceMonitor->getDiskHistory(disk.mountpoint));
-                                m_diskGraphs[disk.mountpoint] = diskGraph;
-                            }
-                            
-                            // Создаем или обновляем панель графика диска
-                            double totalGB = disk.total / (1024.0 * 1024.0 * 1024.0);
-                            double usedGB = disk.used / (1024.0 * 1024.0 * 1024.0);
-                            
-                            if (m_diskPanels.find(disk.mountpoint) == m_diskPanels.end()) {
-                                // Создаем новую панель
-                                DiskGraphPanel* panel = new DiskGraphPanel(
-                                    disk.mountpoint,
-                                    disk.device,
-                                    m_diskGraphs[disk.mountpoint]
-                                );
-                                m_diskPanels[disk.mountpoint] = panel;
-                            }
-                            
-                            // Обновляем информацию о диске
-                            m_diskPanels[disk.mountpoint]->updateInfo(usedGB, totalGB, disk.percent);
-                            
-                            // Обновляем график
-                            m_diskGraphs[disk.mountpoint]->redraw();
-                            
-                            // Добавляем панель в основной контейнер
-                            gtk_box_pack_start(GTK_BOX(diskBox), m_diskPanels[disk.mountpoint]->getWidget(), TRUE, TRUE, 5);
-                        }
-                        
-                        // Удаляем диски, которые больше не доступны
-                        std::vector<std::string> disksToRemove;
-                        for (const auto& pair : m_diskPanels) {
-                            if (currentDisks.find(pair.first) == currentDisks.end()) {
-                                disksToRemove.push_back(pair.first);
-                            }
-                        }
-                        
-                        for (const auto& mountpoint : disksToRemove) {
-                            delete m_diskPanels[mountpoint];
-                            m_diskPanels.erase(mountpoint);
-                            
-                            delete m_diskGraphs[mountpoint];
-                            m_diskGraphs.erase(mountpoint);
-                        }
-                    }
-                    
-                    // Показываем все виджеты
-                    gtk_widget_show_all(diskBox);
-                }
-            }
-            g_list_free(children);
-        }
-    }
+    // Обновляем панели дисков
+    updateDiskPanels(snapshot.diskInfo);
+    
+    // Обновляем графики сети
+    updateNetworkPanels(snapshot.networkInfo);
+    
+    // Обновляем список процессов
+    updateProcessList(snapshot.topProcesses);
+    
+    // Обновляем список контрольных групп
+    updateCgroupList(snapshot.topCgroups);
+    
+    // Собственные затраты монитора
+    updateDiagnostics();
     
     // Обновляем строку состояния
     std::stringstream status;
-    status << "ЦП: " << std::fixed << std::setprecision(1) << m_resourceMonitor->getCPUUsage() << "% | ";
+    HistoryStats cpuStats = m_resourceMonitor->getCPUHistory()->raw()->getStats();
+    status << "ЦП: " << std::fixed << std::setprecision(1) << snapshot.cpuUsage << "% "
+           << "(ср. " << cpuStats.average << "%, макс. " << cpuStats.maximum << "%) | ";
     
-    const MemoryInfo& memInfo = m_resourceMonitor->getMemoryInfo();
+    const MemoryInfo& memInfo = snapshot.memInfo;
     status << "Память: " << std::fixed << std::setprecision(1) << memInfo.percent << "% | ";
     
     double totalGB = memInfo.total / (1024.0 * 1024.0);
@@ -396,20 +704,309 @@ void MainWindow::updateUI() {
     gtk_statusbar_pop(GTK_STATUSBAR(m_statusBar), m_statusBarContextId);
     gtk_statusbar_push(GTK_STATUSBAR(m_statusBar), m_statusBarContextId, status.str().c_str());
     
-    // Проверяем пороговые значения и показываем уведомления при необходимости
-    std::string message;
-    ResourceType resourceType;
-    
-    if (m_resourceMonitor->checkThresholds(message, resourceType)) {
-        // Проверяем, было ли недавно отправлено уведомление для данного типа ресурса
-        if (!m_notificationManager->wasResourceRecentlySent(resourceType, m_settings->getNotificationCooldown())) {
+    // Проверяем правила оповещений и показываем уведомления при смене состояния
+    m_alertEngine->evaluate(snapshot, *m_resourceMonitor, m_alertEvents);
+    auto now = std::chrono::steady_clock::now();
+    auto cooldown = std::chrono::seconds(m_settings->getNotificationCooldown());
+    if (!m_alertEvents.empty()) {
+        // Ключ содержит экземпляр, а контейнеры и интерфейсы приходят и уходят:
+        // забываем срабатывания, которые уже не сдерживают повтор
+        for (auto it = m_lastAlertTimes.begin(); it != m_lastAlertTimes.end();) {
+            if (now - it->second >= cooldown) {
+                it = m_lastAlertTimes.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (const AlertEvent& event : m_alertEvents) {
+        if (!event.firing) {
+            // Пропавший экземпляр больше не сработает под тем же ключом,
+            // разве что вернётся
+            if (event.absent) {
+                m_lastAlertTimes.erase(event.key);
+            }
             m_notificationManager->sendResourceNotification(
-                resourceType, 
-                "Предупреждение о ресурсах системы", 
-                message, 
-                NOTIFY_URGENCY_CRITICAL
+                event.resourceType,
+                event.absent ? "Источник данных пропал" : "Ресурсы системы в норме",
+                event.message,
+                NOTIFY_URGENCY_LOW
             );
+            continue;
         }
+        
+        // Повторное срабатывание того же правила не чаще раза за период
+        auto last = m_lastAlertTimes.find(event.key);
+        if (last != m_lastAlertTimes.end() && now - last->second < cooldown) {
+            continue;
+        }
+        m_lastAlertTimes[event.key] = now;
+        m_notificationManager->sendResourceNotification(
+            event.resourceType, 
+            "Предупреждение о ресурсах системы", 
+            event.message, 
+            NOTIFY_URGENCY_CRITICAL
+        );
+    }
+}
+
+void MainWindow::updateProcessList(const std::vector<ProcessInfo>& processes) {
+    GtkTreeModel* model = GTK_TREE_MODEL(m_processStore);
+    int rows = gtk_tree_model_iter_n_children(model, NULL);
+    
+    GtkTreeIter iter;
+    for (std::size_t i = 0; i < processes.size(); i++) {
+        if (static_cast<int>(i) >= rows) {
+            gtk_list_store_append(m_processStore, &iter);
+        } else {
+            gtk_tree_model_iter_nth_child(model, &iter, NULL, static_cast<int>(i));
+        }
+        
+        const ProcessInfo& process = processes[i];
+        char cpu[32];
+        char memory[32];
+        std::snprintf(cpu, sizeof(cpu), "%.1f", process.cpuPercent);
+        std::snprintf(memory, sizeof(memory), "%.1f МБ", process.rssBytes / (1024.0 * 1024.0));
+        gtk_list_store_set(m_processStore, &iter, 0, process.pid, 1, process.name, 2, cpu, 3, memory, -1);
+    }
+    
+    // Лишние строки удаляем с конца
+    for (int i = rows - 1; i >= static_cast<int>(processes.size()); i--) {
+        if (gtk_tree_model_iter_nth_child(model, &iter, NULL, i)) {
+            gtk_list_store_remove(m_processStore, &iter);
+        }
+    }
+}
+
+void MainWindow::updateCgroupList(const std::vector<CgroupInfo>& cgroups) {
+    GtkTreeModel* model = GTK_TREE_MODEL(m_cgroupStore);
+    int rows = gtk_tree_model_iter_n_children(model, NULL);
+    
+    // Строки переиспользуются, поэтому выделение ставим заново по id группы;
+    // обработчик выбора не меняет график, пока id тот же
+    gtk_tree_selection_unselect_all(m_cgroupSelection);
+    
+    GtkTreeIter iter;
+    for (std::size_t i = 0; i < cgroups.size(); i++) {
+        if (static_cast<int>(i) >= rows) {
+            gtk_list_store_append(m_cgroupStore, &iter);
+        } else {
+            gtk_tree_model_iter_nth_child(model, &iter, NULL, static_cast<int>(i));
+        }
+        
+        const CgroupInfo& cgroup = cgroups[i];
+        char cpu[32];
+        char memory[32];
+        char read[32];
+        char write[32];
+        std::snprintf(cpu, sizeof(cpu), "%.1f", cgroup.cpuPercent);
+        std::snprintf(memory, sizeof(memory), "%.1f МБ", cgroup.memoryBytes / (1024.0 * 1024.0));
+        std::snprintf(read, sizeof(read), "%.2f МБ/с", cgroup.readBytesPerSec / (1024.0 * 1024.0));
+        std::snprintf(write, sizeof(write), "%.2f МБ/с", cgroup.writeBytesPerSec / (1024.0 * 1024.0));
+        gtk_list_store_set(m_cgroupStore, &iter, 0, cgroup.path, 1, cpu, 2, memory, 3, read, 4, write,
+                           5, static_cast<guint64>(cgroup.id), -1);
+        
+        if (m_selectedCgroup != 0 && m_selectedCgroup == cgroup.id) {
+            gtk_tree_selection_select_iter(m_cgroupSelection, &iter);
+        }
+    }
+    
+    // Лишние строки удаляем с конца
+    for (int i = rows - 1; i >= static_cast<int>(cgroups.size()); i--) {
+        if (gtk_tree_model_iter_nth_child(model, &iter, NULL, i)) {
+            gtk_list_store_remove(m_cgroupStore, &iter);
+        }
+    }
+    
+    if (m_selectedCgroupHistory) {
+        m_cgroupGraph->redraw();
+    }
+}
+
+// Duration for the diagnostics table, e.g. "850 мкс" or "12.5 мс"
+static void formatDuration(char* text, std::size_t size, std::uint64_t ns) {
+    if (ns < 1000000) {
+        std::snprintf(text, size, "%.0f мкс", ns / 1e3);
+    } else {
+        std::snprintf(text, size, "%.1f мс", ns / 1e6);
+    }
+}
+
+void MainWindow::updateDiagnostics() {
+    char text[64];
+    std::snprintf(text, sizeof(text), "Монитор использует ЦП: %.2f%%", Diagnostics::processCPUPercent());
+    gtk_label_set_text(GTK_LABEL(m_selfCPULabel), text);
+    
+    GtkTreeModel* model = GTK_TREE_MODEL(m_diagnosticsStore);
+    GtkTreeIter iter;
+    for (std::size_t i = 0; i < kProbeCount; i++) {
+        if (!gtk_tree_model_iter_nth_child(model, &iter, NULL, static_cast<int>(i))) {
+            break;
+        }
+        ProbeStats stats = Diagnostics::stats(static_cast<Probe>(i));
+        char count[32];
+        char median[32];
+        char p99[32];
+        char maximum[32];
+        char allocations[48];
+        std::snprintf(count, sizeof(count), "%llu", static_cast<unsigned long long>(stats.latency.count));
+        formatDuration(median, sizeof(median), stats.latency.percentileNs(0.5));
+        formatDuration(p99, sizeof(p99), stats.latency.percentileNs(0.99));
+        formatDuration(maximum, sizeof(maximum), stats.latency.maxNs);
+        std::snprintf(allocations, sizeof(allocations), "%llu / %llu",
+                      static_cast<unsigned long long>(stats.lastAllocations),
+                      static_cast<unsigned long long>(stats.maxAllocations));
+        gtk_list_store_set(m_diagnosticsStore, &iter, 1, count, 2, median, 3, p99, 4, maximum, 5, allocations, -1);
+    }
+}
+
+void MainWindow::updateDiskPanels(const std::vector<DiskInfo>& diskInfo) {
+    // Добавляем панели только для новых дисков, существующие лишь обновляем
+    std::size_t previous = m_diskPanels.size();
+    std::size_t matched = 0;
+    for (const auto& disk : diskInfo) {
+        auto it = m_diskPanels.find(disk.mountpoint);
+        if (it == m_diskPanels.end()) {
+            ResourceGraph* diskGraph = new ResourceGraph();
+            std::string title = "Диск: " + disk.mountpoint;
+            diskGraph->setTitle(title);
+            
+            // Устанавливаем разные цвета для разных дисков
+            // Используем хеш от имени диска для получения уникального цвета
+            size_t hash = std::hash<std::string>{}(disk.mountpoint);
+            double r = 0.3 + (hash % 100) / 200.0;
+            double g = 0.4 + ((hash / 100) % 100) / 200.0;
+            double b = 0.5 + ((hash / 10000) % 100) / 200.0;
+            diskGraph->setColor(r, g, b);
+            
+            // Устанавливаем источник данных; история живёт, пока её держит график
+            std::shared_ptr<RollupHistory> usage = m_resourceMonitor->getDiskHistory(disk.mountpoint);
+            diskGraph->setDataSource(usage.get());
+            if (usage) {
+                m_graphHistories[diskGraph] = {std::shared_ptr<HistoryData>(usage, usage->raw())};
+            }
+            diskGraph->setTimeRange(m_timeRange);
+            diskGraph->setScrollMode(true);
+            m_diskGraphs[disk.mountpoint] = diskGraph;
+            
+            // Чтение закрашено, запись линией
+            ResourceGraph* ioGraph = new ResourceGraph();
+            ioGraph->setTitle("Чтение / запись: " + disk.mountpoint);
+            ioGraph->setColor(r, g, b);
+            ioGraph->setSecondaryColor(1.0, 0.6, 0.2);
+            ioGraph->setValueFormat(ResourceGraph::ValueFormat::BytesPerSecond);
+            std::shared_ptr<HistoryData> read = m_resourceMonitor->getDiskReadHistory(disk.mountpoint);
+            std::shared_ptr<HistoryData> write = m_resourceMonitor->getDiskWriteHistory(disk.mountpoint);
+            ioGraph->setDataSource(read.get());
+            ioGraph->setSecondaryDataSource(write.get());
+            m_graphHistories[ioGraph] = {read, write};
+            ioGraph->setTimeRange(m_timeRange);
+            m_diskIOGraphs[disk.mountpoint] = ioGraph;
+            
+            DiskGraphPanel* panel = new DiskGraphPanel(disk.mountpoint, disk.device, diskGraph, ioGraph);
+            gtk_box_pack_start(GTK_BOX(m_diskBox), panel->getWidget(), TRUE, TRUE, 5);
+            it = m_diskPanels.emplace(disk.mountpoint, panel).first;
+        } else {
+            matched++;
+        }
+        
+        // Обновляем информацию о диске и график
+        double totalGB = disk.total / (1024.0 * 1024.0 * 1024.0);
+        double usedGB = disk.used / (1024.0 * 1024.0 * 1024.0);
+        it->second->updateInfo(usedGB, totalGB, disk.percent);
+        it->second->updateIO(disk.readOpsPerSec, disk.writeOpsPerSec, disk.awaitMs, disk.ioUtilization);
+        it->second->getGraph()->redraw();
+        it->second->getIOGraph()->redraw();
+    }
+    
+    // Удаляем диски, которые больше не доступны. Если все старые панели
+    // нашлись в текущем списке, удалять нечего и обход не нужен.
+    if (matched < previous) {
+        for (auto it = m_diskPanels.begin(); it != m_diskPanels.end();) {
+            bool present = std::any_of(diskInfo.begin(), diskInfo.end(),
+                [&](const DiskInfo& disk) { return disk.mountpoint == it->first; });
+            if (present) {
+                ++it;
+                continue;
+            }
+            
+            // Уничтожение контейнера панели уничтожает и виджет графика
+            gtk_widget_destroy(it->second->getWidget());
+            delete it->second;
+            m_graphHistories.erase(m_diskGraphs[it->first]);
+            delete m_diskGraphs[it->first];
+            m_diskGraphs.erase(it->first);
+            m_graphHistories.erase(m_diskIOGraphs[it->first]);
+            delete m_diskIOGraphs[it->first];
+            m_diskIOGraphs.erase(it->first);
+            it = m_diskPanels.erase(it);
+        }
+    }
+    
+    // Если нет доступных дисков, показываем сообщение
+    if (diskInfo.empty()) {
+        gtk_widget_show(m_noDisksLabel);
+    } else {
+        gtk_widget_hide(m_noDisksLabel);
+    }
+}
+
+void MainWindow::updateNetworkPanels(const std::vector<NetworkInfo>& networkInfo) {
+    // Как и для дисков, графики создаются только для новых интерфейсов
+    std::size_t previous = m_networkGraphs.size();
+    std::size_t matched = 0;
+    for (const auto& info : networkInfo) {
+        auto it = m_networkGraphs.find(info.name);
+        if (it == m_networkGraphs.end()) {
+            std::shared_ptr<HistoryData> rx = m_resourceMonitor->getNetworkRxHistory(info.name);
+            std::shared_ptr<HistoryData> tx = m_resourceMonitor->getNetworkTxHistory(info.name);
+            if (!rx || !tx) {
+                continue;
+            }
+            
+            ResourceGraph* graph = new ResourceGraph();
+            graph->setTitle(std::string("Приём / передача: ") + info.name);
+            graph->setColor(0.3, 0.8, 0.4);
+            graph->setSecondaryColor(1.0, 0.6, 0.2);
+            graph->setValueFormat(ResourceGraph::ValueFormat::BytesPerSecond);
+            graph->setDataSource(rx.get());
+            graph->setSecondaryDataSource(tx.get());
+            graph->setTimeRange(m_timeRange);
+            m_graphHistories[graph] = {rx, tx};
+            
+            GtkWidget* frame = createGraphContainer(info.name, graph);
+            gtk_box_pack_start(GTK_BOX(m_networkBox), frame, TRUE, TRUE, 5);
+            gtk_widget_show_all(frame);
+            m_networkFrames[info.name] = frame;
+            it = m_networkGraphs.emplace(info.name, graph).first;
+        } else {
+            matched++;
+        }
+        it->second->redraw();
+    }
+    
+    // Удаляем графики исчезнувших интерфейсов
+    if (matched < previous) {
+        for (auto it = m_networkGraphs.begin(); it != m_networkGraphs.end();) {
+            bool present = std::any_of(networkInfo.begin(), networkInfo.end(),
+                [&](const NetworkInfo& info) { return it->first == info.name; });
+            if (present) {
+                ++it;
+                continue;
+            }
+            
+            gtk_widget_destroy(m_networkFrames[it->first]);
+            m_networkFrames.erase(it->first);
+            m_graphHistories.erase(it->second);
+            delete it->second;
+            it = m_networkGraphs.erase(it);
+        }
+    }
+    
+    if (m_networkGraphs.empty()) {
+        gtk_widget_show(m_noNetworkLabel);
+    } else {
+        gtk_widget_hide(m_noNetworkLabel);
     }
 }
 
@@ -446,8 +1043,75 @@ void MainWindow::onNotificationCooldownChanged(GtkSpinButton* spinner, gpointer
     window->m_settings->setNotificationCooldown(value);
 }
 
+void MainWindow::onDiskPollIntervalChanged(GtkSpinButton* spinner, gpointer user_data) {
+    MainWindow* window = static_cast<MainWindow*>(user_data);
+    int value = static_cast<int>(gtk_spin_button_get_value(spinner));
+    window->m_settings->setDiskPollInterval(value);
+}
+
+void MainWindow::onPressureThresholdChanged(GtkSpinButton* spinner, gpointer user_data) {
+    MainWindow* window = static_cast<MainWindow*>(user_data);
+    int value = static_cast<int>(gtk_spin_button_get_value(spinner));
+    window->m_settings->setPressureThreshold(value);
+}
+
+void MainWindow::onCgroupSelectionChanged(GtkTreeSelection* selection, gpointer user_data) {
+    MainWindow* window = static_cast<MainWindow*>(user_data);
+    
+    GtkTreeModel* model;
+    GtkTreeIter iter;
+    if (!gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        return;     // График остаётся на последней выбранной группе
+    }
+    gchar* path = NULL;
+    guint64 id = 0;
+    gtk_tree_model_get(model, &iter, 0, &path, 5, &id, -1);
+    if (!path) {
+        return;
+    }
+    
+    if (window->m_selectedCgroup != id) {
+        window->m_selectedCgroup = id;
+        window->m_selectedCgroupHistory = window->m_resourceMonitor->getCgroupCPUHistory(static_cast<std::uint64_t>(id));
+        window->m_cgroupGraph->setTitle(std::string("ЦП группы ") + path);
+        window->m_cgroupGraph->setDataSource(window->m_selectedCgroupHistory.get());
+        window->m_cgroupGraph->redraw();
+    }
+    g_free(path);
+}
+
+void MainWindow::onTimeRangeChanged(GtkComboBox* combo, gpointer user_data) {
+    MainWindow* window = static_cast<MainWindow*>(user_data);
+    const gchar* id = gtk_combo_box_get_active_id(combo);
+    if (!id) {
+        return;
+    }
+    window->m_timeRange = std::stod(id);
+    
+    // Графики сами выбирают уровень агрегации под период
+    for (auto* graph : window->m_resourceGraphs) {
+        graph->setTimeRange(window->m_timeRange);
+        graph->redraw();
+    }
+    for (auto& pair : window->m_diskGraphs) {
+        pair.second->setTimeRange(window->m_timeRange);
+        pair.second->redraw();
+    }
+    for (auto& pair : window->m_diskIOGraphs) {
+        pair.second->setTimeRange(window->m_timeRange);
+        pair.second->redraw();
+    }
+    for (auto& pair : window->m_networkGraphs) {
+        pair.second->setTimeRange(window->m_timeRange);
+        pair.second->redraw();
+    }
+}
+
 void MainWindow::onSaveSettingsClicked(GtkButton* /*button*/, gpointer user_data) {
     MainWindow* window = static_cast<MainWindow*>(user_data);
+    
+    // Изменённый вручную файл правил подхватывается при сохранении
+    window->reloadAlertRules();
     if (window->m_settings->save()) {
         gtk_statusbar_pop(GTK_STATUSBAR(window->m_statusBar), window->m_statusBarContextId);
         gtk_statusbar_push(GTK_STATUSBAR(window->m_statusBar), window->m_statusBarContextId, "Настройки успешно сохранены");
@@ -465,12 +1129,16 @@ void MainWindow::onResetSettingsClicked(GtkButton* /*button*/, gpointer user_dat
     window->m_settings->setMemoryThreshold(85.0); // Новое значение по умолчанию
     window->m_settings->setDiskThreshold(90.0);
     window->m_settings->setNotificationCooldown(300); // Новое значение по умолчанию (5 минут)
+    window->m_settings->setDiskPollInterval(10);
+    window->m_settings->setPressureThreshold(10);
     
     // Update UI controls
     gtk_range_set_value(GTK_RANGE(window->m_cpuThresholdScale), 85.0);
     gtk_range_set_value(GTK_RANGE(window->m_memoryThresholdScale), 85.0);
     gtk_range_set_value(GTK_RANGE(window->m_diskThresholdScale), 90.0);
     gtk_spin_button_set_value(GTK_SPIN_BUTTON(window->m_notificationCooldownSpinner), 300);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(window->m_diskPollIntervalSpinner), 10);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(window->m_pressureThresholdSpinner), 10);
     
     gtk_statusbar_pop(GTK_STATUSBAR(window->m_statusBar), window->m_statusBarContextId);
     gtk_statusbar_push(GTK_STATUSBAR(window->m_statusBar), window->m_statusBarContextId, "Настройки сброшены по умолчанию");
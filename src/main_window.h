@@ -6,14 +6,24 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <atomic>
+#include <chrono>
 #include "resource_monitor.h"
+#include "alert_engine.h"
 #include "notification_manager.h"
 #include "settings.h"
 #include "resource_graphs.h"
+#include "sampler.h"
+#include "pressure_triggers.h"
+#include "metrics_exporter.h"
+#include "diagnostics.h"
+#include "trace.h"
 
 class MainWindow {
 public:
-    MainWindow();
+    // With a trace path, show a replay of it at `replaySpeed` times the
+    // recorded rate instead of this machine
+    explicit MainWindow(const std::string& replayPath = std::string(), int replaySpeed = 100);
     ~MainWindow();
     
     bool initialize();
@@ -25,8 +35,36 @@ private:
     // Resource monitoring tab
     GtkWidget* m_monitoringPage;
     std::vector<ResourceGraph*> m_resourceGraphs;
+    CPUHeatmap* m_cpuHeatmap; // Тепловая карта загрузки ядер
     std::map<std::string, ResourceGraph*> m_diskGraphs; // Графики для дисков
+    std::map<std::string, ResourceGraph*> m_diskIOGraphs; // Графики ввода-вывода дисков
     std::map<std::string, DiskGraphPanel*> m_diskPanels; // Панели с графиками дисков
+    GtkWidget* m_diskBox;       // Контейнер панелей дисков
+    GtkWidget* m_noDisksLabel;  // Сообщение, когда дисков нет
+    std::map<std::string, ResourceGraph*> m_networkGraphs; // Графики интерфейсов
+    std::map<std::string, GtkWidget*> m_networkFrames;     // Рамки с графиками интерфейсов
+    std::map<ResourceGraph*, std::vector<std::shared_ptr<HistoryData>>> m_graphHistories; // Держат истории, пока их показывают графики
+    GtkWidget* m_networkBox;        // Контейнер графиков сети
+    GtkWidget* m_noNetworkLabel;    // Сообщение, когда интерфейсов нет
+    GtkWidget* m_timeRangeCombo; // Выбор отображаемого периода
+    double m_timeRange;         // Отображаемый период графиков, секунды
+    
+    // Processes tab
+    GtkWidget* m_processesPage;
+    GtkListStore* m_processStore;   // Строки переиспользуются между обновлениями
+    
+    // Cgroups tab
+    GtkWidget* m_cgroupsPage;
+    GtkListStore* m_cgroupStore;
+    GtkTreeSelection* m_cgroupSelection;
+    ResourceGraph* m_cgroupGraph;   // ЦП выбранной группы
+    std::uint64_t m_selectedCgroup;     // CgroupInfo::id, 0 до первого выбора
+    std::shared_ptr<HistoryData> m_selectedCgroupHistory;  // Держит историю, пока её показывает график
+    
+    // Diagnostics tab
+    GtkWidget* m_diagnosticsPage;
+    GtkListStore* m_diagnosticsStore;   // Строка на каждый Probe
+    GtkWidget* m_selfCPULabel;
     
     // Settings tab
     GtkWidget* m_settingsPage;
@@ -34,6 +72,8 @@ private:
     GtkWidget* m_memoryThresholdScale;
     GtkWidget* m_diskThresholdScale;
     GtkWidget* m_notificationCooldownSpinner;
+    GtkWidget* m_diskPollIntervalSpinner;
+    GtkWidget* m_pressureThresholdSpinner;
     
     // Status bar
     GtkWidget* m_statusBar;
@@ -41,8 +81,22 @@ private:
     
     // Core components
     std::unique_ptr<Settings> m_settings;
+    std::string m_replayPath;
+    int m_replaySpeed;
+    std::unique_ptr<TraceReplayer> m_traceReplayer;    // Declared before the monitor that reads its root
     std::unique_ptr<ResourceMonitor> m_resourceMonitor;
     std::unique_ptr<NotificationManager> m_notificationManager;
+    std::unique_ptr<AlertEngine> m_alertEngine;
+    std::vector<std::string> m_alertRules;  // As last compiled
+    std::vector<std::string> m_alertFileRules;  // Rules file as last read
+    std::string m_alertRulesPath;           // Path it was read from
+    std::vector<AlertEvent> m_alertEvents;  // Reused between updates
+    std::map<std::string, std::chrono::steady_clock::time_point> m_lastAlertTimes;  // By AlertEvent::key, within the cooldown only
+    std::unique_ptr<MetricsExporter> m_metricsExporter;    // Declared before the sampler that renders into it
+    std::unique_ptr<Sampler> m_sampler;     // Declared after the monitor, so stopped before it is destroyed
+    std::unique_ptr<PressureTriggers> m_pressureTriggers;
+    int m_pressureThreshold;                // Threshold the triggers were registered with
+    std::atomic<unsigned> m_pendingPressure; // Bit per PressureResource fired since the last idle callback
     
     // Timer for periodic updates
     guint m_updateTimerId;
@@ -53,6 +107,15 @@ private:
     // Create the resource monitoring tab
     GtkWidget* createMonitoringTab();
     
+    // Create the processes tab
+    GtkWidget* createProcessesTab();
+    
+    // Create the cgroups tab
+    GtkWidget* createCgroupsTab();
+    
+    // Create the diagnostics tab
+    GtkWidget* createDiagnosticsTab();
+    
     // Create the settings tab
     GtkWidget* createSettingsTab();
     
@@ -62,8 +125,39 @@ private:
     // Update timer callback
     static gboolean onUpdateTimer(gpointer user_data);
     
-    // Update UI with current resource usage
-    void updateUI();
+    // Sampling interval in ms, shortened by the replay speed
+    int samplerInterval() const;
+    
+    // (Re)register the PSI triggers with the current threshold
+    void startPressureTriggers();
+    
+    // Recompile the alert rules if the thresholds or the rules file changed
+    // Compile the built-in rules and the rules file as last read, if they
+    // changed; reloadAlertRules() reads the file again first
+    void compileAlertRules();
+    void reloadAlertRules();
+    
+    // Idle callback on the GTK thread after a PSI trigger fired
+    static gboolean onPressureTriggered(gpointer user_data);
+    
+    // Update UI with the latest sampler snapshot
+    void updateUI(const ResourceSnapshot& snapshot);
+    
+    // Show the top processes, reusing the existing rows
+    void updateProcessList(const std::vector<ProcessInfo>& processes);
+    
+    // Show the busiest cgroups and keep the selected one highlighted
+    void updateCgroupList(const std::vector<CgroupInfo>& cgroups);
+    
+    // Show the monitor's own latencies and allocations
+    void updateDiagnostics();
+    
+    // Add or remove disk panels when the mount set changes, otherwise only
+    // refresh their labels and graphs
+    void updateDiskPanels(const std::vector<DiskInfo>& diskInfo);
+    
+    // Same for the network interface graphs
+    void updateNetworkPanels(const std::vector<NetworkInfo>& networkInfo);
     
     // Window destruction callback
     static void onWindowDestroy(GtkWidget* widget, gpointer data);
@@ -73,6 +167,10 @@ private:
     static void onMemoryThresholdChanged(GtkRange* range, gpointer user_data);
     static void onDiskThresholdChanged(GtkRange* range, gpointer user_data);
     static void onNotificationCooldownChanged(GtkSpinButton* spinner, gpointer user_data);
+    static void onDiskPollIntervalChanged(GtkSpinButton* spinner, gpointer user_data);
+    static void onPressureThresholdChanged(GtkSpinButton* spinner, gpointer user_data);
+    static void onTimeRangeChanged(GtkComboBox* combo, gpointer user_data);
+    static void onCgroupSelectionChanged(GtkTreeSelection* selection, gpointer user_data);
     
     // Button callbacks
     static void onSaveSettingsClicked(GtkButton* button, gpointer user_data);
@@ -0,0 +1,541 @@
+#include "metrics_exporter.h"
+#include "diagnostics.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// Clients beyond this are closed right after accept()
+static const std::size_t kMaxConnections = 64;
+
+// A request must arrive and its response leave within this time
+static const std::chrono::seconds kConnectionTimeout(10);
+
+// Longest request accepted; scrapes send a few hundred bytes
+static const std::size_t kMaxRequestBytes = 8192;
+
+// Append `value` as a label value, escaped as the exposition format requires
+static void appendEscaped(std::string& out, const char* value) {
+    for (const char* c = value; *c; c++) {
+        if (*c == '\\') {
+            out += "\\\\";
+        } else if (*c == '"') {
+            out += "\\\"";
+        } else if (*c == '\n') {
+            out += "\\n";
+        } else {
+            out += *c;
+        }
+    }
+}
+
+static void appendValue(std::string& out, double value) {
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), " %.15g\n", value);
+    out.append(text, length);
+}
+
+static void appendFamily(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+static void appendSample(std::string& out, const char* name, double value) {
+    out += name;
+    appendValue(out, value);
+}
+
+static void appendSample(std::string& out, const char* name, const char* label, const char* labelValue,
+                         double value) {
+    out += name;
+    out += '{';
+    out += label;
+    out += "=\"";
+    appendEscaped(out, labelValue);
+    out += "\"}";
+    appendValue(out, value);
+}
+
+static void appendSample(std::string& out, const char* name, const char* label1, const char* value1,
+                         const char* label2, const char* value2, double value) {
+    out += name;
+    out += '{';
+    out += label1;
+    out += "=\"";
+    appendEscaped(out, value1);
+    out += "\",";
+    out += label2;
+    out += "=\"";
+    appendEscaped(out, value2);
+    out += "\"}";
+    appendValue(out, value);
+}
+
+// Window statistics of a raw series, one sample per statistic
+static void appendWindowStats(std::string& out, const char* name, const HistoryData* history) {
+    if (!history || history->getSize() == 0) {
+        return;
+    }
+    HistoryStats stats = history->getStats();
+    appendSample(out, name, "stat", "average", stats.average);
+    appendSample(out, name, "stat", "minimum", stats.minimum);
+    appendSample(out, name, "stat", "maximum", stats.maximum);
+    appendSample(out, name, "stat", "stddev", stats.stddev);
+    appendSample(out, name, "stat", "ewma", stats.ewma);
+}
+
+// Cumulative buckets of one probe, as a Prometheus histogram
+static void appendSelfHistogram(std::string& out, Probe probe) {
+    const char* name = Diagnostics::probeName(probe);
+    LatencyHistogram::Snapshot latency = Diagnostics::stats(probe).latency;
+    char bound[32];
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; i + 1 < LatencyHistogram::kBucketCount; i++) {
+        cumulative += latency.counts[i];
+        std::snprintf(bound, sizeof(bound), "%g", LatencyHistogram::bucketBoundNs(i) / 1e9);
+        appendSample(out, "sysmon_self_duration_seconds_bucket", "probe", name, "le", bound,
+                     static_cast<double>(cumulative));
+    }
+    appendSample(out, "sysmon_self_duration_seconds_bucket", "probe", name, "le", "+Inf",
+                 static_cast<double>(latency.count));
+    appendSample(out, "sysmon_self_duration_seconds_sum", "probe", name, latency.sumNs / 1e9);
+    appendSample(out, "sysmon_self_duration_seconds_count", "probe", name, static_cast<double>(latency.count));
+}
+
+MetricsExporter::MetricsExporter()
+    : m_listenFd(-1),
+      m_wakeFd(-1)
+{
+    // The socket is opened in start()
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start(const std::string& address) {
+    stop();
+
+    if (!address.empty() && address[0] == '/') {
+        struct sockaddr_un local = {};
+        local.sun_family = AF_UNIX;
+        if (address.size() >= sizeof(local.sun_path)) {
+            std::cerr << "Metrics socket path is too long: " << address << std::endl;
+            return false;
+        }
+        std::memcpy(local.sun_path, address.c_str(), address.size() + 1);
+
+        // A socket left behind by a previous run would make bind() fail
+        struct stat existing;
+        if (lstat(address.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+            unlink(address.c_str());
+        }
+
+        m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_listenFd < 0 || bind(m_listenFd, reinterpret_cast<struct sockaddr*>(&local), sizeof(local)) < 0) {
+            std::cerr << "Failed to bind metrics socket " << address << ": " << std::strerror(errno) << std::endl;
+            stop();
+            return false;
+        }
+        m_unixPath = address;
+    } else {
+        // "port" or "host:port"; only loopback hosts, the metrics are not authenticated
+        std::string host = "127.0.0.1";
+        std::string port = address;
+        std::size_t colon = address.rfind(':');
+        if (colon != std::string::npos) {
+            host = address.substr(0, colon);
+            port = address.substr(colon + 1);
+        }
+
+        struct sockaddr_in loopback = {};
+        loopback.sin_family = AF_INET;
+        char* end = nullptr;
+        long number = std::strtol(port.c_str(), &end, 10);
+        if (port.empty() || *end != '\0' || number <= 0 || number > 65535 ||
+            inet_pton(AF_INET, host.c_str(), &loopback.sin_addr) != 1 ||
+            (ntohl(loopback.sin_addr.s_addr) >> 24) != 127) {
+            std::cerr << "Invalid metrics address, expected a loopback port or a socket path: " << address << std::endl;
+            return false;
+        }
+        loopback.sin_port = htons(static_cast<std::uint16_t>(number));
+
+        m_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int reuse = 1;
+        if (m_listenFd < 0 ||
+            setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0 ||
+            bind(m_listenFd, reinterpret_cast<struct sockaddr*>(&loopback), sizeof(loopback)) < 0) {
+            std::cerr << "Failed to bind metrics port " << address << ": " << std::strerror(errno) << std::endl;
+            stop();
+            return false;
+        }
+    }
+
+    if (listen(m_listenFd, SOMAXCONN) < 0) {
+        std::cerr << "Failed to listen for metrics scrapes: " << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+
+    m_wakeFd = eventfd(0, EFD_CLOEXEC);
+    if (m_wakeFd < 0) {
+        stop();
+        return false;
+    }
+
+    m_thread = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (m_thread.joinable()) {
+        std::uint64_t one = 1;
+        if (::write(m_wakeFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Failed to wake the metrics server: " << std::strerror(errno) << std::endl;
+        }
+        m_thread.join();
+    }
+    for (const Connection& connection : m_connections) {
+        ::close(connection.fd);
+    }
+    m_connections.clear();
+
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+    if (m_listenFd >= 0) {
+        ::close(m_listenFd);
+        m_listenFd = -1;
+    }
+    if (!m_unixPath.empty()) {
+        unlink(m_unixPath.c_str());
+        m_unixPath.clear();
+    }
+}
+
+bool MetricsExporter::isRunning() const {
+    return m_thread.joinable();
+}
+
+void MetricsExporter::render(const ResourceSnapshot& snapshot, const ResourceMonitor& monitor) {
+    ScopedProbe probe(Probe::MetricsRender);
+    
+    // Reuse the spare buffer unless a slow client is still sending it
+    if (!m_spare || m_spare.use_count() > 1) {
+        m_spare = std::make_shared<Response>();
+    }
+    std::string& out = m_spare->body;
+    out.clear();    // Keeps the capacity of the previous render
+
+    char label[32];
+
+    appendFamily(out, "sysmon_samples_total", "counter", "Samples taken since the monitor started.");
+    appendSample(out, "sysmon_samples_total", static_cast<double>(snapshot.sequence));
+
+    appendFamily(out, "sysmon_cpu_usage_percent", "gauge", "CPU usage of all cores.");
+    appendSample(out, "sysmon_cpu_usage_percent", snapshot.cpuUsage);
+
+    appendFamily(out, "sysmon_cpu_usage_window_percent", "gauge", "CPU usage statistics over the raw history window.");
+    appendWindowStats(out, "sysmon_cpu_usage_window_percent", monitor.getCPUHistory()->raw());
+
+    appendFamily(out, "sysmon_cpu_core_usage_percent", "gauge", "CPU usage per core.");
+    for (std::size_t i = 0; i < snapshot.coreUsage.size(); i++) {
+        std::snprintf(label, sizeof(label), "%zu", i);
+        appendSample(out, "sysmon_cpu_core_usage_percent", "core", label, snapshot.coreUsage[i]);
+    }
+
+    const MemoryInfo& memory = snapshot.memInfo;
+    appendFamily(out, "sysmon_memory_total_bytes", "gauge", "Total memory.");
+    appendSample(out, "sysmon_memory_total_bytes", static_cast<double>(memory.total * 1024));
+    appendFamily(out, "sysmon_memory_used_bytes", "gauge", "Memory in use.");
+    appendSample(out, "sysmon_memory_used_bytes", static_cast<double>(memory.used * 1024));
+    appendFamily(out, "sysmon_memory_available_bytes", "gauge", "Memory available for new allocations.");
+    appendSample(out, "sysmon_memory_available_bytes", static_cast<double>(memory.available * 1024));
+    appendFamily(out, "sysmon_memory_usage_percent", "gauge", "Memory usage.");
+    appendSample(out, "sysmon_memory_usage_percent", memory.percent);
+    appendFamily(out, "sysmon_memory_usage_window_percent", "gauge", "Memory usage statistics over the raw history window.");
+    appendWindowStats(out, "sysmon_memory_usage_window_percent", monitor.getMemoryHistory()->raw());
+
+    appendFamily(out, "sysmon_disk_usage_percent", "gauge", "Filesystem usage per mount.");
+    for (const DiskInfo& disk : snapshot.diskInfo) {
+        appendSample(out, "sysmon_disk_usage_percent", "mountpoint", disk.mountpoint.c_str(),
+                     "device", disk.device.c_str(), disk.percent);
+    }
+    appendFamily(out, "sysmon_disk_available_bytes", "gauge", "Filesystem space available per mount.");
+    for (const DiskInfo& disk : snapshot.diskInfo) {
+        appendSample(out, "sysmon_disk_available_bytes", "mountpoint", disk.mountpoint.c_str(),
+                     "device", disk.device.c_str(), static_cast<double>(disk.available));
+    }
+    appendFamily(out, "sysmon_disk_read_bytes_per_second", "gauge", "Bytes read from the device behind a mount.");
+    for (const DiskInfo& disk : snapshot.diskInfo) {
+        appendSample(out, "sysmon_disk_read_bytes_per_second", "mountpoint", disk.mountpoint.c_str(),
+                     "device", disk.device.c_str(), disk.readBytesPerSec);
+    }
+    appendFamily(out, "sysmon_disk_write_bytes_per_second", "gauge", "Bytes written to the device behind a mount.");
+    for (const DiskInfo& disk : snapshot.diskInfo) {
+        appendSample(out, "sysmon_disk_write_bytes_per_second", "mountpoint", disk.mountpoint.c_str(),
+                     "device", disk.device.c_str(), disk.writeBytesPerSec);
+    }
+    appendFamily(out, "sysmon_disk_io_utilization_percent", "gauge", "Time the device behind a mount was busy.");
+    for (const DiskInfo& disk : snapshot.diskInfo) {
+        appendSample(out, "sysmon_disk_io_utilization_percent", "mountpoint", disk.mountpoint.c_str(),
+                     "device", disk.device.c_str(), disk.ioUtilization);
+    }
+
+    appendFamily(out, "sysmon_network_receive_bytes_per_second", "gauge", "Bytes received per interface.");
+    for (const NetworkInfo& interface : snapshot.networkInfo) {
+        appendSample(out, "sysmon_network_receive_bytes_per_second", "interface", interface.name, interface.rxBytesPerSec);
+    }
+    appendFamily(out, "sysmon_network_transmit_bytes_per_second", "gauge", "Bytes transmitted per interface.");
+    for (const NetworkInfo& interface : snapshot.networkInfo) {
+        appendSample(out, "sysmon_network_transmit_bytes_per_second", "interface", interface.name, interface.txBytesPerSec);
+    }
+
+    appendFamily(out, "sysmon_pressure_some_avg10_percent", "gauge", "Time some tasks stalled on a resource, 10 s average.");
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        appendSample(out, "sysmon_pressure_some_avg10_percent", "resource",
+                     PressureCollector::resourceName(static_cast<PressureResource>(i)), snapshot.pressure[i].someAvg10);
+    }
+    appendFamily(out, "sysmon_pressure_some_avg60_percent", "gauge", "Time some tasks stalled on a resource, 60 s average.");
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        appendSample(out, "sysmon_pressure_some_avg60_percent", "resource",
+                     PressureCollector::resourceName(static_cast<PressureResource>(i)), snapshot.pressure[i].someAvg60);
+    }
+    appendFamily(out, "sysmon_pressure_full_avg10_percent", "gauge", "Time all tasks stalled on a resource, 10 s average.");
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        appendSample(out, "sysmon_pressure_full_avg10_percent", "resource",
+                     PressureCollector::resourceName(static_cast<PressureResource>(i)), snapshot.pressure[i].fullAvg10);
+    }
+
+    appendFamily(out, "sysmon_process_cpu_percent", "gauge", "CPU usage of the busiest processes, of one CPU.");
+    for (const ProcessInfo& process : snapshot.topProcesses) {
+        std::snprintf(label, sizeof(label), "%d", process.pid);
+        appendSample(out, "sysmon_process_cpu_percent", "pid", label, "name", process.name, process.cpuPercent);
+    }
+    appendFamily(out, "sysmon_process_resident_bytes", "gauge", "Resident memory of the busiest processes.");
+    for (const ProcessInfo& process : snapshot.topProcesses) {
+        std::snprintf(label, sizeof(label), "%d", process.pid);
+        appendSample(out, "sysmon_process_resident_bytes", "pid", label, "name", process.name,
+                     static_cast<double>(process.rssBytes));
+    }
+
+    appendFamily(out, "sysmon_cgroup_cpu_percent", "gauge", "CPU usage of the busiest leaf cgroups, of one CPU.");
+    for (const CgroupInfo& cgroup : snapshot.topCgroups) {
+        appendSample(out, "sysmon_cgroup_cpu_percent", "cgroup", cgroup.path, cgroup.cpuPercent);
+    }
+    appendFamily(out, "sysmon_cgroup_memory_bytes", "gauge", "Memory charged to the busiest leaf cgroups.");
+    for (const CgroupInfo& cgroup : snapshot.topCgroups) {
+        appendSample(out, "sysmon_cgroup_memory_bytes", "cgroup", cgroup.path, static_cast<double>(cgroup.memoryBytes));
+    }
+
+    // The monitor's own cost, as of the previous render for this one
+    appendFamily(out, "sysmon_self_cpu_percent", "gauge", "CPU time used by the monitor process, of one CPU.");
+    appendSample(out, "sysmon_self_cpu_percent", Diagnostics::processCPUPercent());
+    appendFamily(out, "sysmon_self_duration_seconds", "histogram", "Time spent per collector, draw and UI pass.");
+    for (std::size_t i = 0; i < kProbeCount; i++) {
+        appendSelfHistogram(out, static_cast<Probe>(i));
+    }
+    appendFamily(out, "sysmon_self_allocations", "gauge", "C++ heap allocations in the latest run of a probe.");
+    for (std::size_t i = 0; i < kProbeCount; i++) {
+        Probe measured = static_cast<Probe>(i);
+        appendSample(out, "sysmon_self_allocations", "probe", Diagnostics::probeName(measured),
+                     static_cast<double>(Diagnostics::stats(measured).lastAllocations));
+    }
+
+    char header[160];
+    int length = std::snprintf(header, sizeof(header),
+                               "HTTP/1.1 200 OK\r\n"
+                               "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                               "Content-Length: %zu\r\n"
+                               "Connection: close\r\n\r\n",
+                               out.size());
+    m_spare->header.assign(header, length);
+
+    // Publish; the previous response becomes the next spare
+    std::lock_guard<std::mutex> lock(m_responseMutex);
+    std::shared_ptr<const Response> previous = std::move(m_current);
+    m_current = std::move(m_spare);
+    m_spare = std::const_pointer_cast<Response>(previous);
+}
+
+void MetricsExporter::run() {
+    std::vector<struct pollfd> fds;
+
+    for (;;) {
+        // Listener and wake fd first, then one slot per connection
+        fds.resize(2 + m_connections.size());
+        fds[0].fd = m_wakeFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = m_connections.size() < kMaxConnections ? m_listenFd : -1;
+        fds[1].events = POLLIN;
+        for (std::size_t i = 0; i < m_connections.size(); i++) {
+            fds[2 + i].fd = m_connections[i].fd;
+            fds[2 + i].events = m_connections[i].response ? POLLOUT : POLLIN;
+        }
+
+        // Wake at least once a second to expire stuck connections
+        int ready = poll(fds.data(), fds.size(), 1000);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Metrics poll failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if (fds[0].revents) {
+            return;
+        }
+
+        // Serve ready connections, dropping finished and expired ones in place
+        auto now = std::chrono::steady_clock::now();
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < m_connections.size(); i++) {
+            Connection& connection = m_connections[i];
+            bool open = true;
+            if (fds[2 + i].revents) {
+                open = serve(connection);
+            } else if (now - connection.started > kConnectionTimeout) {
+                ::close(connection.fd);
+                open = false;
+            }
+            if (open) {
+                if (kept != i) {
+                    m_connections[kept] = std::move(connection);
+                }
+                kept++;
+            }
+        }
+        m_connections.resize(kept);
+
+        if (fds[1].revents) {
+            acceptConnections();
+        }
+    }
+}
+
+void MetricsExporter::acceptConnections() {
+    for (;;) {
+        int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+                std::cerr << "Failed to accept a metrics scrape: " << std::strerror(errno) << std::endl;
+            }
+            return;
+        }
+        if (m_connections.size() >= kMaxConnections) {
+            ::close(fd);
+            continue;
+        }
+
+        Connection connection;
+        connection.fd = fd;
+        connection.requestTail = 0;
+        connection.sent = 0;
+        connection.started = std::chrono::steady_clock::now();
+        m_connections.push_back(std::move(connection));
+    }
+}
+
+bool MetricsExporter::serve(Connection& connection) {
+    if (!connection.response) {
+        // Every request gets the metrics, so only the end of the headers matters
+        static const char kEnd[] = "\r\n\r\n";
+        char buffer[1024];
+        std::size_t received = 0;
+        for (;;) {
+            ssize_t count = ::read(connection.fd, buffer, sizeof(buffer));
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            }
+            if (count <= 0) {
+                ::close(connection.fd);
+                return false;
+            }
+            received += count;
+
+            bool complete = false;
+            for (ssize_t i = 0; i < count && !complete; i++) {
+                if (buffer[i] == kEnd[connection.requestTail]) {
+                    complete = ++connection.requestTail == 4;
+                } else {
+                    connection.requestTail = buffer[i] == '\r' ? 1 : 0;
+                }
+            }
+            if (complete) {
+                break;
+            }
+            if (received > kMaxRequestBytes) {
+                ::close(connection.fd);
+                return false;
+            }
+        }
+
+        std::shared_ptr<const Response> current;
+        {
+            std::lock_guard<std::mutex> lock(m_responseMutex);
+            current = m_current;
+        }
+        if (!current) {
+            // Nothing sampled yet
+            static const std::shared_ptr<const Response> unavailable = std::make_shared<const Response>(Response{
+                "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", ""});
+            current = unavailable;
+        }
+        connection.response = std::move(current);
+    }
+
+    // Header and body leave together; sendmsg() rather than writev() for MSG_NOSIGNAL
+    const Response& response = *connection.response;
+    std::size_t total = response.header.size() + response.body.size();
+    while (connection.sent < total) {
+        struct iovec parts[2];
+        int count = 0;
+        if (connection.sent < response.header.size()) {
+            parts[count].iov_base = const_cast<char*>(response.header.data() + connection.sent);
+            parts[count].iov_len = response.header.size() - connection.sent;
+            count++;
+            parts[count].iov_base = const_cast<char*>(response.body.data());
+            parts[count].iov_len = response.body.size();
+            count++;
+        } else {
+            std::size_t offset = connection.sent - response.header.size();
+            parts[count].iov_base = const_cast<char*>(response.body.data() + offset);
+            parts[count].iov_len = response.body.size() - offset;
+            count++;
+        }
+
+        struct msghdr message = {};
+        message.msg_iov = parts;
+        message.msg_iovlen = count;
+        ssize_t written = sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            break;
+        }
+        connection.sent += written;
+    }
+
+    ::close(connection.fd);
+    return false;
+}
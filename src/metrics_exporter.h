@@ -0,0 +1,79 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "resource_monitor.h"
+
+// Serves the current values in the Prometheus text exposition format over
+// HTTP, on a loopback TCP port or a Unix socket.
+//
+// The whole response is rendered once per sample by render(), on the
+// sampling thread, into a buffer that is reused while no client is still
+// sending it. A scrape then costs a read() of the request and one gathered
+// sendmsg(..., MSG_NOSIGNAL) of the prepared header and body, however many
+// clients scrape; a client that hangs up mid-response gives EPIPE, not SIGPIPE.
+//
+// Connections are served by a single thread polling non-blocking sockets.
+class MetricsExporter {
+public:
+    MetricsExporter();
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // Listen on `address`: a path starting with '/' for a Unix socket, or
+    // a port, optionally "127.0.0.1:port", for loopback TCP
+    bool start(const std::string& address);
+
+    // Close the listener and all connections
+    void stop();
+
+    bool isRunning() const;
+
+    // Render the metrics of a sample. Call from the thread that samples the
+    // monitor, after fillSnapshot(); the histories are read without locks.
+    void render(const ResourceSnapshot& snapshot, const ResourceMonitor& monitor);
+
+private:
+    // Prepared HTTP response, header and body sent with one sendmsg()
+    struct Response {
+        std::string header;
+        std::string body;
+    };
+
+    // One client connection
+    struct Connection {
+        int fd;
+        std::size_t requestTail;                // Bytes of "\r\n\r\n" matched so far
+        std::shared_ptr<const Response> response;   // Set once the request is complete
+        std::size_t sent;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    int m_listenFd;
+    int m_wakeFd;                   // eventfd that ends the poll() in stop()
+    std::string m_unixPath;         // Unlinked in stop(), empty for TCP
+    std::thread m_thread;
+
+    std::mutex m_responseMutex;     // Guards m_current only
+    std::shared_ptr<const Response> m_current;
+    std::shared_ptr<Response> m_spare;  // Rendered into, then swapped with m_current
+
+    std::vector<Connection> m_connections;  // Server thread only
+
+    // Thread body
+    void run();
+    void acceptConnections();
+
+    // Advance a connection; false once it is finished and closed
+    bool serve(Connection& connection);
+};
+
+#endif // METRICS_EXPORTER_H
@@ -0,0 +1,40 @@
+#include "monitor_clock.h"
+#include <atomic>
+
+// Set by the replay thread, read by the sampling and UI threads. The two
+// values may be seen from different ticks for a moment, which only matters
+// within one sample.
+static std::atomic<bool> s_pinned(false);
+static std::atomic<std::int64_t> s_steadyNs(0);
+static std::atomic<std::int64_t> s_wallMillis(0);
+
+std::chrono::steady_clock::time_point MonitorClock::now() {
+    if (s_pinned.load(std::memory_order_acquire)) {
+        return std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::nanoseconds(s_steadyNs.load(std::memory_order_relaxed))));
+    }
+    return std::chrono::steady_clock::now();
+}
+
+std::int64_t MonitorClock::wallMillis() {
+    if (s_pinned.load(std::memory_order_acquire)) {
+        return s_wallMillis.load(std::memory_order_relaxed);
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void MonitorClock::pin(std::int64_t steadyNs, std::int64_t wallMillis) {
+    s_steadyNs.store(steadyNs, std::memory_order_relaxed);
+    s_wallMillis.store(wallMillis, std::memory_order_relaxed);
+    s_pinned.store(true, std::memory_order_release);
+}
+
+void MonitorClock::release() {
+    s_pinned.store(false, std::memory_order_release);
+}
+
+bool MonitorClock::isPinned() {
+    return s_pinned.load(std::memory_order_acquire);
+}
@@ -0,0 +1,26 @@
+#ifndef MONITOR_CLOCK_H
+#define MONITOR_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+// Time source for the collectors' rates and the history timestamps.
+//
+// Normally the system clocks. A trace replay pins it to the times of each
+// recorded tick, so rates and timestamps come out as they were recorded
+// whatever the replay speed. Time budgets and self-timing keep using
+// steady_clock directly: they measure our own cost, not the host's.
+class MonitorClock {
+public:
+    static std::chrono::steady_clock::time_point now();
+
+    // Wall-clock time in milliseconds since the epoch
+    static std::int64_t wallMillis();
+
+    // Pin both clocks until release(); steadyNs is since the steady_clock epoch
+    static void pin(std::int64_t steadyNs, std::int64_t wallMillis);
+    static void release();
+    static bool isPinned();
+};
+
+#endif // MONITOR_CLOCK_H
@@ -0,0 +1,99 @@
+#include "mount_table.h"
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <mntent.h>
+
+MountTable::MountTable()
+    : m_fd(-1),
+      m_dirty(true)
+{
+    // The first changed() call always reports a change
+}
+
+MountTable::~MountTable() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+bool MountTable::open(const char* mountinfoPath) {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+    m_fd = ::open(mountinfoPath, O_RDONLY | O_CLOEXEC);
+    m_dirty = true;
+    return m_fd >= 0;
+}
+
+bool MountTable::changed() {
+    if (m_dirty || m_fd < 0) {
+        return true;
+    }
+
+    // The kernel reports POLLPRI|POLLERR once per change of the mount
+    // namespace, and poll() itself re-arms it
+    struct pollfd pfd;
+    pfd.fd = m_fd;
+    pfd.events = POLLPRI;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR))) {
+        m_dirty = true;
+    }
+    return m_dirty;
+}
+
+bool MountTable::refresh(const char* mountsPath) {
+    FILE* mtab = setmntent(mountsPath, "r");
+    if (!mtab) {
+        std::cerr << "Failed to open " << mountsPath << std::endl;
+        return false;
+    }
+
+    m_entries.clear();
+
+    struct mntent* entry;
+    while ((entry = getmntent(mtab)) != nullptr) {
+        MountEntry mount;
+        mount.device = entry->mnt_fsname;
+        mount.mountpoint = entry->mnt_dir;
+        mount.fstype = entry->mnt_type;
+        if (isMonitored(mount.fstype, mount.device, mount.mountpoint)) {
+            m_entries.push_back(std::move(mount));
+        }
+    }
+
+    endmntent(mtab);
+    m_dirty = false;
+    return true;
+}
+
+const std::vector<MountEntry>& MountTable::entries() const {
+    return m_entries;
+}
+
+bool MountTable::isMonitored(const std::string& fstype, const std::string& device, const std::string& mountPoint) {
+    // Система фильтрации файловых систем
+    // 1. Пропускаем все стандартные виртуальные ФС
+    if (fstype == "proc" || fstype == "sysfs" || fstype == "devpts" ||
+        fstype == "tmpfs" || fstype == "cgroup" || fstype == "pstore" ||
+        fstype == "securityfs" || fstype == "devtmpfs" || fstype == "debugfs" ||
+        fstype == "hugetlbfs" || fstype == "mqueue" || fstype == "fusectl" ||
+        fstype.find("fuse") != std::string::npos) {
+        return false;
+    }
+
+    // 2. Пропускаем специфические системные разделы, которые могут вызвать лишние оповещения
+    if (mountPoint.find("/etc/nixmodules") != std::string::npos ||
+        mountPoint.find("/mnt/nixmodules") != std::string::npos ||
+        mountPoint.find("/nix/store") != std::string::npos ||
+        mountPoint.find("/nix") != std::string::npos ||
+        mountPoint.find("/run/user") != std::string::npos ||
+        device.find("tmpfs") != std::string::npos ||
+        device.find("overlay") != std::string::npos) {
+        return false;
+    }
+
+    return true;
+}
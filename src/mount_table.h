@@ -0,0 +1,48 @@
+#ifndef MOUNT_TABLE_H
+#define MOUNT_TABLE_H
+
+#include <string>
+#include <vector>
+
+struct MountEntry {
+    std::string device;
+    std::string mountpoint;
+    std::string fstype;
+};
+
+// Cached, filtered list of mounted filesystems.
+//
+// The kernel flags /proc/self/mountinfo with POLLPRI whenever the mount table
+// of our namespace changes, so changed() is a zero-timeout poll() instead of
+// reparsing the table; refresh() only runs when something was mounted or
+// unmounted. Without mountinfo (no /proc) every call reports a change.
+class MountTable {
+public:
+    MountTable();
+    ~MountTable();
+
+    MountTable(const MountTable&) = delete;
+    MountTable& operator=(const MountTable&) = delete;
+
+    // Start watching for mount changes
+    bool open(const char* mountinfoPath = "/proc/self/mountinfo");
+
+    // Check whether the mount set may have changed since the last refresh()
+    bool changed();
+
+    // Re-read the mount table and apply the filter
+    bool refresh(const char* mountsPath = "/etc/mtab");
+
+    // Monitored mounts as of the last refresh()
+    const std::vector<MountEntry>& entries() const;
+
+    // Filter for physical, user-relevant filesystems
+    static bool isMonitored(const std::string& fstype, const std::string& device, const std::string& mountpoint);
+
+private:
+    int m_fd;
+    bool m_dirty;
+    std::vector<MountEntry> m_entries;
+};
+
+#endif // MOUNT_TABLE_H
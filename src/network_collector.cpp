@@ -0,0 +1,161 @@
+#include "network_collector.h"
+#include "monitor_clock.h"
+#include <cstring>
+
+// Column of each counter among the 16 numbers of a /proc/net/dev line
+static const int kCounterColumns[] = {0, 1, 2, 3, 8, 9, 10, 11};
+
+NetworkCollector::NetworkCollector()
+    : m_file(256 * 1024),
+      m_lastUpdate(MonitorClock::now())
+{
+    // Room for about two thousand interfaces
+}
+
+bool NetworkCollector::open(const char* path) {
+    m_lastUpdate = MonitorClock::now();
+    return m_file.open(path);
+}
+
+bool NetworkCollector::isOpen() const {
+    return m_file.isOpen();
+}
+
+void NetworkCollector::setExcludedPrefixes(const std::vector<std::string>& prefixes) {
+    m_excluded = prefixes;
+
+    // Drop interfaces that are excluded now; they are not re-added below
+    for (std::size_t i = 0; i < m_info.size();) {
+        if (isExcluded(m_info[i].name, std::strlen(m_info[i].name))) {
+            m_info.erase(m_info.begin() + i);
+            m_states.erase(m_states.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+bool NetworkCollector::isExcluded(const char* name, std::size_t length) const {
+    for (const std::string& prefix : m_excluded) {
+        if (length >= prefix.size() && std::memcmp(name, prefix.data(), prefix.size()) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NetworkCollector::update() {
+    using namespace ProcParse;
+
+    if (!m_file.read()) {
+        return false;
+    }
+
+    auto now = MonitorClock::now();
+    double elapsed = std::chrono::duration<double>(now - m_lastUpdate).count();
+    m_lastUpdate = now;
+
+    for (State& state : m_states) {
+        state.seen = false;
+    }
+
+    // Two header lines, then "  name: 16 counters"
+    const char* end = m_file.end();
+    const char* p = nextLine(nextLine(m_file.data(), end), end);
+    std::size_t expected = 0;
+    for (; p < end; p = nextLine(p, end)) {
+        const char* name = skipSpaces(p, end);
+        const char* colon = name;
+        while (colon < end && *colon != ':' && *colon != '\n') {
+            colon++;
+        }
+        if (colon >= end || *colon != ':') {
+            continue;
+        }
+        std::size_t length = static_cast<std::size_t>(colon - name);
+        if (length == 0 || length >= sizeof(NetworkInfo::name) || isExcluded(name, length)) {
+            continue;
+        }
+
+        unsigned long long columns[16];
+        const char* q = colon + 1;
+        for (auto& column : columns) {
+            q = parseUnsigned(q, end, column);
+        }
+
+        // Interfaces keep their order between reads, so try the next slot first
+        std::size_t index = expected;
+        if (index >= m_info.size() || std::strncmp(m_info[index].name, name, length) != 0 ||
+            m_info[index].name[length] != '\0') {
+            for (index = 0; index < m_info.size(); index++) {
+                if (std::strncmp(m_info[index].name, name, length) == 0 && m_info[index].name[length] == '\0') {
+                    break;
+                }
+            }
+        }
+
+        bool fresh = index == m_info.size();
+        if (fresh) {
+            NetworkInfo info{};
+            std::memcpy(info.name, name, length);
+            info.name[length] = '\0';
+            m_info.push_back(info);
+            m_states.push_back(State{});
+        }
+
+        NetworkInfo& info = m_info[index];
+        State& state = m_states[index];
+        double rates[CounterCount] = {};
+        for (int counter = 0; counter < CounterCount; counter++) {
+            unsigned long long value = columns[kCounterColumns[counter]];
+            if (!fresh && elapsed > 0.0) {
+                rates[counter] = counterDelta(value, state.counters[counter]) / elapsed;
+            }
+            state.counters[counter] = value;
+        }
+        info.rxBytesPerSec = rates[RxBytes];
+        info.txBytesPerSec = rates[TxBytes];
+        info.rxPacketsPerSec = rates[RxPackets];
+        info.txPacketsPerSec = rates[TxPackets];
+        info.rxErrorsPerSec = rates[RxErrors];
+        info.txErrorsPerSec = rates[TxErrors];
+        info.rxDropsPerSec = rates[RxDrops];
+        info.txDropsPerSec = rates[TxDrops];
+        state.seen = true;
+        expected = index + 1;
+    }
+
+    // Forget interfaces that went away
+    for (std::size_t i = 0; i < m_states.size();) {
+        if (!m_states[i].seen) {
+            m_states.erase(m_states.begin() + i);
+            m_info.erase(m_info.begin() + i);
+        } else {
+            i++;
+        }
+    }
+    return true;
+}
+
+const std::vector<NetworkInfo>& NetworkCollector::interfaces() const {
+    return m_info;
+}
+
+std::vector<std::string> NetworkCollector::parsePrefixList(const std::string& list) {
+    std::vector<std::string> prefixes;
+    std::size_t start = 0;
+    while (start <= list.size()) {
+        std::size_t comma = list.find(',', start);
+        if (comma == std::string::npos) {
+            comma = list.size();
+        }
+        std::string prefix = list.substr(start, comma - start);
+        prefix.erase(0, prefix.find_first_not_of(" \t"));
+        prefix.erase(prefix.find_last_not_of(" \t") + 1);
+        if (!prefix.empty()) {
+            prefixes.push_back(prefix);
+        }
+        start = comma + 1;
+    }
+    return prefixes;
+}
@@ -0,0 +1,73 @@
+#ifndef NETWORK_COLLECTOR_H
+#define NETWORK_COLLECTOR_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "proc_reader.h"
+
+// Rates of one network interface over the last update. Fixed size, so it
+// can be copied into snapshots without allocating.
+struct NetworkInfo {
+    char name[16];                      // IFNAMSIZ
+    double rxBytesPerSec;
+    double txBytesPerSec;
+    double rxPacketsPerSec;
+    double txPacketsPerSec;
+    double rxErrorsPerSec;
+    double txErrorsPerSec;
+    double rxDropsPerSec;
+    double txDropsPerSec;
+};
+
+// Per-interface throughput from /proc/net/dev.
+//
+// The file is read through a ProcFile and parsed in one pass without
+// allocation. Interfaces whose name starts with an excluded prefix (veth,
+// docker bridges, ...) are dropped before any other work, so hosts with
+// hundreds of container interfaces pay only a prefix compare for them.
+//
+// Counters that go backwards are treated as a counter reset: the rate is 0
+// for that interval and the new value becomes the baseline.
+class NetworkCollector {
+public:
+    NetworkCollector();
+
+    bool open(const char* path = "/proc/net/dev");
+    bool isOpen() const;
+
+    // Skip interfaces whose name starts with one of the prefixes
+    void setExcludedPrefixes(const std::vector<std::string>& prefixes);
+
+    // Read the counters and compute rates since the previous update
+    bool update();
+
+    // Monitored interfaces in /proc/net/dev order
+    const std::vector<NetworkInfo>& interfaces() const;
+
+    // Parse a comma separated prefix list
+    static std::vector<std::string> parsePrefixList(const std::string& list);
+
+private:
+    enum Counter {
+        RxBytes, RxPackets, RxErrors, RxDrops,
+        TxBytes, TxPackets, TxErrors, TxDrops,
+        CounterCount
+    };
+
+    struct State {
+        unsigned long long counters[CounterCount];
+        bool seen;
+    };
+
+    ProcFile m_file;
+    std::vector<std::string> m_excluded;
+    std::vector<NetworkInfo> m_info;    // Parallel to m_states
+    std::vector<State> m_states;
+    std::chrono::steady_clock::time_point m_lastUpdate;
+
+    bool isExcluded(const char* name, std::size_t length) const;
+};
+
+#endif // NETWORK_COLLECTOR_H
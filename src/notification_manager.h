@@ -5,14 +5,7 @@
 #include <map>
 #include <chrono>
 #include <libnotify/notify.h>
-
-// Типы ресурсов для группировки уведомлений
-enum class ResourceType {
-    CPU,
-    Memory,
-    Disk,
-    Other
-};
+#include "resource_type.h"
 
 class NotificationManager {
 public:
@@ -0,0 +1,77 @@
+#include "pressure_collector.h"
+#include <string>
+
+PressureCollector::PressureCollector()
+    : m_info()
+{
+    // Files are opened in open()
+}
+
+bool PressureCollector::open(const char* root) {
+    bool opened = false;
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        std::string path = std::string(root) + "/" + resourceName(static_cast<PressureResource>(i));
+        opened = m_files[i].open(path.c_str()) || opened;
+    }
+    return opened;
+}
+
+bool PressureCollector::isOpen() const {
+    for (const auto& file : m_files) {
+        if (file.isOpen()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PressureCollector::update() {
+    using namespace ProcParse;
+
+    bool read = false;
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        if (!m_files[i].isOpen() || !m_files[i].read()) {
+            continue;
+        }
+        read = true;
+
+        // "some avg10=0.12 avg60=0.05 avg300=0.01 total=123456", then "full ..."
+        const char* end = m_files[i].end();
+        for (const char* p = m_files[i].data(); p < end; p = nextLine(p, end)) {
+            double* avg10;
+            double* avg60;
+            if (startsWith(p, end, "some avg10=", 11)) {
+                avg10 = &m_info[i].someAvg10;
+                avg60 = &m_info[i].someAvg60;
+            } else if (startsWith(p, end, "full avg10=", 11)) {
+                avg10 = &m_info[i].fullAvg10;
+                avg60 = &m_info[i].fullAvg60;
+            } else {
+                continue;
+            }
+
+            const char* q = parseDecimal(p + 11, end, *avg10);
+            q = skipSpaces(q, end);
+            if (startsWith(q, end, "avg60=", 6)) {
+                parseDecimal(q + 6, end, *avg60);
+            }
+        }
+    }
+    return read;
+}
+
+const PressureInfo& PressureCollector::get(PressureResource resource) const {
+    return m_info[static_cast<std::size_t>(resource)];
+}
+
+const char* PressureCollector::resourceName(PressureResource resource) {
+    switch (resource) {
+        case PressureResource::CPU:
+            return "cpu";
+        case PressureResource::Memory:
+            return "memory";
+        case PressureResource::IO:
+            return "io";
+    }
+    return "";
+}
@@ -0,0 +1,48 @@
+#ifndef PRESSURE_COLLECTOR_H
+#define PRESSURE_COLLECTOR_H
+
+#include <cstddef>
+#include "proc_reader.h"
+
+// Resources with a pressure file under /proc/pressure
+enum class PressureResource {
+    CPU,
+    Memory,
+    IO
+};
+
+static const std::size_t kPressureResourceCount = 3;
+
+// Share of time in percent that some or all runnable tasks were stalled on
+// a resource, averaged over 10 and 60 seconds
+struct PressureInfo {
+    double someAvg10;
+    double someAvg60;
+    double fullAvg10;
+    double fullAvg60;
+};
+
+// Pressure stall information (PSI) from /proc/pressure/{cpu,memory,io}.
+// The files stay open and are re-read with pread(); kernels without PSI
+// (or with psi=0) have no files and isOpen() is false.
+class PressureCollector {
+public:
+    PressureCollector();
+
+    bool open(const char* root = "/proc/pressure");
+    bool isOpen() const;
+
+    // Re-read the averages of all resources
+    bool update();
+
+    const PressureInfo& get(PressureResource resource) const;
+
+    // File name of a resource under the pressure root
+    static const char* resourceName(PressureResource resource);
+
+private:
+    ProcFile m_files[kPressureResourceCount];
+    PressureInfo m_info[kPressureResourceCount];
+};
+
+#endif // PRESSURE_COLLECTOR_H
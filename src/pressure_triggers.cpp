@@ -0,0 +1,129 @@
+#include "pressure_triggers.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// Unprivileged users may only create triggers with a window that is a
+// multiple of 2 s, so that is the window for everyone
+static const long kWindowUs = 2000000;
+
+PressureTriggers::PressureTriggers()
+    : m_wakeFd(-1)
+{
+    for (int& fd : m_fds) {
+        fd = -1;
+    }
+}
+
+PressureTriggers::~PressureTriggers() {
+    stop();
+}
+
+bool PressureTriggers::start(int thresholdPercent, Callback callback, const char* root) {
+    stop();
+
+    long stallUs = kWindowUs * thresholdPercent / 100;
+    if (stallUs <= 0 || stallUs > kWindowUs) {
+        return false;
+    }
+
+    char trigger[64];
+    int length = std::snprintf(trigger, sizeof(trigger), "some %ld %ld", stallUs, kWindowUs);
+    bool registered = false;
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        std::string path = std::string(root) + "/" + PressureCollector::resourceName(static_cast<PressureResource>(i));
+        int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        // The trigger lives as long as the fd; the write includes the NUL
+        if (::write(fd, trigger, length + 1) < 0) {
+            std::cerr << "Failed to register PSI trigger on " << path << ": " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            continue;
+        }
+        m_fds[i] = fd;
+        registered = true;
+    }
+    if (!registered) {
+        return false;
+    }
+
+    m_wakeFd = eventfd(0, EFD_CLOEXEC);
+    if (m_wakeFd < 0) {
+        closeTriggers();
+        return false;
+    }
+
+    m_callback = std::move(callback);
+    m_thread = std::thread(&PressureTriggers::run, this);
+    return true;
+}
+
+void PressureTriggers::stop() {
+    if (m_thread.joinable()) {
+        std::uint64_t one = 1;
+        if (::write(m_wakeFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Failed to wake the PSI watcher: " << std::strerror(errno) << std::endl;
+        }
+        m_thread.join();
+    }
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+    closeTriggers();
+}
+
+bool PressureTriggers::isRunning() const {
+    return m_thread.joinable();
+}
+
+void PressureTriggers::closeTriggers() {
+    for (int& fd : m_fds) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+}
+
+void PressureTriggers::run() {
+    // The wake fd goes last; the trigger slots keep their resource index
+    struct pollfd fds[kPressureResourceCount + 1];
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        fds[i].fd = m_fds[i];           // poll() ignores negative fds
+        fds[i].events = POLLPRI;
+    }
+    fds[kPressureResourceCount].fd = m_wakeFd;
+    fds[kPressureResourceCount].events = POLLIN;
+
+    for (;;) {
+        int ready = poll(fds, kPressureResourceCount + 1, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "PSI poll failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if (fds[kPressureResourceCount].revents) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+            if (fds[i].revents & POLLERR) {
+                // The pressure file went away (cgroup removed), stop watching it
+                fds[i].fd = -1;
+            } else if (fds[i].revents & POLLPRI) {
+                m_callback(static_cast<PressureResource>(i));
+            }
+        }
+    }
+}
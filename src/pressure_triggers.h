@@ -0,0 +1,49 @@
+#ifndef PRESSURE_TRIGGERS_H
+#define PRESSURE_TRIGGERS_H
+
+#include <functional>
+#include <string>
+#include <thread>
+#include "pressure_collector.h"
+
+// Kernel PSI triggers on /proc/pressure/{cpu,memory,io}.
+//
+// Writing "some <stall us> <window us>" to a pressure file makes the kernel
+// flag that fd with POLLPRI as soon as tasks were stalled for longer than
+// the threshold within the window, at most once per window. A thread sleeps
+// in poll() on the trigger fds, so a stall is reported within milliseconds
+// and nothing runs while the system is healthy.
+//
+// The callback runs on the watcher thread.
+class PressureTriggers {
+public:
+    using Callback = std::function<void(PressureResource resource)>;
+
+    PressureTriggers();
+    ~PressureTriggers();
+
+    PressureTriggers(const PressureTriggers&) = delete;
+    PressureTriggers& operator=(const PressureTriggers&) = delete;
+
+    // Register a trigger per resource firing when stalls exceed
+    // thresholdPercent of a 2 s window, and start watching. Resources whose
+    // trigger cannot be created are skipped; false if none could be.
+    bool start(int thresholdPercent, Callback callback, const char* root = "/proc/pressure");
+
+    // Stop watching and remove the triggers
+    void stop();
+
+    bool isRunning() const;
+
+private:
+    int m_fds[kPressureResourceCount];  // Trigger fds, -1 if not registered
+    int m_wakeFd;                       // eventfd that ends the poll() in stop()
+    Callback m_callback;
+    std::thread m_thread;
+
+    // Thread body
+    void run();
+    void closeTriggers();
+};
+
+#endif // PRESSURE_TRIGGERS_H
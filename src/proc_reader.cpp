@@ -0,0 +1,78 @@
+#include "proc_reader.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+ProcFile::ProcFile(std::size_t bufferSize)
+    : m_fd(-1),
+      m_buffer(bufferSize + 1),
+      m_size(0)
+{
+    // One extra byte for the terminating NUL
+}
+
+ProcFile::~ProcFile() {
+    close();
+}
+
+bool ProcFile::open(const char* path) {
+    close();
+    m_fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    return m_fd >= 0;
+}
+
+void ProcFile::close() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+    m_buffer[0] = '\0';
+}
+
+bool ProcFile::isOpen() const {
+    return m_fd >= 0;
+}
+
+bool ProcFile::read() {
+    if (m_fd < 0) {
+        return false;
+    }
+
+    // procfs regenerates the contents on every read from offset 0. Small files
+    // arrive in one call; loop for the ones the kernel hands out page by page.
+    std::size_t capacity = m_buffer.size() - 1;
+    std::size_t total = 0;
+    while (total < capacity) {
+        ssize_t n = ::pread(m_fd, m_buffer.data() + total, capacity - total,
+                            static_cast<off_t>(total));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            m_size = 0;
+            m_buffer[0] = '\0';
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        total += static_cast<std::size_t>(n);
+    }
+
+    m_size = total;
+    m_buffer[total] = '\0';
+    return true;
+}
+
+const char* ProcFile::data() const {
+    return m_buffer.data();
+}
+
+const char* ProcFile::end() const {
+    return m_buffer.data() + m_size;
+}
+
+std::size_t ProcFile::size() const {
+    return m_size;
+}
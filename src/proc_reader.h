@@ -0,0 +1,107 @@
+#ifndef PROC_READER_H
+#define PROC_READER_H
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <sys/types.h>
+
+// A /proc (or sysfs) file that stays open between samples. Each read() is a
+// single pread() from offset 0 into a buffer allocated once by the
+// constructor, so the steady-state sampling path does no heap allocation and
+// no open()/close().
+class ProcFile {
+public:
+    explicit ProcFile(std::size_t bufferSize = 4096);
+    ~ProcFile();
+
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+
+    // Open the file, closing any previously opened one
+    bool open(const char* path);
+    void close();
+    bool isOpen() const;
+
+    // Re-read the file contents. Returns false on error. Files larger than the
+    // buffer are truncated; the data is always NUL-terminated.
+    bool read();
+
+    const char* data() const;
+    const char* end() const;
+    std::size_t size() const;
+
+private:
+    int m_fd;
+    std::vector<char> m_buffer;
+    std::size_t m_size;
+};
+
+// Allocation-free helpers for parsing /proc text in place.
+// All functions take [p, end) and return the position after what they consumed.
+namespace ProcParse {
+
+inline const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+// Parse a decimal unsigned integer after optional spaces; value is 0 if none
+inline const char* parseUnsigned(const char* p, const char* end, unsigned long long& value) {
+    p = skipSpaces(p, end);
+    unsigned long long result = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        result = result * 10 + static_cast<unsigned long long>(*p - '0');
+        p++;
+    }
+    value = result;
+    return p;
+}
+
+// Parse a non-negative decimal like "12.34" after optional spaces
+inline const char* parseDecimal(const char* p, const char* end, double& value) {
+    unsigned long long whole;
+    p = parseUnsigned(p, end, whole);
+    double result = static_cast<double>(whole);
+    if (p < end && *p == '.') {
+        double scale = 0.1;
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            result += (*p - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    value = result;
+    return p;
+}
+
+// Skip past the next newline
+inline const char* nextLine(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+
+// Skip to the next whitespace character
+inline const char* skipToken(const char* p, const char* end) {
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\n') {
+        p++;
+    }
+    return p;
+}
+
+inline bool startsWith(const char* p, const char* end, const char* prefix, std::size_t length) {
+    return static_cast<std::size_t>(end - p) >= length && std::memcmp(p, prefix, length) == 0;
+}
+
+// Increase of a kernel counter between two reads. A decrease means the
+// counter was reset (driver reload, cgroup recreated, a failed read) and
+// gives 0, the caller then re-baselines on the current value. Reading it as
+// a 32-bit wrap instead would turn every such reset into a huge spike.
+inline unsigned long long counterDelta(unsigned long long current, unsigned long long previous) {
+    return current >= previous ? current - previous : 0;
+}
+
+} // namespace ProcParse
+
+#endif // PROC_READER_H
@@ -0,0 +1,243 @@
+#include "process_collector.h"
+#include "proc_reader.h"
+#include "monitor_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+ProcessCollector::ProcessCollector(const std::string& procPath)
+    : m_procPath(procPath),
+      m_dir(nullptr),
+      m_buffer(1024),
+      m_generation(0),
+      m_cachedFds(0),
+      m_fdBudget(0),
+      m_clockTicks(sysconf(_SC_CLK_TCK)),
+      m_pageSize(sysconf(_SC_PAGESIZE)),
+      m_elapsed(0.0)
+{
+    // A stat line is well under 1 KB whatever the comm is
+}
+
+ProcessCollector::~ProcessCollector() {
+    close();
+}
+
+bool ProcessCollector::open() {
+    close();
+
+    m_dir = opendir(m_procPath.c_str());
+    if (!m_dir) {
+        return false;
+    }
+
+    // Leave most of the fd limit to the rest of the program
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        m_fdBudget = limit.rlim_cur > 512 ? (limit.rlim_cur - 256) / 2 : 0;
+    } else {
+        m_fdBudget = 65536;
+    }
+
+    m_lastSweep = MonitorClock::now();
+    return true;
+}
+
+void ProcessCollector::close() {
+    for (auto& pair : m_entries) {
+        closeEntry(pair.second);
+    }
+    m_entries.clear();
+    if (m_dir) {
+        closedir(m_dir);
+        m_dir = nullptr;
+    }
+}
+
+bool ProcessCollector::isOpen() const {
+    return m_dir != nullptr;
+}
+
+void ProcessCollector::closeEntry(Entry& entry) {
+    if (entry.fd >= 0) {
+        ::close(entry.fd);
+        entry.fd = -1;
+        m_cachedFds--;
+    }
+}
+
+bool ProcessCollector::update() {
+    if (!m_dir) {
+        return false;
+    }
+
+    auto now = MonitorClock::now();
+    m_elapsed = std::chrono::duration<double>(now - m_lastSweep).count();
+    m_lastSweep = now;
+    m_generation++;
+
+    rewinddir(m_dir);
+    while (struct dirent* de = readdir(m_dir)) {
+        // Only the numeric entries are processes
+        const char* name = de->d_name;
+        if (*name < '1' || *name > '9') {
+            continue;
+        }
+        int pid = 0;
+        for (; *name >= '0' && *name <= '9'; name++) {
+            pid = pid * 10 + (*name - '0');
+        }
+        if (*name != '\0') {
+            continue;
+        }
+
+        auto it = m_entries.find(pid);
+        if (it == m_entries.end()) {
+            Entry entry{};
+            entry.fd = -1;
+            entry.info.pid = pid;
+            it = m_entries.emplace(pid, entry).first;
+        }
+        if (readProcess(pid, it->second)) {
+            it->second.generation = m_generation;
+        }
+    }
+
+    // Forget processes that exited
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.generation != m_generation) {
+            closeEntry(it->second);
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return true;
+}
+
+bool ProcessCollector::readProcess(int pid, Entry& entry) {
+    char path[32];
+    std::snprintf(path, sizeof(path), "%d/stat", pid);
+    std::size_t capacity = m_buffer.size() - 1;
+
+    // A cached fd of an exited process fails with ESRCH; if the PID is back,
+    // it belongs to a new process, so reopen once
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool cached = entry.fd >= 0;
+        int fd = cached ? entry.fd : openat(dirfd(m_dir), path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        ssize_t n = pread(fd, m_buffer.data(), capacity, 0);
+        if (!cached) {
+            if (n > 0 && m_cachedFds < m_fdBudget) {
+                entry.fd = fd;
+                m_cachedFds++;
+            } else {
+                ::close(fd);
+            }
+        }
+
+        if (n > 0) {
+            m_buffer[n] = '\0';
+            return parseStat(m_buffer.data(), m_buffer.data() + n, entry);
+        }
+        if (!cached) {
+            return false;
+        }
+        closeEntry(entry);
+        entry.hasPrevious = false;
+    }
+    return false;
+}
+
+bool ProcessCollector::parseStat(const char* p, const char* end, Entry& entry) {
+    using namespace ProcParse;
+
+    // "pid (comm) state ...": comm may contain spaces and parentheses, so
+    // it ends at the last ')'
+    const char* open = static_cast<const char*>(std::memchr(p, '(', end - p));
+    const char* close = static_cast<const char*>(memrchr(p, ')', end - p));
+    if (!open || !close || close < open || close + 2 >= end) {
+        return false;
+    }
+
+    std::size_t nameLength = std::min<std::size_t>(close - open - 1, sizeof(entry.info.name) - 1);
+    std::memcpy(entry.info.name, open + 1, nameLength);
+    entry.info.name[nameLength] = '\0';
+
+    p = close + 2;
+    entry.info.state = *p++;
+
+    // Fields 4-24 of proc(5); priority and nice may be negative, so only the
+    // unsigned fields we need are parsed
+    unsigned long long utime = 0;
+    unsigned long long stime = 0;
+    unsigned long long startTime = 0;
+    unsigned long long rss = 0;
+    for (int field = 4; field <= 24; field++) {
+        switch (field) {
+        case 14: p = parseUnsigned(p, end, utime); break;
+        case 15: p = parseUnsigned(p, end, stime); break;
+        case 22: p = parseUnsigned(p, end, startTime); break;
+        case 24: p = parseUnsigned(p, end, rss); break;
+        default: p = skipToken(skipSpaces(p, end), end); break;
+        }
+    }
+
+    unsigned long long ticks = utime + stime;
+    if (!entry.hasPrevious || startTime != entry.startTime) {
+        entry.info.cpuPercent = 0.0;
+    } else if (m_elapsed > 0.0 && ticks >= entry.prevTicks) {
+        entry.info.cpuPercent = 100.0 * (ticks - entry.prevTicks) / (m_elapsed * m_clockTicks);
+    }
+    entry.info.rssBytes = rss * static_cast<unsigned long long>(m_pageSize);
+    entry.startTime = startTime;
+    entry.prevTicks = ticks;
+    entry.hasPrevious = true;
+    return true;
+}
+
+std::size_t ProcessCollector::getProcessCount() const {
+    return m_entries.size();
+}
+
+template <typename Less>
+void ProcessCollector::selectTop(std::size_t n, std::vector<ProcessInfo>& out, Less less) const {
+    out.clear();
+    if (n == 0) {
+        return;
+    }
+
+    // Min-heap of the n best so far: its top is the one to beat
+    auto greater = [&less](const ProcessInfo& a, const ProcessInfo& b) { return less(b, a); };
+    for (const auto& pair : m_entries) {
+        const ProcessInfo& info = pair.second.info;
+        if (out.size() < n) {
+            out.push_back(info);
+            std::push_heap(out.begin(), out.end(), greater);
+        } else if (less(out.front(), info)) {
+            std::pop_heap(out.begin(), out.end(), greater);
+            out.back() = info;
+            std::push_heap(out.begin(), out.end(), greater);
+        }
+    }
+    std::sort_heap(out.begin(), out.end(), greater);
+}
+
+void ProcessCollector::topByCPU(std::size_t n, std::vector<ProcessInfo>& out) const {
+    selectTop(n, out, [](const ProcessInfo& a, const ProcessInfo& b) {
+        return a.cpuPercent < b.cpuPercent || (a.cpuPercent == b.cpuPercent && a.rssBytes < b.rssBytes);
+    });
+}
+
+void ProcessCollector::topByMemory(std::size_t n, std::vector<ProcessInfo>& out) const {
+    selectTop(n, out, [](const ProcessInfo& a, const ProcessInfo& b) {
+        return a.rssBytes < b.rssBytes;
+    });
+}
@@ -0,0 +1,86 @@
+#ifndef PROCESS_COLLECTOR_H
+#define PROCESS_COLLECTOR_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+
+// One process as seen by the last sweep. Fixed size, so vectors of it can
+// be copied between threads without allocating.
+struct ProcessInfo {
+    int pid;
+    char name[16];                  // comm, at most 15 characters
+    char state;
+    double cpuPercent;              // Of one CPU, as top shows it
+    unsigned long long rssBytes;
+};
+
+// Per-process collector.
+//
+// /proc is kept open as a directory stream and rewound for every sweep;
+// per-PID files are opened relative to it with openat(). The stat file of
+// each process stays open between sweeps and is re-read with pread(), so a
+// steady process costs one syscall per sweep. The number of cached fds is
+// capped by RLIMIT_NOFILE; processes beyond the cap are opened and closed
+// on every sweep instead.
+//
+// CPU% comes from the utime+stime delta over the time between sweeps. A
+// changed start time means the PID was reused, and the delta starts over.
+class ProcessCollector {
+public:
+    explicit ProcessCollector(const std::string& procPath = "/proc");
+    ~ProcessCollector();
+
+    ProcessCollector(const ProcessCollector&) = delete;
+    ProcessCollector& operator=(const ProcessCollector&) = delete;
+
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    // Scan all processes once
+    bool update();
+
+    // Number of processes found by the last sweep
+    std::size_t getProcessCount() const;
+
+    // The n busiest (or largest) processes, in descending order. Selects with
+    // a bounded heap, O(P log n); `out` is refilled and its storage reused.
+    void topByCPU(std::size_t n, std::vector<ProcessInfo>& out) const;
+    void topByMemory(std::size_t n, std::vector<ProcessInfo>& out) const;
+
+private:
+    struct Entry {
+        int fd;                         // Cached stat fd, -1 if over the fd budget
+        unsigned long long startTime;   // Clock ticks after boot, identifies the process
+        unsigned long long prevTicks;   // utime + stime at the previous sweep
+        bool hasPrevious;
+        std::size_t generation;         // Sweep that last saw the process
+        ProcessInfo info;
+    };
+
+    std::string m_procPath;
+    DIR* m_dir;
+    std::unordered_map<int, Entry> m_entries;
+    std::vector<char> m_buffer;
+    std::size_t m_generation;
+    std::size_t m_cachedFds;
+    std::size_t m_fdBudget;
+    long m_clockTicks;
+    long m_pageSize;
+    std::chrono::steady_clock::time_point m_lastSweep;
+    double m_elapsed;                   // Seconds between the last two sweeps
+
+    // Read and parse /proc/<pid>/stat into the entry
+    bool readProcess(int pid, Entry& entry);
+    bool parseStat(const char* p, const char* end, Entry& entry);
+    void closeEntry(Entry& entry);
+
+    template <typename Less>
+    void selectTop(std::size_t n, std::vector<ProcessInfo>& out, Less less) const;
+};
+
+#endif // PROCESS_COLLECTOR_H
@@ -1,17 +1,58 @@
 #include "resource_graphs.h"
+#include "diagnostics.h"
 #include <iostream>
 #include <vector>
 #include <string>
 #include <cmath>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <cstdio>
+
+// Axis label for a point `seconds` before now
+static std::string formatTimeOffset(double seconds) {
+    if (seconds <= 0.0) {
+        return "Now";
+    }
+    std::stringstream label;
+    label << std::setprecision(2);
+    if (seconds < 120.0) {
+        label << std::lround(seconds) << "s";
+    } else if (seconds < 2 * 3600.0) {
+        label << std::lround(seconds / 60.0) << "m";
+    } else if (seconds < 2 * 86400.0) {
+        label << seconds / 3600.0 << "h";
+    } else {
+        label << seconds / 86400.0 << "d";
+    }
+    return label.str();
+}
 
 ResourceGraph::ResourceGraph()
     : m_data(nullptr),
+      m_rollup(nullptr),
+      m_timeRange(600.0),
+      m_useArchive(false),
+      m_secondary(nullptr),
+      m_secondaryData(nullptr),
+      m_secondaryR(0.9),
+      m_secondaryG(0.9),
+      m_secondaryB(0.9),
+      m_valueFormat(ValueFormat::Percent),
+      m_scale(100.0),
       m_colorR(0.0),
       m_colorG(0.7),
       m_colorB(0.9),
-      m_title("Resource Usage")
+      m_title("Resource Usage"),
+      m_staticLayer(nullptr),
+      m_cacheWidth(0),
+      m_cacheHeight(0),
+      m_scrollMode(false),
+      m_plotSurface{nullptr, nullptr},
+      m_plotIndex(0),
+      m_plotEndSequence(0),
+      m_plotFraction(0.0),
+      m_plotLastValue(0.0)
 {
     // Create drawing area widget
     m_drawingArea = gtk_drawing_area_new();
@@ -22,7 +63,8 @@ ResourceGraph::ResourceGraph()
 }
 
 ResourceGraph::~ResourceGraph() {
-    // Default destructor
+    invalidateStaticLayer();
+    releasePlotSurfaces();
 }
 
 GtkWidget* ResourceGraph::getWidget() {
@@ -30,7 +72,130 @@ GtkWidget* ResourceGraph::getWidget() {
 }
 
 void ResourceGraph::setDataSource(HistoryData* data) {
+    m_rollup = nullptr;
+    m_useArchive = false;
     m_data = data;
+    m_plotEndSequence = 0;
+}
+
+void ResourceGraph::setDataSource(RollupHistory* history) {
+    m_rollup = history;
+    selectSeries();
+}
+
+void ResourceGraph::setTimeRange(double seconds) {
+    if (seconds <= 0.0 || seconds == m_timeRange) {
+        return;
+    }
+    m_timeRange = seconds;
+    invalidateStaticLayer();
+    selectSeries();
+}
+
+void ResourceGraph::setSecondaryDataSource(RollupHistory* history) {
+    m_secondary = history;
+    m_secondaryData = nullptr;
+    selectSeries();
+}
+
+void ResourceGraph::setSecondaryDataSource(HistoryData* data) {
+    m_secondary = nullptr;
+    m_secondaryData = data;
+    m_plotEndSequence = 0;
+}
+
+void ResourceGraph::setSecondaryColor(double r, double g, double b) {
+    m_secondaryR = r;
+    m_secondaryG = g;
+    m_secondaryB = b;
+}
+
+void ResourceGraph::setValueFormat(ValueFormat format) {
+    m_valueFormat = format;
+    m_scale = 100.0;
+    invalidateStaticLayer();
+}
+
+void ResourceGraph::selectSeries() {
+    if (!m_rollup) {
+        return;
+    }
+    // A different tier has unrelated sequence numbers, start the plot over
+    m_useArchive = m_timeRange > m_rollup->getTierSpan(0) && m_timeRange <= m_rollup->getArchiveSpan();
+    std::size_t tier = m_useArchive ? 0 : m_rollup->selectTier(m_timeRange);
+    m_data = m_rollup->getTierAverage(tier);
+    if (m_secondary) {
+        m_secondaryData = m_secondary->getTierAverage(tier);
+    }
+    m_plotEndSequence = 0;
+}
+
+std::size_t ResourceGraph::visibleValues(RollupHistory* history, const SampleView& samples,
+                                         std::vector<double>& decoded, const double*& values) {
+    if (history && m_useArchive) {
+        decoded.clear();
+        history->archive()->forEachLast(visiblePoints(), [&decoded](std::int64_t, double value) {
+            decoded.push_back(value);
+        });
+        values = decoded.data();
+        return decoded.size();
+    }
+    
+    // A tiered source keeps the time scale fixed; a plain history stretches over the width
+    std::size_t count = history ? std::min(samples.size(), visiblePoints()) : samples.size();
+    values = samples.end() - count;
+    return count;
+}
+
+void ResourceGraph::updateScale(double peak) {
+    // Smallest 1-2-5 step above the peak with some headroom, at least 1 KB/s
+    // or 1 %. Percent of one CPU may exceed 100, so there is no upper bound.
+    bool percent = m_valueFormat == ValueFormat::ScaledPercent;
+    double target = std::max(peak * 1.1, percent ? 1.0 : 1000.0);
+    double magnitude = std::pow(10.0, std::floor(std::log10(target)));
+    double scale = magnitude;
+    if (target > magnitude * 5.0) {
+        scale = magnitude * 10.0;
+    } else if (target > magnitude * 2.0) {
+        scale = magnitude * 5.0;
+    } else if (target > magnitude) {
+        scale = magnitude * 2.0;
+    }
+    if (scale != m_scale) {
+        m_scale = scale;
+        invalidateStaticLayer();
+    }
+}
+
+std::string ResourceGraph::formatValue(double value) const {
+    if (m_valueFormat == ValueFormat::Percent) {
+        return std::to_string(static_cast<int>(value)) + "%";
+    }
+    if (m_valueFormat == ValueFormat::ScaledPercent) {
+        std::stringstream label;
+        label << std::fixed << std::setprecision(value < 10.0 ? 1 : 0) << value << "%";
+        return label.str();
+    }
+    
+    // Decimal units, as network rates are usually given
+    static const char* const units[] = {"", "K", "M", "G", "T"};
+    int unit = 0;
+    while (value >= 1000.0 && unit < 4) {
+        value /= 1000.0;
+        unit++;
+    }
+    std::stringstream label;
+    label << std::fixed << std::setprecision(value < 10.0 && unit > 0 ? 1 : 0) << value << units[unit];
+    return label.str();
+}
+
+std::size_t ResourceGraph::visiblePoints() const {
+    if (!m_rollup) {
+        return m_data->getCapacity();
+    }
+    std::size_t tier = m_useArchive ? 0 : m_rollup->selectTier(m_timeRange);
+    double resolution = m_rollup->getTierResolution(tier);
+    return std::max<std::size_t>(2, static_cast<std::size_t>(std::ceil(m_timeRange / resolution)));
 }
 
 void ResourceGraph::setColor(double r, double g, double b) {
@@ -41,6 +206,14 @@ void ResourceGraph::setColor(double r, double g, double b) {
 
 void ResourceGraph::setTitle(const std::string& title) {
     m_title = title;
+    invalidateStaticLayer();
+}
+
+void ResourceGraph::setScrollMode(bool enabled) {
+    m_scrollMode = enabled;
+    if (!enabled) {
+        releasePlotSurfaces();
+    }
 }
 
 void ResourceGraph::redraw() {
@@ -61,10 +234,15 @@ gboolean ResourceGraph::drawCallback(GtkWidget* widget, cairo_t* cr, gpointer da
 
 // Реализация класса DiskGraphPanel
 
-DiskGraphPanel::DiskGraphPanel(const std::string& name, const std::string& device, ResourceGraph* graph)
-    : m_name(name),
+DiskGraphPanel::DiskGraphPanel(const std::string& name, const std::string& device, ResourceGraph* graph,
+                               ResourceGraph* ioGraph)
+    : m_lastUsedGB(-1.0),
+      m_lastTotalGB(-1.0),
+      m_lastPercent(-1.0),
+      m_name(name),
       m_device(device),
-      m_graph(graph)
+      m_graph(graph),
+      m_ioGraph(ioGraph)
 {
     // Создаем основной контейнер
     m_mainBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
@@ -77,8 +255,16 @@ DiskGraphPanel::DiskGraphPanel(const std::string& name, const std::string& devic
     gtk_widget_set_halign(m_infoLabel, GTK_ALIGN_START);
     gtk_box_pack_start(GTK_BOX(m_mainBox), m_infoLabel, FALSE, FALSE, 0);
     
-    // Добавляем график
-    gtk_box_pack_start(GTK_BOX(m_mainBox), graph->getWidget(), TRUE, TRUE, 0);
+    // Метка с операциями ввода-вывода
+    m_ioLabel = gtk_label_new("");
+    gtk_widget_set_halign(m_ioLabel, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(m_mainBox), m_ioLabel, FALSE, FALSE, 0);
+    
+    // Добавляем графики: заполнение слева, ввод-вывод справа
+    GtkWidget* graphsBox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(graphsBox), graph->getWidget(), TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(graphsBox), ioGraph->getWidget(), TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(m_mainBox), graphsBox, TRUE, TRUE, 0);
     
     // Показываем все виджеты
     gtk_widget_show_all(m_mainBox);
@@ -93,6 +279,14 @@ GtkWidget* DiskGraphPanel::getWidget() {
 }
 
 void DiskGraphPanel::updateInfo(double usedGB, double totalGB, double usagePercent) {
+    // Capacity changes rarely, avoid relayout when the text would be the same
+    if (usedGB == m_lastUsedGB && totalGB == m_lastTotalGB && usagePercent == m_lastPercent) {
+        return;
+    }
+    m_lastUsedGB = usedGB;
+    m_lastTotalGB = totalGB;
+    m_lastPercent = usagePercent;
+    
     std::stringstream labelText;
     labelText << m_name << " (" << m_device << "): " 
               << std::fixed << std::setprecision(1) << usedGB 
@@ -101,11 +295,274 @@ void DiskGraphPanel::updateInfo(double usedGB, double totalGB, double usagePerce
     gtk_label_set_text(GTK_LABEL(m_infoLabel), labelText.str().c_str());
 }
 
+void DiskGraphPanel::updateIO(double readOps, double writeOps, double awaitMs, double utilization) {
+    // Changes every sample, so no need to compare with the previous text
+    char text[128];
+    std::snprintf(text, sizeof(text), "Чтение: %.0f оп/с, запись: %.0f оп/с, ожидание: %.1f мс, загрузка: %.0f%%",
+                  readOps, writeOps, awaitMs, utilization);
+    gtk_label_set_text(GTK_LABEL(m_ioLabel), text);
+}
+
 ResourceGraph* DiskGraphPanel::getGraph() {
     return m_graph;
 }
 
+ResourceGraph* DiskGraphPanel::getIOGraph() {
+    return m_ioGraph;
+}
+
 void ResourceGraph::draw(cairo_t* cr, int width, int height) {
+    ScopedProbe probe(Probe::GraphDraw);
+    
+    // Find the visible values first: with autoscaling the axis labels in the
+    // static layer depend on them. Everything is read straight from the
+    // history storage, without copying or locking.
+    SampleView samples = m_data ? m_data->snapshot() : SampleView();
+    SampleView secondarySamples = m_secondaryData ? m_secondaryData->snapshot() : SampleView();
+    bool scrolling = m_scrollMode && !m_useArchive && !m_secondaryData &&
+                     m_valueFormat == ValueFormat::Percent;
+    const double* values = nullptr;
+    const double* secondaryValues = nullptr;
+    std::size_t count = 0;
+    std::size_t secondaryCount = 0;
+    if (!scrolling) {
+        count = visibleValues(m_rollup, samples, m_decoded, values);
+        if (m_secondaryData) {
+            secondaryCount = visibleValues(m_secondary, secondarySamples, m_decodedSecondary, secondaryValues);
+        }
+    }
+    if (m_valueFormat != ValueFormat::Percent) {
+        double peak = 0.0;
+        for (std::size_t i = 0; i < count; i++) {
+            peak = std::max(peak, values[i]);
+        }
+        for (std::size_t i = 0; i < secondaryCount; i++) {
+            peak = std::max(peak, secondaryValues[i]);
+        }
+        updateScale(peak);
+    }
+    
+    // Re-render the static layer only when the size, title or scale changed
+    if (!m_staticLayer || width != m_cacheWidth || height != m_cacheHeight) {
+        invalidateStaticLayer();
+        releasePlotSurfaces();
+        m_staticLayer = cairo_surface_create_similar(cairo_get_target(cr), CAIRO_CONTENT_COLOR, width, height);
+        m_cacheWidth = width;
+        m_cacheHeight = height;
+        
+        cairo_t* layer = cairo_create(m_staticLayer);
+        drawStaticLayer(layer, width, height);
+        cairo_destroy(layer);
+    }
+    
+    // Composite the cached background, grid and labels
+    cairo_set_source_surface(cr, m_staticLayer, 0, 0);
+    cairo_paint(cr);
+    
+    // If no data, show a message and return. A long range plots a coarse
+    // tier, which stays empty until its first bucket closes.
+    if (!m_data || m_data->getSize() == 0) {
+        cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+        cairo_set_font_size(cr, 10);
+        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+        const char* msg = "No data available";
+        cairo_text_extents_t extents;
+        cairo_text_extents(cr, msg, &extents);
+        cairo_move_to(cr, (width - extents.width) / 2, height / 2);
+        cairo_show_text(cr, msg);
+        return;
+    }
+    
+    // Calculate graph dimensions
+    double graphTop = 25;
+    double graphBottom = height - 25;
+    double graphLeft = 40;
+    double graphRight = width - 10;
+    
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    if (scrolling) {
+        drawScrolling(cr, samples, graphLeft, graphTop, graphRight, graphBottom);
+    } else {
+        drawSamples(cr, values, count, false, graphLeft, graphTop, graphRight, graphBottom);
+        drawSamples(cr, secondaryValues, secondaryCount, true, graphLeft, graphTop, graphRight, graphBottom);
+    }
+    
+    // The current values always come from the raw series
+    double right = graphRight - 5;
+    if (m_rollup) {
+        SampleView raw = m_rollup->raw()->snapshot();
+        if (!raw.empty() && !std::isnan(raw.back())) {
+            right = drawCurrentValue(cr, raw.back(), false, graphTop, right) - 10;
+        }
+        SampleView secondaryRaw = m_secondary ? m_secondary->raw()->snapshot() : SampleView();
+        if (!secondaryRaw.empty() && !std::isnan(secondaryRaw.back())) {
+            drawCurrentValue(cr, secondaryRaw.back(), true, graphTop, right);
+        }
+    } else {
+        if (!samples.empty() && !std::isnan(samples.back())) {
+            right = drawCurrentValue(cr, samples.back(), false, graphTop, right) - 10;
+        }
+        if (!secondarySamples.empty() && !std::isnan(secondarySamples.back())) {
+            drawCurrentValue(cr, secondarySamples.back(), true, graphTop, right);
+        }
+    }
+    
+    // The sampler overtook us mid-frame, paint again with fresh data
+    if (!m_data->validate(samples) || (m_secondaryData && !m_secondaryData->validate(secondarySamples))) {
+        m_plotEndSequence = 0;
+        redraw();
+    }
+}
+
+void ResourceGraph::releasePlotSurfaces() {
+    for (auto& surface : m_plotSurface) {
+        if (surface) {
+            cairo_surface_destroy(surface);
+            surface = nullptr;
+        }
+    }
+    m_plotEndSequence = 0;
+}
+
+void ResourceGraph::drawScrolling(cairo_t* cr, const SampleView& samples,
+                                  double graphLeft, double graphTop,
+                                  double graphRight, double graphBottom) {
+    // The plot surfaces cover the whole widget, so no coordinate translation
+    if (!m_plotSurface[0]) {
+        for (auto& surface : m_plotSurface) {
+            surface = cairo_surface_create_similar(cairo_get_target(cr), CAIRO_CONTENT_COLOR_ALPHA,
+                                                   m_cacheWidth, m_cacheHeight);
+        }
+        m_plotEndSequence = 0;
+    }
+    
+    // Fixed step per sample: the x axis spans the visible range
+    std::size_t visible = visiblePoints();
+    double xStep = (graphRight - graphLeft) / (visible > 1 ? visible - 1 : 1);
+    std::uint64_t endSequence = samples.endSequence();
+    std::uint64_t newSamples = endSequence - m_plotEndSequence;
+    
+    // Repaint from scratch on the first frame, after clear() or when so much
+    // arrived that the whole plot would scroll away anyway
+    bool fullRepaint = m_plotEndSequence == 0 || endSequence < m_plotEndSequence ||
+                       newSamples >= samples.size();
+    
+    if (fullRepaint) {
+        cairo_t* pc = cairo_create(m_plotSurface[m_plotIndex]);
+        cairo_set_operator(pc, CAIRO_OPERATOR_CLEAR);
+        cairo_paint(pc);
+        cairo_set_operator(pc, CAIRO_OPERATOR_OVER);
+        std::size_t count = std::min(samples.size(), visible);
+        drawSegments(pc, samples.end() - count, count, graphRight, xStep, graphTop, graphBottom);
+        cairo_destroy(pc);
+        m_plotFraction = 0.0;
+    } else if (newSamples > 0) {
+        // Shift by whole pixels and carry the remainder, so the blit never resamples
+        double shift = newSamples * xStep + m_plotFraction;
+        double wholePixels = std::floor(shift);
+        m_plotFraction = shift - wholePixels;
+        
+        int target = 1 - m_plotIndex;
+        cairo_t* pc = cairo_create(m_plotSurface[target]);
+        cairo_set_operator(pc, CAIRO_OPERATOR_SOURCE);
+        cairo_set_source_surface(pc, m_plotSurface[m_plotIndex], -wholePixels, 0);
+        cairo_paint(pc);
+        cairo_set_operator(pc, CAIRO_OPERATOR_OVER);
+        
+        // Old samples now sit m_plotFraction right of their exact position,
+        // draw the new segments with the same offset so they join up
+        const double* values = samples.end() - newSamples;
+        cairo_save(pc);
+        cairo_rectangle(pc, graphRight - wholePixels - 2, 0, wholePixels + 12, m_cacheHeight);
+        cairo_clip(pc);
+        double segment[2] = {m_plotLastValue, values[0]};
+        drawSegments(pc, segment, 2, graphRight + m_plotFraction - (newSamples - 1) * xStep,
+                     xStep, graphTop, graphBottom);
+        drawSegments(pc, values, static_cast<std::size_t>(newSamples), graphRight + m_plotFraction,
+                     xStep, graphTop, graphBottom);
+        cairo_restore(pc);
+        cairo_destroy(pc);
+        m_plotIndex = target;
+    }
+    
+    m_plotEndSequence = endSequence;
+    m_plotLastValue = samples.empty() ? 0.0 : samples.back();
+    
+    // Composite the plot inside the graph area
+    cairo_save(cr);
+    cairo_rectangle(cr, graphLeft, graphTop - 2, graphRight - graphLeft, graphBottom - graphTop + 4);
+    cairo_clip(cr);
+    cairo_set_source_surface(cr, m_plotSurface[m_plotIndex], 0, 0);
+    cairo_paint(cr);
+    cairo_restore(cr);
+}
+
+void ResourceGraph::drawSegments(cairo_t* cr, const double* values, std::size_t count, double xNewest,
+                                 double xStep, double graphTop, double graphBottom, bool secondary) {
+    if (count < 2) {
+        return;
+    }
+    
+    // Gaps (NaN samples) split the line into runs drawn one by one
+    if (std::any_of(values, values + count, [](double value) { return std::isnan(value); })) {
+        std::size_t start = 0;
+        for (std::size_t i = 0; i <= count; i++) {
+            if (i == count || std::isnan(values[i])) {
+                if (i > start) {
+                    drawSegments(cr, values + start, i - start, xNewest - (count - i) * xStep, xStep,
+                                 graphTop, graphBottom, secondary);
+                }
+                start = i + 1;
+            }
+        }
+        return;
+    }
+    
+    double graphHeight = graphBottom - graphTop;
+    double xOldest = xNewest - (count - 1) * xStep;
+    
+    // With more samples than pixel columns, reduce them to the per-column
+    // first/min/max/last points, which cover exactly the same pixels
+    std::size_t columns = static_cast<std::size_t>(std::ceil((count - 1) * xStep)) + 1;
+    downsampleM4(values, count, columns, m_points);
+    
+    // Area under the line
+    double yScale = graphHeight / m_scale;
+    if (!secondary) {
+        cairo_move_to(cr, xOldest, graphBottom);
+        for (const DownsamplePoint& point : m_points) {
+            cairo_line_to(cr, xOldest + point.index * xStep, graphBottom - point.value * yScale);
+        }
+        cairo_line_to(cr, xNewest, graphBottom);
+        cairo_close_path(cr);
+        cairo_set_source_rgba(cr, m_colorR, m_colorG, m_colorB, 0.2);
+        cairo_fill(cr);
+    }
+    
+    // The line itself
+    cairo_move_to(cr, xOldest, graphBottom - m_points.front().value * yScale);
+    for (std::size_t i = 1; i < m_points.size(); i++) {
+        const DownsamplePoint& point = m_points[i];
+        cairo_line_to(cr, xOldest + point.index * xStep, graphBottom - point.value * yScale);
+    }
+    if (secondary) {
+        cairo_set_source_rgb(cr, m_secondaryR, m_secondaryG, m_secondaryB);
+    } else {
+        cairo_set_source_rgb(cr, m_colorR, m_colorG, m_colorB);
+    }
+    cairo_set_line_width(cr, 2);
+    cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
+    cairo_stroke(cr);
+}
+
+void ResourceGraph::invalidateStaticLayer() {
+    if (m_staticLayer) {
+        cairo_surface_destroy(m_staticLayer);
+        m_staticLayer = nullptr;
+    }
+}
+
+void ResourceGraph::drawStaticLayer(cairo_t* cr, int width, int height) {
     // Clear background
     cairo_set_source_rgb(cr, 0.15, 0.15, 0.15);
     cairo_paint(cr);
@@ -125,19 +582,6 @@ void ResourceGraph::draw(cairo_t* cr, int width, int height) {
     cairo_move_to(cr, (width - extents.width) / 2, 15);
     cairo_show_text(cr, m_title.c_str());
     
-    // If no data, show a message and return
-    if (!m_data || m_data->getSize() == 0) {
-        cairo_set_font_size(cr, 10);
-        const char* msg = "No data available";
-        cairo_text_extents(cr, msg, &extents);
-        cairo_move_to(cr, (width - extents.width) / 2, height / 2);
-        cairo_show_text(cr, msg);
-        return;
-    }
-    
-    // Get data samples
-    std::vector<double> samples = m_data->getSamples();
-    
     // Calculate graph dimensions
     double graphTop = 25;
     double graphBottom = height - 25;
@@ -150,10 +594,12 @@ void ResourceGraph::draw(cairo_t* cr, int width, int height) {
     cairo_set_font_size(cr, 9);
     cairo_set_source_rgb(cr, 0.7, 0.7, 0.7);
     
-    // Draw horizontal grid lines and labels
+    // Draw horizontal grid lines and labels; byte labels are wider, so
+    // only every other line gets one
+    int labelStep = m_valueFormat == ValueFormat::Percent ? 1 : 2;
     for (int i = 0; i <= 10; i++) {
         double y = graphBottom - (i * graphHeight / 10);
-        double value = i * 10.0; // 0% to 100%
+        double value = i * m_scale / 10.0;
         
         // Draw grid line
         cairo_set_source_rgba(cr, 0.3, 0.3, 0.3, 0.5);
@@ -161,9 +607,13 @@ void ResourceGraph::draw(cairo_t* cr, int width, int height) {
         cairo_line_to(cr, graphRight, y);
         cairo_stroke(cr);
         
+        if (i % labelStep != 0) {
+            continue;
+        }
+        
         // Draw label
         cairo_set_source_rgb(cr, 0.7, 0.7, 0.7);
-        std::string label = std::to_string(static_cast<int>(value)) + "%";
+        std::string label = formatValue(value);
         cairo_text_extents(cr, label.c_str(), &extents);
         cairo_move_to(cr, graphLeft - extents.width - 5, y + extents.height / 2);
         cairo_show_text(cr, label.c_str());
@@ -176,54 +626,182 @@ void ResourceGraph::draw(cairo_t* cr, int width, int height) {
     cairo_stroke(cr);
     
     // Draw time labels
-    std::vector<std::string> timeLabels = {"Now", "1m", "2m", "3m", "4m", "5m"};
-    for (size_t i = 0; i < timeLabels.size(); i++) {
-        double x = graphRight - (i * graphWidth / (timeLabels.size() - 1));
-        cairo_text_extents(cr, timeLabels[i].c_str(), &extents);
+    const int timeLabelCount = 6;
+    for (int i = 0; i < timeLabelCount; i++) {
+        double x = graphRight - (i * graphWidth / (timeLabelCount - 1));
+        std::string label = formatTimeOffset(m_timeRange * i / (timeLabelCount - 1));
+        cairo_text_extents(cr, label.c_str(), &extents);
         cairo_move_to(cr, x - extents.width / 2, graphBottom + 15);
-        cairo_show_text(cr, timeLabels[i].c_str());
+        cairo_show_text(cr, label.c_str());
     }
-    
-    // Draw the graph line
-    if (samples.size() > 1) {
-        // Set color for the graph line
+}
+
+void ResourceGraph::drawSamples(cairo_t* cr, const double* values, std::size_t count, bool secondary,
+                                double graphLeft, double graphTop,
+                                double graphRight, double graphBottom) {
+    // A tiered source keeps the time scale fixed; a plain history stretches over the width
+    double points = m_rollup ? static_cast<double>(visiblePoints()) : static_cast<double>(count);
+    if (count > 1) {
+        double x_scale = (graphRight - graphLeft) / (points - 1);
+        drawSegments(cr, values, count, graphRight, x_scale, graphTop, graphBottom, secondary);
+    }
+}
+
+double ResourceGraph::drawCurrentValue(cairo_t* cr, double value, bool secondary,
+                                       double graphTop, double right) {
+    cairo_text_extents_t extents;
+    std::string valueText = formatValue(value);
+    cairo_set_font_size(cr, 14);
+    if (secondary) {
+        cairo_set_source_rgb(cr, m_secondaryR, m_secondaryG, m_secondaryB);
+    } else {
         cairo_set_source_rgb(cr, m_colorR, m_colorG, m_colorB);
-        cairo_set_line_width(cr, 2);
-        
-        // Start the path at the first point
-        size_t numPoints = samples.size();
-        double x_scale = graphWidth / (static_cast<double>(numPoints) - 1);
-        
-        // Move to the first point
-        double x = graphRight - 0;
-        double y = graphBottom - (samples[numPoints - 1] * graphHeight / 100.0);
-        cairo_move_to(cr, x, y);
+    }
+    cairo_text_extents(cr, valueText.c_str(), &extents);
+    cairo_move_to(cr, right - extents.width, graphTop + 15);
+    cairo_show_text(cr, valueText.c_str());
+    return right - extents.width;
+}
+
+// Реализация класса CPUHeatmap
+
+CPUHeatmap::CPUHeatmap()
+    : m_surface(nullptr),
+      m_columns(0)
+{
+    m_drawingArea = gtk_drawing_area_new();
+    gtk_widget_set_size_request(m_drawingArea, 300, 120);
+    g_signal_connect(G_OBJECT(m_drawingArea), "draw", G_CALLBACK(drawCallback), this);
+    
+    // Dark blue (idle) through green and yellow to red (busy)
+    for (int i = 0; i <= 100; i++) {
+        double t = i / 100.0;
+        double r = std::min(1.0, std::max(0.0, 2.0 * t - 0.2));
+        double g = std::min(1.0, std::max(0.0, t < 0.6 ? 1.6 * t : 2.5 * (1.0 - t)));
+        double b = std::max(0.0, 0.5 - 1.2 * t) + 0.15;
+        m_palette[i] = 0xff000000u |
+                       (static_cast<uint32_t>(r * 255) << 16) |
+                       (static_cast<uint32_t>(g * 255) << 8) |
+                       static_cast<uint32_t>(b * 255);
+    }
+}
+
+CPUHeatmap::~CPUHeatmap() {
+    if (m_surface) {
+        cairo_surface_destroy(m_surface);
+    }
+}
+
+GtkWidget* CPUHeatmap::getWidget() {
+    return m_drawingArea;
+}
+
+void CPUHeatmap::setDataSources(const std::vector<HistoryData*>& cores) {
+    m_cores = cores;
+    
+    // The image is sized once for the data, not for the widget
+    if (m_surface) {
+        cairo_surface_destroy(m_surface);
+        m_surface = nullptr;
+    }
+    m_columns = m_cores.empty() || !m_cores[0] ? 0 : static_cast<int>(m_cores[0]->getCapacity());
+    if (m_columns > 0) {
+        m_surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, m_columns, static_cast<int>(m_cores.size()));
+    }
+}
+
+void CPUHeatmap::redraw() {
+    if (m_drawingArea && gtk_widget_get_realized(m_drawingArea)) {
+        gtk_widget_queue_draw(m_drawingArea);
+    }
+}
+
+gboolean CPUHeatmap::drawCallback(GtkWidget* widget, cairo_t* cr, gpointer data) {
+    CPUHeatmap* heatmap = static_cast<CPUHeatmap*>(data);
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+    
+    heatmap->draw(cr, width, height);
+    
+    return FALSE;
+}
+
+void CPUHeatmap::fillSurface() {
+    cairo_surface_flush(m_surface);
+    unsigned char* pixels = cairo_image_surface_get_data(m_surface);
+    int stride = cairo_image_surface_get_stride(m_surface);
+    
+    for (std::size_t core = 0; core < m_cores.size(); core++) {
+        uint32_t* row = reinterpret_cast<uint32_t*>(pixels + core * stride);
         
-        // Draw lines to each subsequent point
-        for (size_t i = 1; i < numPoints; i++) {
-            x = graphRight - (i * x_scale);
-            y = graphBottom - (samples[numPoints - i - 1] * graphHeight / 100.0);
-            cairo_line_to(cr, x, y);
+        // Newest sample in the rightmost column, like ResourceGraph
+        SampleView samples = m_cores[core]->snapshot();
+        std::size_t count = std::min<std::size_t>(samples.size(), m_columns);
+        std::size_t blank = m_columns - count;
+        std::fill(row, row + blank, m_palette[0]);
+        const double* src = samples.end() - count;
+        for (std::size_t i = 0; i < count; i++) {
+            int level = static_cast<int>(src[i] + 0.5);
+            row[blank + i] = m_palette[std::min(100, std::max(0, level))];
         }
-        
-        // Stroke the path
-        cairo_stroke(cr);
-        
-        // Fill the area under the graph
-        cairo_line_to(cr, graphLeft, graphBottom);
-        cairo_line_to(cr, graphRight, graphBottom);
-        cairo_close_path(cr);
-        cairo_set_source_rgba(cr, m_colorR, m_colorG, m_colorB, 0.2);
-        cairo_fill(cr);
     }
     
-    // Draw the current value
-    if (!samples.empty()) {
-        std::string valueText = std::to_string(static_cast<int>(samples.back())) + "%";
-        cairo_set_font_size(cr, 14);
-        cairo_set_source_rgb(cr, m_colorR, m_colorG, m_colorB);
-        cairo_text_extents(cr, valueText.c_str(), &extents);
-        cairo_move_to(cr, graphRight - extents.width - 5, graphTop + 15);
-        cairo_show_text(cr, valueText.c_str());
+    cairo_surface_mark_dirty(m_surface);
+}
+
+void CPUHeatmap::draw(cairo_t* cr, int width, int height) {
+    ScopedProbe probe(Probe::HeatmapDraw);
+    
+    // Clear background
+    cairo_set_source_rgb(cr, 0.15, 0.15, 0.15);
+    cairo_paint(cr);
+    
+    // Draw title
+    std::string title = "Загрузка ядер (" + std::to_string(m_cores.size()) + ")";
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 12);
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+    cairo_text_extents_t extents;
+    cairo_text_extents(cr, title.c_str(), &extents);
+    cairo_move_to(cr, (width - extents.width) / 2, 15);
+    cairo_show_text(cr, title.c_str());
+    
+    if (!m_surface || m_cores.empty()) {
+        return;
+    }
+    
+    double plotTop = 25;
+    double plotLeft = 40;
+    double plotWidth = width - 10 - plotLeft;
+    double plotHeight = height - 5 - plotTop;
+    if (plotWidth <= 0 || plotHeight <= 0) {
+        return;
+    }
+    
+    fillSurface();
+    
+    // Scale the one-pixel-per-sample image to the plot area without smoothing
+    cairo_save(cr);
+    cairo_rectangle(cr, plotLeft, plotTop, plotWidth, plotHeight);
+    cairo_clip(cr);
+    cairo_translate(cr, plotLeft, plotTop);
+    cairo_scale(cr, plotWidth / m_columns, plotHeight / m_cores.size());
+    cairo_set_source_surface(cr, m_surface, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+    cairo_paint(cr);
+    cairo_restore(cr);
+    
+    // Label the first and last core rows
+    cairo_set_font_size(cr, 9);
+    cairo_set_source_rgb(cr, 0.7, 0.7, 0.7);
+    std::string first = "0";
+    std::string last = std::to_string(m_cores.size() - 1);
+    cairo_text_extents(cr, first.c_str(), &extents);
+    cairo_move_to(cr, plotLeft - extents.width - 5, plotTop + extents.height);
+    cairo_show_text(cr, first.c_str());
+    if (m_cores.size() > 1) {
+        cairo_text_extents(cr, last.c_str(), &extents);
+        cairo_move_to(cr, plotLeft - extents.width - 5, plotTop + plotHeight);
+        cairo_show_text(cr, last.c_str());
     }
 }
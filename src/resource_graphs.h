@@ -3,10 +3,21 @@
 
 #include <gtk/gtk.h>
 #include <string>
+#include <vector>
+#include <cstdint>
 #include "history_data.h"
+#include "rollup_history.h"
+#include "downsample.h"
 
 class ResourceGraph {
 public:
+    // How values are scaled and labelled
+    enum class ValueFormat {
+        Percent,            // Fixed 0-100 % axis
+        ScaledPercent,      // Percent axis scaled to the visible peak, for small shares
+        BytesPerSecond      // Axis scaled to the visible peak
+    };
+    
     ResourceGraph();
     ~ResourceGraph();
     
@@ -16,34 +27,130 @@ public:
     // Set the data source
     void setDataSource(HistoryData* data);
     
+    // Set a multi-resolution data source. The graph plots raw samples while
+    // the visible time range fits the raw series or the compressed archive,
+    // and the average of the matching rollup tier beyond that.
+    void setDataSource(RollupHistory* history);
+    
+    // Set the time range shown on the x axis, in seconds
+    void setTimeRange(double seconds);
+    
+    // Second line drawn over the first without fill, e.g. transmit over
+    // receive. Must have the same tier layout as the primary source, or be
+    // a plain history next to a plain primary one.
+    void setSecondaryDataSource(RollupHistory* history);
+    void setSecondaryDataSource(HistoryData* data);
+    void setSecondaryColor(double r, double g, double b);
+    
+    // Set the value scale and labels
+    void setValueFormat(ValueFormat format);
+    
     // Set graph color
     void setColor(double r, double g, double b);
     
     // Set title
     void setTitle(const std::string& title);
     
+    // In scroll mode each repaint shifts the previously rendered plot left
+    // and draws only the samples added since, so a tick costs O(1) whatever
+    // the history length. The x axis then always spans the full capacity.
+    // Only a single percent series scrolls; autoscaled graphs and graphs
+    // with a secondary line are redrawn in full.
+    void setScrollMode(bool enabled);
+    
     // Force redraw
     void redraw();
     
+    // Draw the graph into any cairo context, e.g. an offscreen image surface
+    void draw(cairo_t* cr, int width, int height);
+    
 private:
     GtkWidget* m_drawingArea;
-    HistoryData* m_data;
+    HistoryData* m_data;                // Series being plotted
+    RollupHistory* m_rollup;            // Tiered source, or nullptr for a plain history
+    double m_timeRange;                 // Visible time range, seconds
+    bool m_useArchive;                  // Plot the compressed raw archive of m_rollup
+    RollupHistory* m_secondary;
+    HistoryData* m_secondaryData;       // Tier of m_secondary matching m_data
+    double m_secondaryR;
+    double m_secondaryG;
+    double m_secondaryB;
+    ValueFormat m_valueFormat;
+    double m_scale;                     // Value at the top of the y axis
     double m_colorR;
     double m_colorG;
     double m_colorB;
     std::string m_title;
     
+    // Background, grid, axes and labels rendered once per size/title
+    cairo_surface_t* m_staticLayer;
+    int m_cacheWidth;
+    int m_cacheHeight;
+    
+    // Scroll mode: two plot surfaces used alternately as blit source and target
+    bool m_scrollMode;
+    cairo_surface_t* m_plotSurface[2];
+    int m_plotIndex;
+    std::uint64_t m_plotEndSequence;    // Sample sequence drawn up to, 0 if nothing
+    double m_plotFraction;              // Sub-pixel shift not yet applied by the blit
+    double m_plotLastValue;             // Newest sample on the plot, start of the next segment
+    
+    // Downsampled path points, reused across frames
+    std::vector<DownsamplePoint> m_points;
+    
+    // Archive samples decoded for the current frame, reused across frames
+    std::vector<double> m_decoded;
+    std::vector<double> m_decodedSecondary;
+    
     // Draw callback for the drawing area
     static gboolean drawCallback(GtkWidget* widget, cairo_t* cr, gpointer data);
     
-    // Draw the graph
-    void draw(cairo_t* cr, int width, int height);
+    // Render everything that does not depend on the samples
+    void drawStaticLayer(cairo_t* cr, int width, int height);
+    void invalidateStaticLayer();
+    
+    // Pick the series to plot for the current source and time range
+    void selectSeries();
+    
+    // Number of points that span the x axis
+    std::size_t visiblePoints() const;
+    
+    // Values of a series inside the visible range, oldest first. Archive
+    // samples are decoded into `decoded`; otherwise they point into `samples`.
+    std::size_t visibleValues(RollupHistory* history, const SampleView& samples,
+                              std::vector<double>& decoded, const double*& values);
+    
+    // Pick the top of the y axis for the visible peak
+    void updateScale(double peak);
+    
+    // Axis and current value label for a value
+    std::string formatValue(double value) const;
+    
+    // Scroll mode rendering of the data line into the plot surfaces
+    void drawScrolling(cairo_t* cr, const SampleView& samples,
+                       double graphLeft, double graphTop,
+                       double graphRight, double graphBottom);
+    // Fill and stroke the line through values, oldest first, ending at xNewest.
+    // Downsamples to the pixel width, so the cost is bounded by the width.
+    // The secondary line is stroked in its own colour and not filled.
+    void drawSegments(cairo_t* cr, const double* values, std::size_t count, double xNewest,
+                      double xStep, double graphTop, double graphBottom, bool secondary = false);
+    void releasePlotSurfaces();
+
+    // Draw a data line, newest value at the right edge
+    void drawSamples(cairo_t* cr, const double* values, std::size_t count, bool secondary,
+                     double graphLeft, double graphTop,
+                     double graphRight, double graphBottom);
+    
+    // Draw a current value right-aligned at `right`; returns its left edge
+    double drawCurrentValue(cairo_t* cr, double value, bool secondary, double graphTop, double right);
 };
 
 // Класс для отображения графика использования диска с дополнительной информацией
 class DiskGraphPanel {
 public:
-    DiskGraphPanel(const std::string& name, const std::string& device, ResourceGraph* graph);
+    // graph shows the fill level, ioGraph the read and write throughput
+    DiskGraphPanel(const std::string& name, const std::string& device, ResourceGraph* graph, ResourceGraph* ioGraph);
     ~DiskGraphPanel();
     
     // Получить основной виджет
@@ -52,15 +159,57 @@ public:
     // Обновить информацию о диске
     void updateInfo(double usedGB, double totalGB, double usagePercent);
     
-    // Получить график
+    // Обновить операции в секунду, среднее ожидание и загрузку устройства
+    void updateIO(double readOps, double writeOps, double awaitMs, double utilization);
+    
+    // Получить графики
     ResourceGraph* getGraph();
+    ResourceGraph* getIOGraph();
     
 private:
     GtkWidget* m_mainBox;
     GtkWidget* m_infoLabel;
+    GtkWidget* m_ioLabel;
+    double m_lastUsedGB;        // Last values shown, to skip redundant label updates
+    double m_lastTotalGB;
+    double m_lastPercent;
     std::string m_name;
     std::string m_device;
     ResourceGraph* m_graph;
+    ResourceGraph* m_ioGraph;
+};
+
+// Core-by-time heatmap of per-core CPU usage: one row per core, one column per
+// sample. Replaces one ResourceGraph per core, which does not scale to 100+ cores.
+class CPUHeatmap {
+public:
+    CPUHeatmap();
+    ~CPUHeatmap();
+    
+    // Get the heatmap widget
+    GtkWidget* getWidget();
+    
+    // Set one history per core, in core order
+    void setDataSources(const std::vector<HistoryData*>& cores);
+    
+    // Force redraw
+    void redraw();
+    
+    // Draw the heatmap into any cairo context
+    void draw(cairo_t* cr, int width, int height);
+    
+private:
+    GtkWidget* m_drawingArea;
+    std::vector<HistoryData*> m_cores;
+    cairo_surface_t* m_surface;     // cores x columns image, one pixel per sample
+    int m_columns;
+    uint32_t m_palette[101];        // ARGB colour per usage percent
+    
+    // Draw callback for the drawing area
+    static gboolean drawCallback(GtkWidget* widget, cairo_t* cr, gpointer data);
+    
+    // Write the newest samples of every core into the image
+    void fillSurface();
 };
 
 #endif // RESOURCE_GRAPHS_H
@@ -1,12 +1,62 @@
 #include "resource_monitor.h"
-#include <fstream>
-#include <sstream>
+#include "diagnostics.h"
+#include "monitor_clock.h"
 #include <iostream>
 #include <cstring>
+#include <cerrno>
 #include <chrono>
 #include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <unistd.h>
 #include <sys/statvfs.h>
-#include <mntent.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+// Persisted samples per series: 24 hours at 1 second interval. Older time
+// is persisted as the buckets of the coarsest tier, in a second file with
+// this suffix; '_' is escaped in every series name, so they never clash.
+static const std::size_t kStoreCapacity = 86400;
+static const char kBucketSuffix[] = "_buckets";
+
+// Histories of interfaces and devices that went away are freed this long
+// after their last sample
+static const std::int64_t kSeriesExpiryMs = 10 * 60 * 1000;
+
+// Processes kept in the top list
+static const std::size_t kTopProcesses = 15;
+
+// Mark the samples missed between two timestamps as a gap
+static void addGap(RollupHistory* history, std::int64_t from, std::int64_t to, std::int64_t intervalMs) {
+    std::int64_t missing = (to - from + intervalMs / 2) / intervalMs - 1;
+    if (missing > 0) {
+        history->addGap(static_cast<std::size_t>(missing), to - intervalMs);
+    }
+}
+
+// Store file name for a disk, e.g. "disk%2Fhome" for /home. Every byte
+// other than [A-Za-z0-9.-] is written as %XX, so distinct mount points
+// never share a file.
+static std::string diskStoreName(const std::string& mountpoint) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string name = "disk";
+    for (char c : mountpoint) {
+        bool plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                     c == '-' || c == '.';
+        if (plain) {
+            name += c;
+        } else {
+            unsigned char byte = static_cast<unsigned char>(c);
+            name += '%';
+            name += hex[byte >> 4];
+            name += hex[byte & 0xf];
+        }
+    }
+    return name;
+}
 
 CPUStats CPUStats::operator-(const CPUStats& other) const {
     CPUStats result;
@@ -27,10 +77,34 @@ unsigned long long CPUStats::total() const {
     return user + nice + system + idle + iowait + irq + softirq + steal;
 }
 
-ResourceMonitor::ResourceMonitor(Settings* settings)
+void CPUStatsSet::resize(std::size_t count) {
+    user.resize(count);
+    nice.resize(count);
+    system.resize(count);
+    idle.resize(count);
+    iowait.resize(count);
+    irq.resize(count);
+    softirq.resize(count);
+    steal.resize(count);
+}
+
+std::size_t CPUStatsSet::size() const {
+    return user.size();
+}
+
+ResourceMonitor::ResourceMonitor(Settings* settings, const std::string& root)
     : m_settings(settings),
+      m_root(root),
       m_cpuUsage(0.0),
-      m_lastUpdate(std::chrono::steady_clock::now())
+      m_sampleCount(0),
+      m_sampleTimestamp(0),
+      m_processCollector(root + "/proc"),
+      m_cgroupCollector(root + "/sys/fs/cgroup"),
+      m_diskPollInterval(settings->getDiskPollInterval() * 1000),
+      m_capacityPolled(false),
+      m_lastUpdate(std::chrono::steady_clock::now()),
+      m_statFile(64 * 1024),
+      m_meminfoFile(8 * 1024)
 {
     // Default constructor
 }
@@ -41,22 +115,90 @@ ResourceMonitor::~ResourceMonitor() {
 
 bool ResourceMonitor::initialize() {
     // Initialize history data containers
-    std::size_t historySize = 600; // Store 10 minutes of data with 1 second interval
-    m_cpuHistory = std::make_unique<HistoryData>(historySize);
-    m_memHistory = std::make_unique<HistoryData>(historySize);
+    // Store 10 minutes of raw data with 1 second interval, older data
+    // is kept in coarser rollup tiers
+    std::size_t historySize = 600;
+    double interval = m_settings->getSampleInterval() / 1000.0;
+    m_cpuHistory = std::make_unique<RollupHistory>(historySize, interval);
+    m_memHistory = std::make_unique<RollupHistory>(historySize, interval);
+    
+    // History survives restarts in ~/.local/share/system-monitor. A foreign
+    // root (a replay) must not mix into the history of this machine.
+    const char* homeDir = getenv("HOME");
+    if (homeDir && m_root.empty()) {
+        std::filesystem::path storeDir = std::string(homeDir) + "/.local/share/system-monitor";
+        std::error_code error;
+        std::filesystem::create_directories(storeDir, error);
+        if (error) {
+            std::cerr << "Failed to create history directory: " << error.message() << std::endl;
+        } else {
+            m_storeDirectory = storeDir.string();
+        }
+    }
+    m_cpuStore = openStore("cpu", m_cpuHistory.get());
+    m_memStore = openStore("memory", m_memHistory.get());
     
     // Read initial CPU stats
-    if (!readCPUStats(m_prevCPUStats)) {
+    if (!readCPUStats(m_prevCPUStats, m_prevCoreStats)) {
         std::cerr << "Failed to read initial CPU stats!" << std::endl;
         return false;
     }
     
+    // One history per core present at startup
+    m_coreStats.resize(m_prevCoreStats.size());
+    m_coreUsage.assign(m_prevCoreStats.size(), 0.0);
+    m_coreHistory.clear();
+    for (std::size_t i = 0; i < m_prevCoreStats.size(); i++) {
+        m_coreHistory.push_back(std::make_unique<HistoryData>(historySize));
+    }
+    
     // Read initial memory info
     if (!readMemoryInfo()) {
         std::cerr << "Failed to read memory info!" << std::endl;
         return false;
     }
     
+    // Per-process statistics are optional
+    if (!m_processCollector.open()) {
+        std::cerr << "Failed to open " << m_root << "/proc, process list disabled" << std::endl;
+    } else {
+        m_processCollector.update();    // Baseline for the first CPU deltas
+    }
+    
+    // Pressure stall information needs a kernel with PSI enabled
+    if (!m_pressureCollector.open((m_root + "/proc/pressure").c_str())) {
+        std::cerr << "Failed to open " << m_root << "/proc/pressure, pressure graphs disabled" << std::endl;
+    } else {
+        for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+            m_pressureAvg10History[i] = std::make_unique<HistoryData>(historySize);
+            m_pressureAvg60History[i] = std::make_unique<HistoryData>(historySize);
+        }
+    }
+    
+    // Per-cgroup statistics need the unified cgroup v2 hierarchy
+    if (!m_cgroupCollector.open()) {
+        std::cerr << "Failed to open " << m_root << "/sys/fs/cgroup as cgroup v2, container list disabled" << std::endl;
+    }
+    
+    // Network statistics are optional as well
+    m_networkCollector.setExcludedPrefixes(NetworkCollector::parsePrefixList(m_settings->getNetworkExclude()));
+    if (!m_networkCollector.open((m_root + "/proc/net/dev").c_str())) {
+        std::cerr << "Failed to open " << m_root << "/proc/net/dev, network graphs disabled" << std::endl;
+    } else {
+        m_networkCollector.update();    // Baseline for the first rates
+    }
+    
+    // Watch the mount table for changes. Files below a root never signal
+    // a change, so there the table is reread every update.
+    if (m_root.empty() && !m_mountTable.open()) {
+        std::cerr << "Failed to watch /proc/self/mountinfo, rereading mounts every update" << std::endl;
+    }
+    
+    // Block device statistics are optional
+    if (!m_diskIOCollector.open((m_root + "/proc/diskstats").c_str())) {
+        std::cerr << "Failed to open " << m_root << "/proc/diskstats, disk I/O graphs disabled" << std::endl;
+    }
+    
     // Read initial disk info
     if (!readDiskInfo()) {
         std::cerr << "Failed to read disk info!" << std::endl;
@@ -64,6 +206,9 @@ bool ResourceMonitor::initialize() {
     }
     
     // История дисков уже инициализирована в readDiskInfo()
+    if (m_diskIOCollector.isOpen()) {
+        m_diskIOCollector.update();     // Baseline for the first rates
+    }
     
     return true;
 }
@@ -77,40 +222,128 @@ void ResourceMonitor::update() {
     // Update only if enough time has passed (1 second)
     if (elapsed >= 1000) {
         m_lastUpdate = currentTime;
+        sample();
+    }
+}
+
+void ResourceMonitor::sample() {
+    ScopedProbe probe(Probe::Sample);
+    std::int64_t timestamp = MonitorClock::wallMillis();
+    m_sampleTimestamp = timestamp;
+    
+    // Update CPU usage
+    CPUStats currentStats;
+    if (readCPUStats(currentStats, m_coreStats)) {
+        CPUStats diff = currentStats - m_prevCPUStats;
+        unsigned long long total = diff.total();
+        unsigned long long idle = diff.idle + diff.iowait;
         
-        // Update CPU usage
-        CPUStats currentStats;
-        if (readCPUStats(currentStats)) {
-            CPUStats diff = currentStats - m_prevCPUStats;
-            unsigned long long total = diff.total();
-            unsigned long long idle = diff.idle + diff.iowait;
-            
-            if (total > 0) {
-                m_cpuUsage = 100.0 * (total - idle) / total;
-                m_cpuHistory->addSample(m_cpuUsage);
-            }
-            
-            m_prevCPUStats = currentStats;
+        if (total > 0) {
+            m_cpuUsage = 100.0 * (total - idle) / total;
+            recordSample(m_cpuHistory.get(), m_cpuStore, m_cpuUsage, timestamp);
         }
         
-        // Update memory info
-        if (readMemoryInfo()) {
-            m_memHistory->addSample(m_memInfo.percent);
+        m_prevCPUStats = currentStats;
+        
+        computeCoreUsage();
+        std::size_t tracked = std::min(m_coreHistory.size(), m_coreUsage.size());
+        for (std::size_t i = 0; i < tracked; i++) {
+            m_coreHistory[i]->addSample(m_coreUsage[i]);
         }
         
-        // Update disk info
-        if (readDiskInfo()) {
-            for (const auto& disk : m_diskInfo) {
-                m_diskHistory[disk.mountpoint]->addSample(disk.percent);
+        // Copied rather than swapped: readCPUStats() leaves the counters of
+        // offline cores as they are, so both sets must hold this sample's
+        // values, and an offline core reads as idle instead of replaying an
+        // older interval. Same sizes, so the copy does not allocate.
+        m_prevCoreStats = m_coreStats;
+    }
+    
+    // Update memory info
+    if (readMemoryInfo()) {
+        recordSample(m_memHistory.get(), m_memStore, m_memInfo.percent, timestamp);
+    }
+    
+    // Update disk info
+    if (readDiskInfo()) {
+        for (const auto& disk : m_diskInfo) {
+            // Entries are only added and removed on this thread, so they
+            // stay valid once the lock is released
+            DiskHistory* history;
+            {
+                std::lock_guard<std::mutex> lock(m_diskHistoryMutex);
+                auto it = m_diskHistory.find(disk.mountpoint);
+                if (it == m_diskHistory.end()) {
+                    continue;
+                }
+                history = &it->second;
             }
+            recordSample(history->usage.get(), history->store, disk.percent, timestamp);
+            history->lastSeen = timestamp;
+        }
+        expireDiskHistories(timestamp);
+    }
+    
+    // Update disk I/O rates
+    readDiskIO(timestamp);
+    
+    // Update the process list
+    if (m_processCollector.isOpen()) {
+        ScopedProbe probe(Probe::Processes);
+        if (m_processCollector.update()) {
+            m_processCollector.topByCPU(kTopProcesses, m_topProcesses);
+        }
+    }
+    
+    // Update cgroups within their time budget
+    if (m_cgroupCollector.isOpen()) {
+        ScopedProbe probe(Probe::Cgroups);
+        std::lock_guard<std::mutex> lock(m_cgroupMutex);
+        if (m_root.empty()) {
+            m_cgroupCollector.update();
+        } else {
+            // No time budget for a recorded tree, so every run of a replay
+            // reads the same cgroups on the same tick
+            m_cgroupCollector.update(std::chrono::seconds(60));
         }
+        m_cgroupCollector.topByCPU(kTopProcesses, m_topCgroups);
     }
+    
+    // Update pressure stall averages
+    readPressure();
+    
+    // Update network interfaces
+    readNetworkInfo(timestamp);
+    
+    m_sampleCount++;
+}
+
+void ResourceMonitor::fillSnapshot(ResourceSnapshot& snapshot) const {
+    snapshot.sequence = m_sampleCount;
+    snapshot.timestamp = m_sampleTimestamp;
+    snapshot.cpuUsage = m_cpuUsage;
+    snapshot.coreUsage = m_coreUsage;
+    snapshot.memInfo = m_memInfo;
+    snapshot.diskInfo = m_diskInfo;
+    snapshot.topProcesses = m_topProcesses;
+    snapshot.networkInfo = m_networkCollector.interfaces();
+    snapshot.topCgroups = m_topCgroups;
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        snapshot.pressure[i] = m_pressureCollector.get(static_cast<PressureResource>(i));
+    }
+}
+
+void ResourceMonitor::setDiskPollInterval(int seconds) {
+    m_diskPollInterval.store(seconds * 1000, std::memory_order_relaxed);
 }
 
 double ResourceMonitor::getCPUUsage() const {
     return m_cpuUsage;
 }
 
+const std::vector<double>& ResourceMonitor::getCoreUsage() const {
+    return m_coreUsage;
+}
+
 const MemoryInfo& ResourceMonitor::getMemoryInfo() const {
     return m_memInfo;
 }
@@ -119,106 +352,318 @@ const std::vector<DiskInfo>& ResourceMonitor::getDiskInfo() const {
     return m_diskInfo;
 }
 
-HistoryData* ResourceMonitor::getCPUHistory() const {
+ResourceMonitor::SeriesFiles ResourceMonitor::openStore(const std::string& name, RollupHistory* history) {
+    SeriesFiles files;
+    if (m_storeDirectory.empty()) {
+        return files;
+    }
+    
+    std::string path = m_storeDirectory + "/" + name + ".series";
+    files.samples = std::make_unique<SeriesStore>(kStoreCapacity);
+    if (!files.samples->open(path)) {
+        if (errno == EWOULDBLOCK) {
+            std::cerr << "History file " << path << " is in use by another process, not persisting it" << std::endl;
+        } else {
+            std::cerr << "Failed to open history file: " << path << std::endl;
+        }
+        files.samples.reset();
+        return files;
+    }
+    
+    // One record per bucket of the coarsest tier, as many as it holds
+    std::size_t coarsest = history->getTierCount() - 1;
+    if (coarsest > 0) {
+        std::string bucketPath = m_storeDirectory + "/" + name + kBucketSuffix + ".series";
+        files.buckets = std::make_unique<SeriesStore>(history->getTierAverage(coarsest)->getCapacity());
+        if (!files.buckets->open(bucketPath)) {
+            std::cerr << "Failed to open history file: " << bucketPath << std::endl;
+            files.buckets.reset();
+        }
+    }
+    
+    // The records are read straight from the mappings, oldest first. Those
+    // older than the longest tier are out of every graph; the rest keep their
+    // place in time, with a gap wherever the monitor was not running.
+    const SeriesStore& samples = *files.samples;
+    std::int64_t now = MonitorClock::wallMillis();
+    std::int64_t intervalMs = std::max<std::int64_t>(1, std::llround(history->getTierResolution(0) * 1000.0));
+    std::int64_t horizon = now - static_cast<std::int64_t>(history->getTierSpan(coarsest) * 1000.0);
+    std::int64_t previous = -1;
+    
+    // Buckets only fill in the time before the first raw sample; the raw
+    // samples rebuild every tier from there on
+    if (files.buckets) {
+        std::int64_t rawStart = now;
+        for (std::size_t i = 0; i < samples.size(); i++) {
+            std::int64_t timestamp = samples.at(i).timestamp;
+            if (timestamp >= horizon && timestamp <= now) {
+                rawStart = timestamp;
+                break;
+            }
+        }
+        std::int64_t bucketMs = std::max<std::int64_t>(1, std::llround(history->getTierResolution(coarsest) * 1000.0));
+        std::size_t capacity = files.buckets->getCapacity();
+        const double gap = std::numeric_limits<double>::quiet_NaN();
+        for (std::size_t i = 0; i < files.buckets->size(); i++) {
+            const SeriesRecord& record = files.buckets->at(i);
+            if (record.timestamp < horizon || record.timestamp >= rawStart || record.timestamp <= previous) {
+                continue;
+            }
+            if (previous >= 0) {
+                std::int64_t missing = (record.timestamp - previous + bucketMs / 2) / bucketMs - 1;
+                for (std::int64_t j = 0; j < missing && j < static_cast<std::int64_t>(capacity); j++) {
+                    history->addBucket(gap);
+                }
+            }
+            history->addBucket(record.value);
+            previous = record.timestamp;
+        }
+    }
+    
+    for (std::size_t i = 0; i < samples.size(); i++) {
+        const SeriesRecord& record = samples.at(i);
+        if (record.timestamp < horizon || record.timestamp > now || record.timestamp <= previous) {
+            continue;
+        }
+        if (previous >= 0) {
+            addGap(history, previous, record.timestamp, intervalMs);
+        }
+        history->addSample(record.value, record.timestamp);
+        previous = record.timestamp;
+    }
+    if (previous >= 0) {
+        addGap(history, previous, now, intervalMs);
+    }
+    return files;
+}
+
+void ResourceMonitor::recordSample(RollupHistory* history, SeriesFiles& store, double value, std::int64_t timestamp) {
+    bool closed = history->addSample(value, timestamp);
+    if (store.samples) {
+        store.samples->append(timestamp, value);
+    }
+    if (closed && store.buckets) {
+        SampleView buckets = history->getTierAverage(history->getTierCount() - 1)->snapshot();
+        store.buckets->append(timestamp, buckets.back());
+    }
+}
+
+const std::vector<ProcessInfo>& ResourceMonitor::getTopProcesses() const {
+    return m_topProcesses;
+}
+
+const std::vector<CgroupInfo>& ResourceMonitor::getTopCgroups() const {
+    return m_topCgroups;
+}
+
+void ResourceMonitor::getCgroups(std::vector<CgroupInfo>& out, std::vector<std::string>& paths) const {
+    std::lock_guard<std::mutex> lock(m_cgroupMutex);
+    m_cgroupCollector.getAll(out, paths);
+}
+
+const std::vector<NetworkInfo>& ResourceMonitor::getNetworkInfo() const {
+    return m_networkCollector.interfaces();
+}
+
+const PressureInfo& ResourceMonitor::getPressureInfo(PressureResource resource) const {
+    return m_pressureCollector.get(resource);
+}
+
+RollupHistory* ResourceMonitor::getCPUHistory() const {
     return m_cpuHistory.get();
 }
 
-HistoryData* ResourceMonitor::getMemoryHistory() const {
+RollupHistory* ResourceMonitor::getMemoryHistory() const {
     return m_memHistory.get();
 }
 
-HistoryData* ResourceMonitor::getDiskHistory(const std::string& mountpoint) const {
+std::size_t ResourceMonitor::getCoreCount() const {
+    return m_coreHistory.size();
+}
+
+HistoryData* ResourceMonitor::getCoreHistory(std::size_t core) const {
+    return core < m_coreHistory.size() ? m_coreHistory[core].get() : nullptr;
+}
+
+std::shared_ptr<RollupHistory> ResourceMonitor::getDiskHistory(const std::string& mountpoint) const {
+    std::lock_guard<std::mutex> lock(m_diskHistoryMutex);
     auto it = m_diskHistory.find(mountpoint);
-    if (it != m_diskHistory.end()) {
-        return it->second.get();
-    }
-    return nullptr;
+    return it != m_diskHistory.end() ? it->second.usage : nullptr;
 }
 
-bool ResourceMonitor::checkThresholds(std::string& message, ResourceType& resourceType) {
-    // Check CPU usage threshold
-    if (m_cpuUsage >= m_settings->getCPUThreshold()) {
-        message = "Высокая загрузка ЦП: " + std::to_string(static_cast<int>(m_cpuUsage)) + "%";
-        resourceType = ResourceType::CPU;
-        return true;
+std::shared_ptr<HistoryData> ResourceMonitor::getNetworkRxHistory(const std::string& interface) const {
+    std::lock_guard<std::mutex> lock(m_networkHistoryMutex);
+    auto it = m_networkHistory.find(interface);
+    return it != m_networkHistory.end() ? it->second.rx : nullptr;
+}
+
+std::shared_ptr<HistoryData> ResourceMonitor::getNetworkTxHistory(const std::string& interface) const {
+    std::lock_guard<std::mutex> lock(m_networkHistoryMutex);
+    auto it = m_networkHistory.find(interface);
+    return it != m_networkHistory.end() ? it->second.tx : nullptr;
+}
+
+std::shared_ptr<HistoryData> ResourceMonitor::getDiskReadHistory(const std::string& mountpoint) const {
+    std::lock_guard<std::mutex> lock(m_diskHistoryMutex);
+    auto it = m_diskIOHistory.find(mountpoint);
+    return it != m_diskIOHistory.end() ? it->second.read : nullptr;
+}
+
+std::shared_ptr<HistoryData> ResourceMonitor::getDiskWriteHistory(const std::string& mountpoint) const {
+    std::lock_guard<std::mutex> lock(m_diskHistoryMutex);
+    auto it = m_diskIOHistory.find(mountpoint);
+    return it != m_diskIOHistory.end() ? it->second.write : nullptr;
+}
+
+std::shared_ptr<HistoryData> ResourceMonitor::getCgroupCPUHistory(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(m_cgroupMutex);
+    return m_cgroupCollector.getCPUHistory(path);
+}
+
+std::shared_ptr<HistoryData> ResourceMonitor::getCgroupCPUHistory(std::uint64_t id) const {
+    std::lock_guard<std::mutex> lock(m_cgroupMutex);
+    return m_cgroupCollector.getCPUHistory(id);
+}
+
+HistoryData* ResourceMonitor::getPressureAvg10History(PressureResource resource) const {
+    return m_pressureAvg10History[static_cast<std::size_t>(resource)].get();
+}
+
+HistoryData* ResourceMonitor::getPressureAvg60History(PressureResource resource) const {
+    return m_pressureAvg60History[static_cast<std::size_t>(resource)].get();
+}
+
+bool ResourceMonitor::readCPUStats(CPUStats& stats, CPUStatsSet& cores) {
+    ScopedProbe probe(Probe::CPUStats);
+    
+    if (!m_statFile.isOpen() && !m_statFile.open((m_root + "/proc/stat").c_str())) {
+        std::cerr << "Failed to open /proc/stat" << std::endl;
+        return false;
+    }
+    if (!m_statFile.read()) {
+        std::cerr << "Failed to read /proc/stat" << std::endl;
+        return false;
     }
     
-    // Check memory usage threshold
-    if (m_memInfo.percent >= m_settings->getMemoryThreshold()) {
-        message = "Высокое использование памяти: " + std::to_string(static_cast<int>(m_memInfo.percent)) + "%";
-        resourceType = ResourceType::Memory;
-        return true;
+    // The aggregate "cpu " line comes first
+    const char* p = m_statFile.data();
+    const char* end = m_statFile.end();
+    if (!ProcParse::startsWith(p, end, "cpu ", 4)) {
+        std::cerr << "CPU stats not found in /proc/stat" << std::endl;
+        return false;
     }
+    p += 4;
     
-    // Check disk usage thresholds
-    for (const auto& disk : m_diskInfo) {
-        if (disk.percent >= m_settings->getDiskThreshold()) {
-            message = "Высокое использование диска " + disk.mountpoint + ": " +
-                      std::to_string(static_cast<int>(disk.percent)) + "%";
-            resourceType = ResourceType::Disk;
-            return true;
+    p = ProcParse::parseUnsigned(p, end, stats.user);
+    p = ProcParse::parseUnsigned(p, end, stats.nice);
+    p = ProcParse::parseUnsigned(p, end, stats.system);
+    p = ProcParse::parseUnsigned(p, end, stats.idle);
+    p = ProcParse::parseUnsigned(p, end, stats.iowait);
+    p = ProcParse::parseUnsigned(p, end, stats.irq);
+    p = ProcParse::parseUnsigned(p, end, stats.softirq);
+    p = ProcParse::parseUnsigned(p, end, stats.steal);
+    p = ProcParse::parseUnsigned(p, end, stats.guest);
+    p = ProcParse::parseUnsigned(p, end, stats.guest_nice);
+    p = ProcParse::nextLine(p, end);
+    
+    // Then one "cpuN ..." line per online core, in the same pass.
+    // Offline cores have no line and keep the counters already in `cores`.
+    while (p < end && ProcParse::startsWith(p, end, "cpu", 3) && p + 3 < end && p[3] >= '0' && p[3] <= '9') {
+        unsigned long long core;
+        p = ProcParse::parseUnsigned(p + 3, end, core);
+        if (core >= cores.size()) {
+            // Only happens on the first read or after a CPU hotplug
+            cores.resize(core + 1);
         }
+        
+        p = ProcParse::parseUnsigned(p, end, cores.user[core]);
+        p = ProcParse::parseUnsigned(p, end, cores.nice[core]);
+        p = ProcParse::parseUnsigned(p, end, cores.system[core]);
+        p = ProcParse::parseUnsigned(p, end, cores.idle[core]);
+        p = ProcParse::parseUnsigned(p, end, cores.iowait[core]);
+        p = ProcParse::parseUnsigned(p, end, cores.irq[core]);
+        p = ProcParse::parseUnsigned(p, end, cores.softirq[core]);
+        p = ProcParse::parseUnsigned(p, end, cores.steal[core]);
+        p = ProcParse::nextLine(p, end);
     }
-    
-    resourceType = ResourceType::Other;
-    return false;
+    return true;
 }
 
-bool ResourceMonitor::readCPUStats(CPUStats& stats) {
-    std::ifstream file("/proc/stat");
-    if (!file.is_open()) {
-        std::cerr << "Failed to open /proc/stat" << std::endl;
-        return false;
-    }
+void ResourceMonitor::computeCoreUsage() {
+    const CPUStatsSet& cur = m_coreStats;
+    const CPUStatsSet& prev = m_prevCoreStats;
+    std::size_t count = cur.size();
     
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.substr(0, 3) == "cpu" && line[3] == ' ') {
-            std::istringstream iss(line.substr(5)); // Skip "cpu" prefix
-            iss >> stats.user >> stats.nice >> stats.system >> stats.idle
-                >> stats.iowait >> stats.irq >> stats.softirq >> stats.steal
-                >> stats.guest >> stats.guest_nice;
-            return true;
-        }
+    // A hotplugged core has no previous counters, start over from this sample
+    if (prev.size() != count) {
+        m_prevCoreStats = m_coreStats;
+        m_coreUsage.assign(count, 0.0);
+        return;
     }
     
-    std::cerr << "CPU stats not found in /proc/stat" << std::endl;
-    return false;
+    // Straight-line arithmetic over parallel arrays, no branches, so the
+    // compiler can vectorize it. Per-core iowait may go backwards, clamp at 0.
+    double* usage = m_coreUsage.data();
+    for (std::size_t i = 0; i < count; i++) {
+        double idle = std::max(0.0, static_cast<double>(static_cast<long long>(cur.idle[i] - prev.idle[i])))
+                    + std::max(0.0, static_cast<double>(static_cast<long long>(cur.iowait[i] - prev.iowait[i])));
+        double busy = std::max(0.0, static_cast<double>(static_cast<long long>(cur.user[i] - prev.user[i])))
+                    + std::max(0.0, static_cast<double>(static_cast<long long>(cur.nice[i] - prev.nice[i])))
+                    + std::max(0.0, static_cast<double>(static_cast<long long>(cur.system[i] - prev.system[i])))
+                    + std::max(0.0, static_cast<double>(static_cast<long long>(cur.irq[i] - prev.irq[i])))
+                    + std::max(0.0, static_cast<double>(static_cast<long long>(cur.softirq[i] - prev.softirq[i])))
+                    + std::max(0.0, static_cast<double>(static_cast<long long>(cur.steal[i] - prev.steal[i])));
+        usage[i] = 100.0 * busy / std::max(busy + idle, 1.0);
+    }
 }
 
 bool ResourceMonitor::readMemoryInfo() {
-    std::ifstream file("/proc/meminfo");
-    if (!file.is_open()) {
+    ScopedProbe probe(Probe::MemoryInfo);
+    
+    if (!m_meminfoFile.isOpen() && !m_meminfoFile.open((m_root + "/proc/meminfo").c_str())) {
         std::cerr << "Failed to open /proc/meminfo" << std::endl;
         return false;
     }
+    if (!m_meminfoFile.read()) {
+        std::cerr << "Failed to read /proc/meminfo" << std::endl;
+        return false;
+    }
     
-    std::string line;
     unsigned long long memTotal = 0;
     unsigned long long memFree = 0;
     unsigned long long memAvailable = 0;
     unsigned long long buffers = 0;
     unsigned long long cached = 0;
     
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string key;
-        unsigned long long value;
-        std::string unit;
-        
-        iss >> key >> value >> unit;
+    // Lines look like "MemTotal:       16318480 kB"
+    const char* p = m_meminfoFile.data();
+    const char* end = m_meminfoFile.end();
+    int found = 0;
+    while (p < end && found < 5) {
+        unsigned long long* target = nullptr;
+        const char* value = p;
+        if (ProcParse::startsWith(p, end, "MemTotal:", 9)) {
+            target = &memTotal;
+            value += 9;
+        } else if (ProcParse::startsWith(p, end, "MemFree:", 8)) {
+            target = &memFree;
+            value += 8;
+        } else if (ProcParse::startsWith(p, end, "MemAvailable:", 13)) {
+            target = &memAvailable;
+            value += 13;
+        } else if (ProcParse::startsWith(p, end, "Buffers:", 8)) {
+            target = &buffers;
+            value += 8;
+        } else if (ProcParse::startsWith(p, end, "Cached:", 7)) {
+            target = &cached;
+            value += 7;
+        }
         
-        if (key == "MemTotal:") {
-            memTotal = value;
-        } else if (key == "MemFree:") {
-            memFree = value;
-        } else if (key == "MemAvailable:") {
-            memAvailable = value;
-        } else if (key == "Buffers:") {
-            buffers = value;
-        } else if (key == "Cached:") {
-            cached = value;
+        if (target) {
+            ProcParse::parseUnsigned(value, end, *target);
+            found++;
         }
+        p = ProcParse::nextLine(p, end);
     }
     
     if (memTotal == 0) {
@@ -240,55 +685,39 @@ bool ResourceMonitor::readMemoryInfo() {
 }
 
 bool ResourceMonitor::readDiskInfo() {
-    FILE* mtab = setmntent("/etc/mtab", "r");
-    if (!mtab) {
-        std::cerr << "Failed to open /etc/mtab" << std::endl;
+    ScopedProbe probe(Probe::DiskInfo);
+    
+    // Reparse the mount table only when the kernel reports a change
+    bool mountsChanged = m_mountTable.changed();
+    if (mountsChanged && !m_mountTable.refresh((m_root + "/etc/mtab").c_str())) {
         return false;
     }
     
+    // Capacity is polled on its own, slower cadence
+    auto now = MonitorClock::now();
+    auto sinceCapacityPoll = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now - m_lastCapacityPoll).count();
+    if (!mountsChanged && m_capacityPolled &&
+        sinceCapacityPoll < m_diskPollInterval.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    m_lastCapacityPoll = now;
+    m_capacityPolled = true;
+    
+    if (!m_root.empty()) {
+        readCapacityTable();
+    }
+    
     m_diskInfo.clear();
     
-    struct mntent* entry;
-    while ((entry = getmntent(mtab)) != nullptr) {
-        // Skip non-physical filesystems
-        std::string fstype(entry->mnt_type);
-        std::string mountPoint(entry->mnt_dir);
-        
-        // Система фильтрации файловых систем
-        // 1. Пропускаем все стандартные виртуальные ФС
-        if (fstype == "proc" || fstype == "sysfs" || fstype == "devpts" || 
-            fstype == "tmpfs" || fstype == "cgroup" || fstype == "pstore" ||
-            fstype == "securityfs" || fstype == "devtmpfs" || fstype == "debugfs" ||
-            fstype == "hugetlbfs" || fstype == "mqueue" || fstype == "fusectl" ||
-            fstype.find("fuse") != std::string::npos) {
-            continue;
-        }
-        
-        // 2. Пропускаем специфические системные разделы, которые могут вызвать лишние оповещения
-        std::string device(entry->mnt_fsname);
-        
-        if (mountPoint.find("/etc/nixmodules") != std::string::npos ||
-            mountPoint.find("/mnt/nixmodules") != std::string::npos ||
-            mountPoint.find("/nix/store") != std::string::npos ||
-            mountPoint.find("/nix") != std::string::npos ||
-            mountPoint.find("/run/user") != std::string::npos ||
-            device.find("tmpfs") != std::string::npos ||
-            device.find("overlay") != std::string::npos) {
-            continue;
-        }
-        
+    for (const MountEntry& mount : m_mountTable.entries()) {
         // 3. Добавляем только разделы размером более 100 МБ
-        struct statvfs stat;
-        if (statvfs(entry->mnt_dir, &stat) != 0) {
+        DiskInfo info = {};
+        if (!readCapacity(mount, info)) {
             continue;
         }
-        
-        DiskInfo info;
-        info.device = entry->mnt_fsname;
-        info.mountpoint = entry->mnt_dir;
-        info.total = stat.f_blocks * stat.f_frsize;
-        info.available = stat.f_bavail * stat.f_frsize;
-        info.used = (stat.f_blocks - stat.f_bfree) * stat.f_frsize;
+        info.device = mount.device;
+        info.mountpoint = mount.mountpoint;
         
         // Исключаем слишком маленькие разделы и разделы с 0 размером
         const unsigned long long MIN_SIZE = 100 * 1024 * 1024; // 100 MB
@@ -296,16 +725,251 @@ bool ResourceMonitor::readDiskInfo() {
             info.percent = 100.0 * info.used / info.total;
             m_diskInfo.push_back(info);
             
-            // Проверяем, есть ли история для этого раздела
-            auto it = m_diskHistory.find(info.mountpoint);
-            if (it == m_diskHistory.end()) {
-                // Создаем новую историю для этого раздела
+            // Проверяем, есть ли история для этого раздела. Добавляет их
+            // только этот поток, так что между проверкой и вставкой никто
+            // другой её не создаст.
+            bool known;
+            {
+                std::lock_guard<std::mutex> lock(m_diskHistoryMutex);
+                known = m_diskHistory.find(info.mountpoint) != m_diskHistory.end();
+            }
+            if (!known) {
+                // Создаем новую историю для этого раздела. Файл открывается
+                // и проигрывается без блокировки: графики в это время читают
+                // остальные истории.
                 std::size_t historySize = 600; // 10 минут с 1-секундным интервалом
-                m_diskHistory[info.mountpoint] = std::make_unique<HistoryData>(historySize);
+                double interval = m_settings->getSampleInterval() / 1000.0;
+                DiskHistory history;
+                history.usage = std::make_shared<RollupHistory>(historySize, interval);
+                history.store = openStore(diskStoreName(info.mountpoint), history.usage.get());
+                history.lastSeen = MonitorClock::wallMillis();
+                std::lock_guard<std::mutex> lock(m_diskHistoryMutex);
+                m_diskHistory[info.mountpoint] = std::move(history);
+            }
+            
+            std::lock_guard<std::mutex> lock(m_diskHistoryMutex);
+            // Скорость чтения и записи: только последние 10 минут, без
+            // уровней и без файла на диске
+            if (m_diskIOHistory.find(info.mountpoint) == m_diskIOHistory.end()) {
+                std::size_t historySize = 600;
+                DiskIOHistory io;
+                io.read = std::make_shared<HistoryData>(historySize);
+                io.write = std::make_shared<HistoryData>(historySize);
+                io.lastSeen = MonitorClock::wallMillis();
+                m_diskIOHistory[info.mountpoint] = std::move(io);
             }
         }
     }
     
-    endmntent(mtab);
+    // Track the devices of the mounts now shown
+    std::vector<dev_t> devices;
+    for (const auto& disk : m_diskInfo) {
+        devices.push_back(disk.deviceNumber);
+    }
+    m_diskIOCollector.setDevices(devices);
+    
     return true;
 }
+
+bool ResourceMonitor::readCapacity(const MountEntry& mount, DiskInfo& info) {
+    if (!m_root.empty()) {
+        auto it = m_capacityTable.find(mount.mountpoint);
+        if (it == m_capacityTable.end()) {
+            return false;
+        }
+        info.total = it->second.total;
+        info.used = it->second.used;
+        info.available = it->second.available;
+        info.deviceNumber = it->second.deviceNumber;
+        return true;
+    }
+    
+    struct statvfs stat;
+    if (statvfs(mount.mountpoint.c_str(), &stat) != 0) {
+        return false;
+    }
+    info.total = stat.f_blocks * stat.f_frsize;
+    info.available = stat.f_bavail * stat.f_frsize;
+    info.used = (stat.f_blocks - stat.f_bfree) * stat.f_frsize;
+    
+    // The block device behind the mount: the device node itself, or
+    // the device of the mounted filesystem when there is no node
+    struct stat deviceStat;
+    if (::stat(mount.device.c_str(), &deviceStat) == 0 && S_ISBLK(deviceStat.st_mode)) {
+        info.deviceNumber = deviceStat.st_rdev;
+    } else if (::stat(mount.mountpoint.c_str(), &deviceStat) == 0) {
+        info.deviceNumber = deviceStat.st_dev;
+    }
+    return true;
+}
+
+void ResourceMonitor::readCapacityTable() {
+    // statvfs() cannot be pointed at a root, so a recorded tree carries the
+    // results as lines of "total used available major minor mountpoint"
+    m_capacityTable.clear();
+    FILE* file = std::fopen((m_root + "/statvfs").c_str(), "r");
+    if (!file) {
+        return;
+    }
+    
+    char line[4096];
+    while (std::fgets(line, sizeof(line), file)) {
+        unsigned long long total;
+        unsigned long long used;
+        unsigned long long available;
+        unsigned int major;
+        unsigned int minor;
+        int offset = 0;
+        if (std::sscanf(line, "%llu %llu %llu %u %u %n", &total, &used, &available, &major, &minor, &offset) < 5 ||
+            offset == 0) {
+            continue;
+        }
+        std::string mountpoint(line + offset);
+        if (!mountpoint.empty() && mountpoint.back() == '\n') {
+            mountpoint.pop_back();
+        }
+        
+        DiskInfo& info = m_capacityTable[mountpoint];
+        info.total = total;
+        info.used = used;
+        info.available = available;
+        info.deviceNumber = makedev(major, minor);
+    }
+    std::fclose(file);
+}
+
+void ResourceMonitor::readDiskIO(std::int64_t timestamp) {
+    ScopedProbe probe(Probe::DiskIO);
+    
+    if (!m_diskIOCollector.isOpen() || !m_diskIOCollector.update()) {
+        return;
+    }
+    
+    for (auto& disk : m_diskInfo) {
+        const DiskIOInfo* io = m_diskIOCollector.find(disk.deviceNumber);
+        disk.readOpsPerSec = io ? io->readOpsPerSec : 0.0;
+        disk.writeOpsPerSec = io ? io->writeOpsPerSec : 0.0;
+        disk.readBytesPerSec = io ? io->readBytesPerSec : 0.0;
+        disk.writeBytesPerSec = io ? io->writeBytesPerSec : 0.0;
+        disk.awaitMs = io ? io->awaitMs : 0.0;
+        disk.ioUtilization = io ? io->utilization : 0.0;
+        
+        DiskIOHistory* history;
+        {
+            std::lock_guard<std::mutex> lock(m_diskHistoryMutex);
+            auto it = m_diskIOHistory.find(disk.mountpoint);
+            if (it == m_diskIOHistory.end()) {
+                continue;
+            }
+            history = &it->second;
+        }
+        history->read->addSample(disk.readBytesPerSec);
+        history->write->addSample(disk.writeBytesPerSec);
+        history->lastSeen = timestamp;
+    }
+    
+    // Free the histories of disks unmounted a while ago. Graphs and alert
+    // rules hold their own references.
+    std::lock_guard<std::mutex> lock(m_diskHistoryMutex);
+    if (m_diskIOHistory.size() > m_diskInfo.size()) {
+        for (auto it = m_diskIOHistory.begin(); it != m_diskIOHistory.end();) {
+            if (timestamp - it->second.lastSeen > kSeriesExpiryMs) {
+                it = m_diskIOHistory.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void ResourceMonitor::expireDiskHistories(std::int64_t timestamp) {
+    // Free the usage of disks unmounted a while ago and delete their files,
+    // so mounts that come and go do not pile up. Graphs and alert rules
+    // hold their own references. The files are deleted and closed after
+    // the lock is released.
+    std::vector<std::pair<std::string, DiskHistory>> expired;
+    {
+        std::lock_guard<std::mutex> lock(m_diskHistoryMutex);
+        if (m_diskHistory.size() <= m_diskInfo.size()) {
+            return;
+        }
+        for (auto it = m_diskHistory.begin(); it != m_diskHistory.end();) {
+            if (timestamp - it->second.lastSeen > kSeriesExpiryMs) {
+                expired.emplace_back(it->first, std::move(it->second));
+                it = m_diskHistory.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    
+    // Deleted while still locked against other writers
+    for (auto& disk : expired) {
+        std::string name = m_storeDirectory + "/" + diskStoreName(disk.first);
+        if (disk.second.store.samples) {
+            unlink((name + ".series").c_str());
+        }
+        if (disk.second.store.buckets) {
+            unlink((name + kBucketSuffix + ".series").c_str());
+        }
+    }
+}
+
+void ResourceMonitor::readPressure() {
+    ScopedProbe probe(Probe::Pressure);
+    
+    if (!m_pressureCollector.isOpen() || !m_pressureCollector.update()) {
+        return;
+    }
+    
+    for (std::size_t i = 0; i < kPressureResourceCount; i++) {
+        const PressureInfo& info = m_pressureCollector.get(static_cast<PressureResource>(i));
+        m_pressureAvg10History[i]->addSample(info.someAvg10);
+        m_pressureAvg60History[i]->addSample(info.someAvg60);
+    }
+}
+
+void ResourceMonitor::readNetworkInfo(std::int64_t timestamp) {
+    ScopedProbe probe(Probe::Network);
+    
+    if (!m_networkCollector.isOpen() || !m_networkCollector.update()) {
+        return;
+    }
+    
+    for (const NetworkInfo& info : m_networkCollector.interfaces()) {
+        // Only the lookup is guarded; the histories are written outside the
+        // lock like the other series
+        NetworkHistory* entry;
+        {
+            std::lock_guard<std::mutex> lock(m_networkHistoryMutex);
+            auto it = m_networkHistory.find(info.name);
+            if (it == m_networkHistory.end()) {
+                std::size_t historySize = 600;
+                NetworkHistory history;
+                history.rx = std::make_shared<HistoryData>(historySize);
+                history.tx = std::make_shared<HistoryData>(historySize);
+                history.lastSeen = timestamp;
+                it = m_networkHistory.emplace(info.name, std::move(history)).first;
+            }
+            entry = &it->second;
+        }
+        
+        entry->rx->addSample(info.rxBytesPerSec);
+        entry->tx->addSample(info.txBytesPerSec);
+        entry->lastSeen = timestamp;
+    }
+    
+    // Container hosts create and remove interfaces all the time. Free the
+    // histories of those gone a while; graphs and alert rules hold their own
+    // references.
+    std::lock_guard<std::mutex> lock(m_networkHistoryMutex);
+    if (m_networkHistory.size() > m_networkCollector.interfaces().size()) {
+        for (auto it = m_networkHistory.begin(); it != m_networkHistory.end();) {
+            if (timestamp - it->second.lastSeen > kSeriesExpiryMs) {
+                it = m_networkHistory.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
@@ -5,10 +5,21 @@
 #include <vector>
 #include <memory>
 #include <chrono>
+#include <cstdint>
 #include <map>
+#include <mutex>
+#include <atomic>
 #include "history_data.h"
+#include "rollup_history.h"
+#include "series_store.h"
 #include "settings.h"
-#include "notification_manager.h"
+#include "proc_reader.h"
+#include "mount_table.h"
+#include "process_collector.h"
+#include "network_collector.h"
+#include "disk_io_collector.h"
+#include "pressure_collector.h"
+#include "cgroup_collector.h"
 
 struct CPUStats {
     unsigned long long user;
@@ -26,6 +37,22 @@ struct CPUStats {
     unsigned long long total() const;
 };
 
+// Per-core CPU time counters from the cpuN lines of /proc/stat, stored as a
+// structure of arrays so the per-core deltas run as one vectorizable loop
+struct CPUStatsSet {
+    std::vector<unsigned long long> user;
+    std::vector<unsigned long long> nice;
+    std::vector<unsigned long long> system;
+    std::vector<unsigned long long> idle;
+    std::vector<unsigned long long> iowait;
+    std::vector<unsigned long long> irq;
+    std::vector<unsigned long long> softirq;
+    std::vector<unsigned long long> steal;
+    
+    void resize(std::size_t count);
+    std::size_t size() const;
+};
+
 struct MemoryInfo {
     unsigned long long total;
     unsigned long long free;
@@ -43,52 +70,211 @@ struct DiskInfo {
     unsigned long long used;
     unsigned long long available;
     double percent;
+    
+    // I/O of the underlying block device, updated every sample
+    dev_t deviceNumber;         // 0 if the mount has no block device
+    double readOpsPerSec;
+    double writeOpsPerSec;
+    double readBytesPerSec;
+    double writeBytesPerSec;
+    double awaitMs;
+    double ioUtilization;       // Percent of the time the device was busy
+};
+
+// Everything the UI needs from one sample, published by the Sampler thread
+struct ResourceSnapshot {
+    std::uint64_t sequence = 0;
+    std::int64_t timestamp = 0;             // Wall-clock milliseconds of the sample
+    double cpuUsage = 0.0;
+    std::vector<double> coreUsage;
+    MemoryInfo memInfo = {};
+    std::vector<DiskInfo> diskInfo;
+    std::vector<ProcessInfo> topProcesses;  // Busiest processes first
+    std::vector<NetworkInfo> networkInfo;
+    PressureInfo pressure[kPressureResourceCount] = {};    // Indexed by PressureResource
+    std::vector<CgroupInfo> topCgroups;     // Busiest leaf cgroups first
 };
 
 class ResourceMonitor {
 public:
-    ResourceMonitor(Settings* settings);
+    // Files are read below `root` when one is given, e.g. <root>/proc/stat;
+    // a recorded or copied tree instead of the running system. Mount
+    // capacities then come from <root>/statvfs (see trace.h), and histories
+    // of a foreign root are not persisted.
+    ResourceMonitor(Settings* settings, const std::string& root = std::string());
     ~ResourceMonitor();
     
     bool initialize();
     
-    // Update all resources
+    // Update all resources, at most once per second
     void update();
     
+    // Take one sample of all resources unconditionally
+    void sample();
+    
+    // Copy the current values into a snapshot, reusing its storage
+    void fillSnapshot(ResourceSnapshot& snapshot) const;
+    
+    // Set how often disk capacity is polled with statvfs(), in seconds.
+    // Mount/unmount events are picked up on the next update regardless.
+    void setDiskPollInterval(int seconds);
+    
     // Get current CPU usage percentage
     double getCPUUsage() const;
     
+    // Get current per-core CPU usage percentages, indexed by cpuN number
+    const std::vector<double>& getCoreUsage() const;
+    
     // Get current memory usage
     const MemoryInfo& getMemoryInfo() const;
     
     // Get current disk usage
     const std::vector<DiskInfo>& getDiskInfo() const;
     
+    // Get the busiest processes of the last sample, busiest first
+    const std::vector<ProcessInfo>& getTopProcesses() const;
+    
+    // Get current network interface rates
+    const std::vector<NetworkInfo>& getNetworkInfo() const;
+    
+    // Get the busiest leaf cgroups of the last sample, busiest first
+    const std::vector<CgroupInfo>& getTopCgroups() const;
+    
+    // Copy every cgroup with a sample into `out` and its full path into
+    // `paths`, reusing their storage. Safe from any thread.
+    void getCgroups(std::vector<CgroupInfo>& out, std::vector<std::string>& paths) const;
+    
+    // Get current pressure stall averages; all zero without PSI
+    const PressureInfo& getPressureInfo(PressureResource resource) const;
+    
     // Get history data
-    HistoryData* getCPUHistory() const;
-    HistoryData* getMemoryHistory() const;
-    HistoryData* getDiskHistory(const std::string& mountpoint) const;
+    RollupHistory* getCPUHistory() const;
+    RollupHistory* getMemoryHistory() const;
+    std::size_t getCoreCount() const;
+    HistoryData* getCoreHistory(std::size_t core) const;
+    
+    // Disk usage, nullptr if unknown. Freed, with its history file, a while
+    // after the last sample like the histories below.
+    std::shared_ptr<RollupHistory> getDiskHistory(const std::string& mountpoint) const;
     
-    // Check if any resource exceeds threshold
-    bool checkThresholds(std::string& message, ResourceType& resourceType);
+    // Byte rates of the last 10 minutes, nullptr if unknown. Disks and
+    // interfaces come and go, so a history is freed a while after its last
+    // sample; hold on to the pointer for as long as it is shown.
+    std::shared_ptr<HistoryData> getDiskReadHistory(const std::string& mountpoint) const;
+    std::shared_ptr<HistoryData> getDiskWriteHistory(const std::string& mountpoint) const;
+    std::shared_ptr<HistoryData> getNetworkRxHistory(const std::string& interface) const;
+    std::shared_ptr<HistoryData> getNetworkTxHistory(const std::string& interface) const;
+    
+    // "some" pressure averaged over 10 and 60 s, last 10 minutes; nullptr without PSI
+    HistoryData* getPressureAvg10History(PressureResource resource) const;
+    HistoryData* getPressureAvg60History(PressureResource resource) const;
+    
+    // CPU% history of a cgroup by full path or CgroupInfo::id, nullptr if
+    // unknown. Safe from any thread.
+    std::shared_ptr<HistoryData> getCgroupCPUHistory(const std::string& path) const;
+    std::shared_ptr<HistoryData> getCgroupCPUHistory(std::uint64_t id) const;
     
 private:
     Settings* m_settings;
+    std::string m_root;
     
     CPUStats m_prevCPUStats;
     double m_cpuUsage;
+    CPUStatsSet m_coreStats;
+    CPUStatsSet m_prevCoreStats;
+    std::vector<double> m_coreUsage;
     MemoryInfo m_memInfo;
     std::vector<DiskInfo> m_diskInfo;
     
-    std::unique_ptr<HistoryData> m_cpuHistory;
-    std::unique_ptr<HistoryData> m_memHistory;
-    std::map<std::string, std::unique_ptr<HistoryData>> m_diskHistory;
+    std::unique_ptr<RollupHistory> m_cpuHistory;
+    std::unique_ptr<RollupHistory> m_memHistory;
+    std::vector<std::unique_ptr<HistoryData>> m_coreHistory;  // Fixed after initialize()
+    
+    // On-disk copy of a history: raw samples for the last day, and the
+    // buckets of the coarsest tier, which reach further back. Written by
+    // the sampling thread only; nullptr where persistence is unavailable.
+    struct SeriesFiles {
+        std::unique_ptr<SeriesStore> samples;
+        std::unique_ptr<SeriesStore> buckets;
+    };
+    
+    // Usage of one mount and its on-disk copy
+    struct DiskHistory {
+        std::shared_ptr<RollupHistory> usage;
+        SeriesFiles store;
+        std::int64_t lastSeen;              // Wall clock of the last sample, ms
+    };
+    std::map<std::string, DiskHistory> m_diskHistory;
+    
+    // Read and written bytes per second of the device behind a mount
+    struct DiskIOHistory {
+        std::shared_ptr<HistoryData> read;
+        std::shared_ptr<HistoryData> write;
+        std::int64_t lastSeen;              // Wall clock of the last sample, ms
+    };
+    std::map<std::string, DiskIOHistory> m_diskIOHistory;
+    mutable std::mutex m_diskHistoryMutex;  // Guards the maps, not the histories
+    
+    // On-disk copies of the histories
+    std::string m_storeDirectory;           // Empty when persistence is unavailable
+    SeriesFiles m_cpuStore;
+    SeriesFiles m_memStore;
+    std::uint64_t m_sampleCount;
+    std::int64_t m_sampleTimestamp;
+    
+    ProcessCollector m_processCollector;
+    std::vector<ProcessInfo> m_topProcesses;
+    
+    // Received and transmitted bytes per second of one interface
+    struct NetworkHistory {
+        std::shared_ptr<HistoryData> rx;
+        std::shared_ptr<HistoryData> tx;
+        std::int64_t lastSeen;              // Wall clock of the last sample, ms
+    };
+    
+    DiskIOCollector m_diskIOCollector;
+    
+    // Fixed after initialize()
+    PressureCollector m_pressureCollector;
+    std::unique_ptr<HistoryData> m_pressureAvg10History[kPressureResourceCount];
+    std::unique_ptr<HistoryData> m_pressureAvg60History[kPressureResourceCount];
+    
+    CgroupCollector m_cgroupCollector;
+    std::vector<CgroupInfo> m_topCgroups;
+    mutable std::mutex m_cgroupMutex;       // Guards the collector between sampling and history lookups
+    
+    NetworkCollector m_networkCollector;
+    std::map<std::string, NetworkHistory> m_networkHistory;
+    mutable std::mutex m_networkHistoryMutex;   // Guards the map, not the histories
+    
+    MountTable m_mountTable;
+    std::map<std::string, DiskInfo> m_capacityTable;    // From <root>/statvfs, by mountpoint
+    std::atomic<int> m_diskPollInterval;    // Milliseconds, set from the UI thread
+    bool m_capacityPolled;
+    std::chrono::time_point<std::chrono::steady_clock> m_lastCapacityPoll;
     
     std::chrono::time_point<std::chrono::steady_clock> m_lastUpdate;
     
-    bool readCPUStats(CPUStats& stats);
+    // /proc files kept open between samples
+    ProcFile m_statFile;
+    ProcFile m_meminfoFile;
+    
+    bool readCPUStats(CPUStats& stats, CPUStatsSet& cores);
+    void computeCoreUsage();
     bool readMemoryInfo();
     bool readDiskInfo();
+    bool readCapacity(const MountEntry& mount, DiskInfo& info);
+    void readCapacityTable();
+    void readDiskIO(std::int64_t timestamp);
+    void expireDiskHistories(std::int64_t timestamp);
+    void readPressure();
+    void readNetworkInfo(std::int64_t timestamp);
+    
+    // Map the stores for a series and load what they hold into the history
+    SeriesFiles openStore(const std::string& name, RollupHistory* history);
+    
+    // Add a sample to a history and its stores
+    static void recordSample(RollupHistory* history, SeriesFiles& store, double value, std::int64_t timestamp);
 };
 
 #endif // RESOURCE_MONITOR_H
@@ -0,0 +1,12 @@
+#ifndef RESOURCE_TYPE_H
+#define RESOURCE_TYPE_H
+
+// Типы ресурсов для группировки уведомлений
+enum class ResourceType {
+    CPU,
+    Memory,
+    Disk,
+    Other
+};
+
+#endif // RESOURCE_TYPE_H
@@ -0,0 +1,197 @@
+#include "rollup_history.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Archived values are rounded to 1/1024, far below a pixel on any graph
+static const double kArchiveQuantum = 1.0 / 1024.0;
+
+RollupHistory::RollupHistory(std::size_t rawCapacity, double sampleIntervalSeconds,
+                             const std::vector<TierSpec>& tiers, std::size_t archiveCapacity)
+    : m_raw(std::make_unique<HistoryData>(rawCapacity)),
+      m_archive(archiveCapacity, 512, kArchiveQuantum),
+      m_sampleInterval(sampleIntervalSeconds)
+{
+    for (const TierSpec& spec : tiers) {
+        Tier tier;
+        tier.samplesPerBucket = std::max<std::size_t>(1, spec.samplesPerBucket);
+        tier.minimum = std::make_unique<HistoryData>(spec.capacity);
+        tier.maximum = std::make_unique<HistoryData>(spec.capacity);
+        tier.average = std::make_unique<HistoryData>(spec.capacity);
+        tier.last = std::make_unique<HistoryData>(spec.capacity);
+        tier.pending = 0;
+        tier.valid = 0;
+        tier.sum = 0.0;
+        tier.min = 0.0;
+        tier.max = 0.0;
+        tier.lastValue = 0.0;
+        m_tiers.push_back(std::move(tier));
+    }
+}
+
+RollupHistory::~RollupHistory() {
+    // Default destructor
+}
+
+std::vector<RollupHistory::TierSpec> RollupHistory::defaultTiers() {
+    return {
+        {10, 2160},     // 10 s buckets, 6 hours
+        {60, 1440},     // 1 min buckets, 24 hours
+        {900, 672},     // 15 min buckets, 7 days
+    };
+}
+
+bool RollupHistory::addSample(double value, std::int64_t timestamp) {
+    m_raw->addSample(value);
+    m_archive.addSample(timestamp, value);
+
+    // Every tier accumulates raw samples directly, so buckets are exact
+    bool gap = std::isnan(value);
+    for (Tier& tier : m_tiers) {
+        if (!gap) {
+            if (tier.valid == 0) {
+                tier.sum = 0.0;
+                tier.min = value;
+                tier.max = value;
+            }
+            tier.sum += value;
+            tier.min = std::min(tier.min, value);
+            tier.max = std::max(tier.max, value);
+            tier.lastValue = value;
+            tier.valid++;
+        }
+        if (++tier.pending == tier.samplesPerBucket) {
+            closeBucket(tier);
+        }
+    }
+
+    // Nothing is pending right after a bucket closed
+    return !m_tiers.empty() && m_tiers.back().pending == 0;
+}
+
+void RollupHistory::addBucket(double value) {
+    if (m_tiers.empty()) {
+        return;
+    }
+    Tier& tier = m_tiers.back();
+    tier.minimum->addSample(value);
+    tier.maximum->addSample(value);
+    tier.average->addSample(value);
+    tier.last->addSample(value);
+}
+
+void RollupHistory::addGap(std::size_t samples, std::int64_t timestamp) {
+    // More gap samples than a series holds would only push out other gap
+    // samples, so every series gets at most its capacity
+    const double gap = std::numeric_limits<double>::quiet_NaN();
+    std::size_t raw = std::min(samples, m_raw->getCapacity());
+    for (std::size_t i = 0; i < raw; i++) {
+        m_raw->addSample(gap);
+    }
+    std::size_t archived = std::min(samples, m_archive.getCapacity());
+    std::int64_t step = std::llround(m_sampleInterval * 1000.0);
+    for (std::size_t i = 0; i < archived; i++) {
+        m_archive.addSample(timestamp - static_cast<std::int64_t>(archived - 1 - i) * step, gap);
+    }
+
+    for (Tier& tier : m_tiers) {
+        // Finish the open bucket, then whole empty buckets, then start the next one
+        std::size_t fill = std::min(samples, tier.samplesPerBucket - tier.pending);
+        tier.pending += fill;
+        if (tier.pending < tier.samplesPerBucket) {
+            continue;
+        }
+        closeBucket(tier);
+        std::size_t remaining = samples - fill;
+        std::size_t buckets = std::min(remaining / tier.samplesPerBucket, tier.average->getCapacity());
+        for (std::size_t i = 0; i < buckets; i++) {
+            closeBucket(tier);
+        }
+        tier.pending = remaining % tier.samplesPerBucket;
+    }
+}
+
+void RollupHistory::closeBucket(Tier& tier) {
+    if (tier.valid == 0) {
+        const double gap = std::numeric_limits<double>::quiet_NaN();
+        tier.minimum->addSample(gap);
+        tier.maximum->addSample(gap);
+        tier.average->addSample(gap);
+        tier.last->addSample(gap);
+    } else {
+        tier.minimum->addSample(tier.min);
+        tier.maximum->addSample(tier.max);
+        tier.average->addSample(tier.sum / tier.valid);
+        tier.last->addSample(tier.lastValue);
+    }
+    tier.pending = 0;
+    tier.valid = 0;
+}
+
+HistoryData* RollupHistory::raw() const {
+    return m_raw.get();
+}
+
+const CompressedHistory* RollupHistory::archive() const {
+    return &m_archive;
+}
+
+double RollupHistory::getArchiveSpan() const {
+    return m_sampleInterval * m_archive.getCapacity();
+}
+
+std::size_t RollupHistory::getTierCount() const {
+    return m_tiers.size() + 1;
+}
+
+double RollupHistory::getTierResolution(std::size_t tier) const {
+    if (tier == 0 || tier > m_tiers.size()) {
+        return m_sampleInterval;
+    }
+    return m_sampleInterval * m_tiers[tier - 1].samplesPerBucket;
+}
+
+double RollupHistory::getTierSpan(std::size_t tier) const {
+    if (tier == 0 || tier > m_tiers.size()) {
+        return m_sampleInterval * m_raw->getCapacity();
+    }
+    return getTierResolution(tier) * m_tiers[tier - 1].average->getCapacity();
+}
+
+HistoryData* RollupHistory::getTierAverage(std::size_t tier) const {
+    return (tier == 0 || tier > m_tiers.size()) ? m_raw.get() : m_tiers[tier - 1].average.get();
+}
+
+HistoryData* RollupHistory::getTierMinimum(std::size_t tier) const {
+    return (tier == 0 || tier > m_tiers.size()) ? m_raw.get() : m_tiers[tier - 1].minimum.get();
+}
+
+HistoryData* RollupHistory::getTierMaximum(std::size_t tier) const {
+    return (tier == 0 || tier > m_tiers.size()) ? m_raw.get() : m_tiers[tier - 1].maximum.get();
+}
+
+HistoryData* RollupHistory::getTierLast(std::size_t tier) const {
+    return (tier == 0 || tier > m_tiers.size()) ? m_raw.get() : m_tiers[tier - 1].last.get();
+}
+
+std::size_t RollupHistory::selectTier(double visibleSeconds) const {
+    for (std::size_t tier = 0; tier < getTierCount(); tier++) {
+        if (getTierSpan(tier) >= visibleSeconds) {
+            return tier;
+        }
+    }
+    return getTierCount() - 1;
+}
+
+void RollupHistory::clear() {
+    m_raw->clear();
+    m_archive.clear();
+    for (Tier& tier : m_tiers) {
+        tier.minimum->clear();
+        tier.maximum->clear();
+        tier.average->clear();
+        tier.last->clear();
+        tier.pending = 0;
+        tier.valid = 0;
+    }
+}
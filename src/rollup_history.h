@@ -0,0 +1,106 @@
+#ifndef ROLLUP_HISTORY_H
+#define ROLLUP_HISTORY_H
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include "history_data.h"
+#include "compressed_history.h"
+
+// Multi-resolution history: raw samples plus coarser rollup tiers.
+//
+// Tier 0 is the raw series. Every further tier folds a fixed number of raw
+// samples into one bucket and keeps the bucket minimum, maximum, average and
+// last value, each as its own HistoryData so readers get the usual zero-copy
+// snapshots and O(1) statistics. Buckets are accumulated incrementally, so
+// addSample() is O(number of tiers) and memory is bounded by the tier
+// capacities rather than the retention period.
+//
+// Raw samples are also kept for longer in a compressed archive, which costs
+// a fraction of the memory of a HistoryData of the same length but has to be
+// decoded to be read.
+//
+// The default layout at a 1 s sample interval keeps 10 minutes raw, 6 hours
+// raw in the archive, 6 hours at 10 s, 24 hours at 1 minute and 7 days at
+// 15 minutes.
+class RollupHistory {
+public:
+    struct TierSpec {
+        std::size_t samplesPerBucket;
+        std::size_t capacity;
+    };
+
+    RollupHistory(std::size_t rawCapacity, double sampleIntervalSeconds = 1.0,
+                  const std::vector<TierSpec>& tiers = defaultTiers(),
+                  std::size_t archiveCapacity = 21600);
+    ~RollupHistory();
+
+    static std::vector<TierSpec> defaultTiers();
+
+    // Add a raw sample taken at `timestamp` (ms since the epoch) and update
+    // every tier (single writer thread). True when this closed a bucket of
+    // the coarsest tier, which getTierAverage() then ends with.
+    bool addSample(double value, std::int64_t timestamp);
+
+    // Add `samples` missing samples, the last one at `timestamp`. They are
+    // NaN in every series (see HistoryData) and buckets without a single
+    // real sample are NaN as well. Costs at most the tier capacities.
+    void addGap(std::size_t samples, std::int64_t timestamp);
+
+    // Add a closed bucket to the coarsest tier alone, as restored from
+    // disk: its minimum, maximum, average and last are all `value`, and
+    // NaN is a gap. The other tiers are rebuilt from raw samples.
+    void addBucket(double value);
+
+    // The raw series
+    HistoryData* raw() const;
+
+    // Compressed raw samples and the time they cover, in seconds
+    const CompressedHistory* archive() const;
+    double getArchiveSpan() const;
+
+    // Number of tiers including the raw one
+    std::size_t getTierCount() const;
+
+    // Seconds per point and seconds covered by a full tier
+    double getTierResolution(std::size_t tier) const;
+    double getTierSpan(std::size_t tier) const;
+
+    // Bucket series of a tier; for tier 0 they all return the raw series
+    HistoryData* getTierAverage(std::size_t tier) const;
+    HistoryData* getTierMinimum(std::size_t tier) const;
+    HistoryData* getTierMaximum(std::size_t tier) const;
+    HistoryData* getTierLast(std::size_t tier) const;
+
+    // Finest tier that covers the given time range, or the coarsest one
+    std::size_t selectTier(double visibleSeconds) const;
+
+    // Clear every tier
+    void clear();
+
+private:
+    struct Tier {
+        std::size_t samplesPerBucket;
+        std::unique_ptr<HistoryData> minimum;
+        std::unique_ptr<HistoryData> maximum;
+        std::unique_ptr<HistoryData> average;
+        std::unique_ptr<HistoryData> last;
+
+        // Bucket being accumulated; `valid` of its `pending` samples are not gaps
+        std::size_t pending;
+        std::size_t valid;
+        double sum;
+        double min;
+        double max;
+        double lastValue;
+    };
+
+    static void closeBucket(Tier& tier);
+
+    std::unique_ptr<HistoryData> m_raw;
+    CompressedHistory m_archive;
+    std::vector<Tier> m_tiers;              // Rollup tiers only, tier n is m_tiers[n - 1]
+    double m_sampleInterval;
+};
+
+#endif // ROLLUP_HISTORY_H
@@ -0,0 +1,95 @@
+#include "sampler.h"
+#include "diagnostics.h"
+#include <chrono>
+
+Sampler::Sampler(ResourceMonitor* monitor, int intervalMs)
+    : m_monitor(monitor),
+      m_intervalMs(intervalMs > 0 ? intervalMs : 1),
+      m_stopRequested(false)
+{
+    // Publish the state read by ResourceMonitor::initialize() right away,
+    // so the UI has something to show before the first tick
+    m_monitor->fillSnapshot(m_snapshots.writeBuffer());
+    m_snapshots.publish();
+}
+
+Sampler::~Sampler() {
+    stop();
+}
+
+void Sampler::start() {
+    if (m_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stopRequested = false;
+    }
+    m_thread = std::thread(&Sampler::run, this);
+}
+
+void Sampler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stopRequested = true;
+    }
+    m_wakeCondition.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void Sampler::setInterval(int intervalMs) {
+    m_intervalMs.store(intervalMs > 0 ? intervalMs : 1, std::memory_order_relaxed);
+}
+
+void Sampler::setSampleCallback(std::function<void(const ResourceSnapshot&)> callback) {
+    m_sampleCallback = std::move(callback);
+}
+
+void Sampler::setTickCallback(std::function<bool()> callback) {
+    m_tickCallback = std::move(callback);
+}
+
+bool Sampler::poll() {
+    return m_snapshots.update();
+}
+
+const ResourceSnapshot& Sampler::latest() const {
+    return m_snapshots.readBuffer();
+}
+
+void Sampler::run() {
+    auto nextTick = std::chrono::steady_clock::now();
+
+    for (;;) {
+        // Sleep until the next tick on a fixed schedule, so a slow sample
+        // does not push every later sample back
+        nextTick += std::chrono::milliseconds(m_intervalMs.load(std::memory_order_relaxed));
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            if (m_wakeCondition.wait_until(lock, nextTick, [this] { return m_stopRequested; })) {
+                return;
+            }
+        }
+
+        if (m_tickCallback && !m_tickCallback()) {
+            continue;
+        }
+        m_monitor->sample();
+        Diagnostics::updateProcessCPU();
+        m_monitor->fillSnapshot(m_snapshots.writeBuffer());
+        if (m_sampleCallback) {
+            m_sampleCallback(m_snapshots.writeBuffer());
+        }
+        m_snapshots.publish();
+
+        // After a long stall start a fresh schedule instead of bursting
+        auto now = std::chrono::steady_clock::now();
+        if (now > nextTick + std::chrono::milliseconds(m_intervalMs.load(std::memory_order_relaxed))) {
+            nextTick = now;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include "resource_monitor.h"
+#include "triple_buffer.h"
+
+// Runs ResourceMonitor sampling on a dedicated thread and publishes each
+// sample as a ResourceSnapshot through a lock-free triple buffer.
+//
+// The UI thread never touches the monitor's collector state directly: it
+// polls latest() at its own redraw rate, so a slow collector (for example
+// statvfs() on a hung NFS mount) delays samples but never the main loop.
+class Sampler {
+public:
+    Sampler(ResourceMonitor* monitor, int intervalMs);
+    ~Sampler();
+
+    // Start and stop the sampling thread
+    void start();
+    void stop();
+
+    // Change the sampling interval, takes effect after the current wait
+    void setInterval(int intervalMs);
+
+    // Called on the sampling thread with each snapshot before it is
+    // published, e.g. to render exports. Set before start().
+    void setSampleCallback(std::function<void(const ResourceSnapshot&)> callback);
+    
+    // Called on the sampling thread before each sample, e.g. to advance a
+    // trace replay; returning false skips the sample. Set before start().
+    void setTickCallback(std::function<bool()> callback);
+
+    // Consumer side (one thread): fetch the newest snapshot if there is one.
+    // Returns false when nothing new was published since the last call.
+    bool poll();
+
+    // Snapshot picked up by the last successful poll()
+    const ResourceSnapshot& latest() const;
+
+private:
+    ResourceMonitor* m_monitor;
+    std::atomic<int> m_intervalMs;
+
+    std::thread m_thread;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    bool m_stopRequested;
+
+    TripleBuffer<ResourceSnapshot> m_snapshots;
+    std::function<void(const ResourceSnapshot&)> m_sampleCallback;
+    std::function<bool()> m_tickCallback;
+
+    // Thread body
+    void run();
+};
+
+#endif // SAMPLER_H
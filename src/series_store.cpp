@@ -0,0 +1,148 @@
+#include "series_store.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char kSeriesMagic[8] = {'S', 'M', 'S', 'E', 'R', 'I', 'E', 'S'};
+static const std::uint32_t kSeriesVersion = 1;
+
+SeriesStore::SeriesStore(std::size_t capacity)
+    : m_capacity(capacity > 0 ? capacity : 1),
+      m_fd(-1),
+      m_map(nullptr),
+      m_mapSize(0),
+      m_header(nullptr),
+      m_records(nullptr),
+      m_unsynced(0)
+{
+    // Records start right after the header
+    static_assert(sizeof(Header) % alignof(SeriesRecord) == 0, "records must stay aligned");
+}
+
+SeriesStore::~SeriesStore() {
+    close();
+}
+
+bool SeriesStore::open(const std::string& path) {
+    close();
+
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        return false;
+    }
+
+    // One writer per file: a second process (another GUI, or the agent)
+    // would interleave its records into the same ring. Held until close().
+    if (flock(m_fd, LOCK_EX | LOCK_NB) != 0) {
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+
+    std::size_t expected = sizeof(Header) + m_capacity * sizeof(SeriesRecord);
+    struct stat st;
+    if (fstat(m_fd, &st) != 0) {
+        close();
+        return false;
+    }
+
+    // A new or foreign file is truncated and sized; the gap stays sparse
+    // until records are written
+    bool fresh = static_cast<std::size_t>(st.st_size) != expected;
+    if (fresh && (ftruncate(m_fd, 0) != 0 || ftruncate(m_fd, static_cast<off_t>(expected)) != 0)) {
+        close();
+        return false;
+    }
+
+    m_map = mmap(nullptr, expected, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (m_map == MAP_FAILED) {
+        m_map = nullptr;
+        close();
+        return false;
+    }
+    m_mapSize = expected;
+    m_header = static_cast<Header*>(m_map);
+    m_records = reinterpret_cast<SeriesRecord*>(static_cast<char*>(m_map) + sizeof(Header));
+
+    if (fresh || !headerValid()) {
+        std::memset(m_map, 0, sizeof(Header));
+        std::memcpy(m_header->magic, kSeriesMagic, sizeof(kSeriesMagic));
+        m_header->version = kSeriesVersion;
+        m_header->recordSize = sizeof(SeriesRecord);
+        m_header->capacity = m_capacity;
+        m_header->count = 0;
+    }
+
+    m_unsynced = 0;
+    return true;
+}
+
+void SeriesStore::close() {
+    if (m_map) {
+        msync(m_map, m_mapSize, MS_SYNC);
+        munmap(m_map, m_mapSize);
+        m_map = nullptr;
+        m_mapSize = 0;
+        m_header = nullptr;
+        m_records = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool SeriesStore::isOpen() const {
+    return m_map != nullptr;
+}
+
+void SeriesStore::append(std::int64_t timestamp, double value) {
+    if (!m_map) {
+        return;
+    }
+
+    // Write the record before publishing it through the count
+    SeriesRecord& record = m_records[m_header->count % m_capacity];
+    record.timestamp = timestamp;
+    record.value = value;
+    m_header->count++;
+
+    if (++m_unsynced >= kSyncInterval) {
+        sync();
+    }
+}
+
+std::size_t SeriesStore::size() const {
+    if (!m_map) {
+        return 0;
+    }
+    return m_header->count < m_capacity ? static_cast<std::size_t>(m_header->count) : m_capacity;
+}
+
+std::size_t SeriesStore::getCapacity() const {
+    return m_capacity;
+}
+
+const SeriesRecord& SeriesStore::at(std::size_t index) const {
+    std::uint64_t oldest = m_header->count - size();
+    return m_records[(oldest + index) % m_capacity];
+}
+
+void SeriesStore::sync() {
+    if (m_map) {
+        msync(m_map, m_mapSize, MS_ASYNC);
+    }
+    m_unsynced = 0;
+}
+
+bool SeriesStore::headerValid() const {
+    return std::memcmp(m_header->magic, kSeriesMagic, sizeof(kSeriesMagic)) == 0 &&
+           m_header->version == kSeriesVersion &&
+           m_header->recordSize == sizeof(SeriesRecord) &&
+           m_header->capacity == m_capacity;
+}
@@ -0,0 +1,75 @@
+#ifndef SERIES_STORE_H
+#define SERIES_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// One persisted sample: wall-clock time in milliseconds since the epoch
+struct SeriesRecord {
+    std::int64_t timestamp;
+    double value;
+};
+
+// Memory-mapped on-disk store for one time series.
+//
+// The file is a small header followed by a fixed number of fixed-size
+// records used as a ring: appends go to slot count % capacity and the oldest
+// records are overwritten once the file is full, so its size never changes.
+// An append is two stores into the mapping; dirty pages are handed to the
+// kernel with msync(MS_ASYNC) every kSyncInterval appends and flushed for
+// good on close(). Opening an existing file just maps it, and the records
+// are read in place.
+//
+// Single writer, enforced with an exclusive flock() on the file. A file
+// with a different layout or capacity is reset.
+class SeriesStore {
+public:
+    explicit SeriesStore(std::size_t capacity);
+    ~SeriesStore();
+
+    SeriesStore(const SeriesStore&) = delete;
+    SeriesStore& operator=(const SeriesStore&) = delete;
+
+    // Map the file, creating it if needed. Returns false on error, with
+    // errno EWOULDBLOCK if another process has the file open.
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    // Append a sample
+    void append(std::int64_t timestamp, double value);
+
+    // Number of records held, at most the capacity
+    std::size_t size() const;
+    std::size_t getCapacity() const;
+
+    // Record by age, 0 is the oldest
+    const SeriesRecord& at(std::size_t index) const;
+
+    // Schedule writeback of dirty pages
+    void sync();
+
+private:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t recordSize;
+        std::uint64_t capacity;
+        std::uint64_t count;            // Records appended since the file was created
+    };
+
+    static constexpr std::size_t kSyncInterval = 60;
+
+    std::size_t m_capacity;
+    int m_fd;
+    void* m_map;
+    std::size_t m_mapSize;
+    Header* m_header;
+    SeriesRecord* m_records;
+    std::size_t m_unsynced;             // Appends since the last sync()
+
+    bool headerValid() const;
+};
+
+#endif // SERIES_STORE_H
@@ -10,7 +10,12 @@ Settings::Settings()
       m_memoryThreshold(85.0),       // Default: 85% (было 80%)
       m_diskThreshold(90.0),         // Default: 90%
       m_updateInterval(1000),        // Default: 1 second
-      m_notificationCooldown(300)    // Default: 300 seconds (5 минут, было 60 секунд)
+      m_sampleInterval(1000),        // Default: 1 second
+      m_diskPollInterval(10),        // Default: 10 seconds
+      m_notificationCooldown(300),   // Default: 300 seconds (5 минут, было 60 секунд)
+      m_pressureThreshold(10),       // Default: 10% of the window
+      m_networkExclude("lo,veth,docker,br-,virbr,vnet,cali,flannel,cni"),  // Default: loopback and container interfaces
+      m_metricsAddress("")           // Default: exporter disabled
 {
     // Set config path to ~/.config/system-monitor/settings.conf
     const char* homeDir = getenv("HOME");
@@ -47,7 +52,12 @@ bool Settings::save() {
         file << "memory_threshold=" << m_memoryThreshold << std::endl;
         file << "disk_threshold=" << m_diskThreshold << std::endl;
         file << "update_interval=" << m_updateInterval << std::endl;
+        file << "sample_interval=" << m_sampleInterval << std::endl;
+        file << "disk_poll_interval=" << m_diskPollInterval << std::endl;
         file << "notification_cooldown=" << m_notificationCooldown << std::endl;
+        file << "pressure_threshold=" << m_pressureThreshold << std::endl;
+        file << "network_exclude=" << m_networkExclude << std::endl;
+        file << "metrics_address=" << m_metricsAddress << std::endl;
         
         file.close();
         return true;
@@ -80,8 +90,18 @@ bool Settings::load() {
                     m_diskThreshold = std::stod(value);
                 } else if (key == "update_interval") {
                     m_updateInterval = std::stoi(value);
+                } else if (key == "sample_interval") {
+                    m_sampleInterval = std::stoi(value);
+                } else if (key == "disk_poll_interval") {
+                    m_diskPollInterval = std::stoi(value);
                 } else if (key == "notification_cooldown") {
                     m_notificationCooldown = std::stoi(value);
+                } else if (key == "pressure_threshold") {
+                    m_pressureThreshold = std::stoi(value);
+                } else if (key == "network_exclude") {
+                    m_networkExclude = value;
+                } else if (key == "metrics_address") {
+                    m_metricsAddress = value;
                 }
             }
         }
@@ -110,10 +130,35 @@ int Settings::getUpdateInterval() const {
     return m_updateInterval;
 }
 
+int Settings::getSampleInterval() const {
+    return m_sampleInterval;
+}
+
+int Settings::getDiskPollInterval() const {
+    return m_diskPollInterval;
+}
+
 int Settings::getNotificationCooldown() const {
     return m_notificationCooldown;
 }
 
+int Settings::getPressureThreshold() const {
+    return m_pressureThreshold;
+}
+
+const std::string& Settings::getNetworkExclude() const {
+    return m_networkExclude;
+}
+
+const std::string& Settings::getMetricsAddress() const {
+    return m_metricsAddress;
+}
+
+std::string Settings::getAlertRulesPath() const {
+    std::filesystem::path directory = std::filesystem::path(m_configPath).parent_path();
+    return (directory / "alerts.conf").string();
+}
+
 void Settings::setCPUThreshold(double threshold) {
     m_cpuThreshold = threshold;
     notifyChange();
@@ -134,11 +179,36 @@ void Settings::setUpdateInterval(int interval) {
     notifyChange();
 }
 
+void Settings::setSampleInterval(int interval) {
+    m_sampleInterval = interval;
+    notifyChange();
+}
+
+void Settings::setDiskPollInterval(int interval) {
+    m_diskPollInterval = interval;
+    notifyChange();
+}
+
 void Settings::setNotificationCooldown(int cooldown) {
     m_notificationCooldown = cooldown;
     notifyChange();
 }
 
+void Settings::setPressureThreshold(int threshold) {
+    m_pressureThreshold = threshold;
+    notifyChange();
+}
+
+void Settings::setNetworkExclude(const std::string& prefixes) {
+    m_networkExclude = prefixes;
+    notifyChange();
+}
+
+void Settings::setMetricsAddress(const std::string& address) {
+    m_metricsAddress = address;
+    notifyChange();
+}
+
 void Settings::registerChangeCallback(std::function<void()> callback) {
     m_changeCallbacks.push_back(callback);
 }
@@ -22,14 +22,27 @@ public:
     double getMemoryThreshold() const;
     double getDiskThreshold() const;
     int getUpdateInterval() const;
+    int getSampleInterval() const;
+    int getDiskPollInterval() const;
     int getNotificationCooldown() const;
+    int getPressureThreshold() const;
+    const std::string& getNetworkExclude() const;
+    const std::string& getMetricsAddress() const;
+    
+    // Alert rules file next to the settings file, see alert_engine.h
+    std::string getAlertRulesPath() const;
     
     // Setters
     void setCPUThreshold(double threshold);
     void setMemoryThreshold(double threshold);
     void setDiskThreshold(double threshold);
     void setUpdateInterval(int interval);
+    void setSampleInterval(int interval);
+    void setDiskPollInterval(int interval);
     void setNotificationCooldown(int cooldown);
+    void setPressureThreshold(int threshold);
+    void setNetworkExclude(const std::string& prefixes);
+    void setMetricsAddress(const std::string& address);
     
     // Register callback for settings changes
     void registerChangeCallback(std::function<void()> callback);
@@ -38,8 +51,13 @@ private:
     double m_cpuThreshold;      // Percentage threshold for CPU usage
     double m_memoryThreshold;   // Percentage threshold for memory usage
     double m_diskThreshold;     // Percentage threshold for disk usage
-    int m_updateInterval;       // Update interval in milliseconds
+    int m_updateInterval;       // UI refresh interval in milliseconds
+    int m_sampleInterval;       // Sampling thread interval in milliseconds
+    int m_diskPollInterval;     // Disk capacity polling interval in seconds
     int m_notificationCooldown; // Cooldown between notifications in seconds
+    int m_pressureThreshold;    // PSI trigger: percent of a 2 s window with stalled tasks
+    std::string m_networkExclude; // Comma separated interface name prefixes not monitored
+    std::string m_metricsAddress; // Prometheus exporter: loopback port or Unix socket path, empty when off
     
     std::string m_configPath;
     std::vector<std::function<void()>> m_changeCallbacks;
@@ -0,0 +1,558 @@
+#include "trace.h"
+#include "monitor_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+static const char kMagic[8] = {'S', 'Y', 'S', 'M', 'O', 'N', 'T', 'R'};
+static const int kVersion = 1;
+
+enum ChangeOp {
+    kRemoved = 0,
+    kFull = 1,
+    kPatch = 2
+};
+
+// Files read by the collectors at fixed paths
+static const char* const kInputFiles[] = {
+    "proc/stat",
+    "proc/meminfo",
+    "proc/net/dev",
+    "proc/diskstats",
+    "proc/pressure/cpu",
+    "proc/pressure/memory",
+    "proc/pressure/io",
+    "etc/mtab"
+};
+
+// Control files read by CgroupCollector in every cgroup
+static const char* const kCgroupFiles[] = {"cpu.stat", "memory.current", "io.stat"};
+
+static void putVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+static void putSigned(std::string& out, std::int64_t value) {
+    putVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+static bool getVarint(const char*& p, const char* end, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char byte = static_cast<unsigned char>(*p++);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool getSigned(const char*& p, const char* end, std::int64_t& value) {
+    std::uint64_t raw;
+    if (!getVarint(p, end, raw)) {
+        return false;
+    }
+    value = static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+    return true;
+}
+
+// Whole contents of a file; /proc files report no size, so read until EOF
+static bool readWholeFile(const std::string& path, std::string& out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    out.clear();
+    char chunk[16384];
+    ssize_t n;
+    while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+        out.append(chunk, static_cast<std::size_t>(n));
+    }
+    ::close(fd);
+    return n == 0;
+}
+
+// A path from a trace may only name something below the replay root
+static bool isSafeRelativePath(const std::string& path) {
+    if (path.empty() || path[0] == '/') {
+        return false;
+    }
+    std::size_t start = 0;
+    while (start <= path.size()) {
+        std::size_t slash = path.find('/', start);
+        std::size_t end = slash == std::string::npos ? path.size() : slash;
+        std::string component = path.substr(start, end - start);
+        if (component.empty() || component == "." || component == "..") {
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+TraceRecorder::TraceRecorder()
+    : m_file(nullptr),
+      m_tick(0),
+      m_lastWallMillis(0),
+      m_lastSteadyNs(0),
+      m_changes(0),
+      m_bytesWritten(0)
+{
+    // Nothing is recorded until open()
+}
+
+TraceRecorder::~TraceRecorder() {
+    close();
+}
+
+bool TraceRecorder::open(const std::string& path, const std::string& root) {
+    close();
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        std::cerr << "Failed to create trace " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    m_root = root;
+    m_ids.clear();
+    m_files.clear();
+    m_tick = 0;
+    m_lastWallMillis = 0;
+    m_lastSteadyNs = 0;
+
+    std::fwrite(kMagic, 1, sizeof(kMagic), m_file);
+    std::fputc(kVersion, m_file);
+    m_bytesWritten = sizeof(kMagic) + 1;
+    return std::ferror(m_file) == 0;
+}
+
+void TraceRecorder::close() {
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+bool TraceRecorder::isOpen() const {
+    return m_file != nullptr;
+}
+
+std::uint64_t TraceRecorder::bytesWritten() const {
+    return m_bytesWritten;
+}
+
+bool TraceRecorder::capture(const ResourceSnapshot& snapshot) {
+    if (!m_file) {
+        return false;
+    }
+
+    m_tick++;
+    m_changes = 0;
+    m_changeBuffer.clear();
+    std::int64_t steadyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        MonitorClock::now().time_since_epoch()).count();
+    std::int64_t wallMillis = MonitorClock::wallMillis();
+
+    for (const char* relative : kInputFiles) {
+        captureFile(relative);
+    }
+    captureProcesses();
+    if (access((m_root + "/sys/fs/cgroup/cgroup.controllers").c_str(), F_OK) == 0) {
+        captureFile("sys/fs/cgroup/cgroup.controllers");
+        captureCgroups("sys/fs/cgroup");
+    }
+
+    // What statvfs() and stat() said about each monitored mount
+    std::string capacities;
+    char line[128];
+    for (const DiskInfo& disk : snapshot.diskInfo) {
+        std::snprintf(line, sizeof(line), "%llu %llu %llu %u %u ", disk.total, disk.used, disk.available,
+                      major(disk.deviceNumber), minor(disk.deviceNumber));
+        capacities += line;
+        capacities += disk.mountpoint;
+        capacities += '\n';
+    }
+    captureContent("statvfs", capacities);
+
+    // Files that went away since the previous tick, e.g. exited processes
+    for (std::uint32_t id = 0; id < m_files.size(); id++) {
+        File& file = m_files[id];
+        if (file.present && file.tick != m_tick) {
+            putVarint(m_changeBuffer, id);
+            putVarint(m_changeBuffer, kRemoved);
+            file.present = false;
+            file.content.clear();
+            m_changes++;
+        }
+    }
+
+    m_tickBuffer.clear();
+    putSigned(m_tickBuffer, wallMillis - m_lastWallMillis);
+    putSigned(m_tickBuffer, steadyNs - m_lastSteadyNs);
+    putVarint(m_tickBuffer, m_changes);
+    m_tickBuffer += m_changeBuffer;
+    m_lastWallMillis = wallMillis;
+    m_lastSteadyNs = steadyNs;
+
+    std::string header = "T";
+    putVarint(header, m_tickBuffer.size());
+    std::fwrite(header.data(), 1, header.size(), m_file);
+    std::fwrite(m_tickBuffer.data(), 1, m_tickBuffer.size(), m_file);
+    std::fflush(m_file);
+    m_bytesWritten += header.size() + m_tickBuffer.size();
+    return std::ferror(m_file) == 0;
+}
+
+void TraceRecorder::captureFile(const std::string& relative) {
+    if (readWholeFile(m_root + "/" + relative, m_readBuffer)) {
+        captureContent(relative, m_readBuffer);
+    }
+}
+
+void TraceRecorder::captureContent(const std::string& relative, const std::string& content) {
+    auto it = m_ids.find(relative);
+    bool isNew = it == m_ids.end();
+    std::uint32_t id;
+    if (isNew) {
+        id = static_cast<std::uint32_t>(m_files.size());
+        m_ids.emplace(relative, id);
+        m_files.push_back({relative, std::string(), false, 0});
+    } else {
+        id = it->second;
+    }
+
+    File& file = m_files[id];
+    file.tick = m_tick;
+    if (file.present && file.content == content) {
+        return;
+    }
+
+    putVarint(m_changeBuffer, id);
+    if (isNew) {
+        putVarint(m_changeBuffer, relative.size());
+        m_changeBuffer += relative;
+    }
+
+    if (!file.present) {
+        putVarint(m_changeBuffer, kFull);
+        putVarint(m_changeBuffer, content.size());
+        m_changeBuffer += content;
+    } else {
+        // Only the bytes between the common prefix and suffix
+        const std::string& previous = file.content;
+        std::size_t limit = std::min(previous.size(), content.size());
+        std::size_t prefix = 0;
+        while (prefix < limit && previous[prefix] == content[prefix]) {
+            prefix++;
+        }
+        std::size_t suffix = 0;
+        while (suffix < limit - prefix &&
+               previous[previous.size() - 1 - suffix] == content[content.size() - 1 - suffix]) {
+            suffix++;
+        }
+        putVarint(m_changeBuffer, kPatch);
+        putVarint(m_changeBuffer, prefix);
+        putVarint(m_changeBuffer, suffix);
+        putVarint(m_changeBuffer, content.size() - prefix - suffix);
+        m_changeBuffer.append(content, prefix, content.size() - prefix - suffix);
+    }
+
+    file.content = content;
+    file.present = true;
+    m_changes++;
+}
+
+void TraceRecorder::captureProcesses() {
+    DIR* dir = opendir((m_root + "/proc").c_str());
+    if (!dir) {
+        return;
+    }
+    while (struct dirent* de = readdir(dir)) {
+        if (de->d_name[0] < '1' || de->d_name[0] > '9') {
+            continue;
+        }
+        captureFile(std::string("proc/") + de->d_name + "/stat");
+    }
+    closedir(dir);
+}
+
+void TraceRecorder::captureCgroups(const std::string& relative) {
+    DIR* dir = opendir((m_root + "/" + relative).c_str());
+    if (!dir) {
+        return;
+    }
+    while (struct dirent* de = readdir(dir)) {
+        if (std::strcmp(de->d_name, ".") == 0 || std::strcmp(de->d_name, "..") == 0) {
+            continue;
+        }
+        bool isDirectory = de->d_type == DT_DIR;
+        if (de->d_type == DT_UNKNOWN) {
+            struct stat st;
+            isDirectory = fstatat(dirfd(dir), de->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+        }
+        if (!isDirectory) {
+            continue;
+        }
+
+        std::string child = relative + "/" + de->d_name;
+        for (const char* name : kCgroupFiles) {
+            captureFile(child + "/" + name);
+        }
+        captureCgroups(child);
+    }
+    closedir(dir);
+}
+
+TraceReplayer::TraceReplayer()
+    : m_file(nullptr),
+      m_fileSize(0),
+      m_wallMillis(0),
+      m_steadyNs(0),
+      m_ticks(0),
+      m_finished(false)
+{
+    // The root is created by open()
+}
+
+TraceReplayer::~TraceReplayer() {
+    close();
+}
+
+bool TraceReplayer::open(const std::string& path) {
+    close();
+
+    m_file = std::fopen(path.c_str(), "rb");
+    if (!m_file) {
+        std::cerr << "Failed to open trace " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    char magic[sizeof(kMagic)];
+    if (std::fread(magic, 1, sizeof(magic), m_file) != sizeof(magic) ||
+        std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || std::fgetc(m_file) != kVersion) {
+        std::cerr << path << " is not a system-monitor trace" << std::endl;
+        close();
+        return false;
+    }
+    struct stat st;
+    if (fstat(fileno(m_file), &st) != 0) {
+        std::cerr << "Failed to stat trace " << path << ": " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    m_fileSize = static_cast<std::uint64_t>(st.st_size);
+
+    char pattern[] = "/tmp/sysmon-replay-XXXXXX";
+    if (!mkdtemp(pattern)) {
+        std::cerr << "Failed to create the replay directory: " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    m_root = pattern;
+
+    if (!applyTick()) {
+        std::cerr << path << " holds no samples" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TraceReplayer::close() {
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+    if (!m_root.empty()) {
+        std::error_code error;
+        std::filesystem::remove_all(m_root, error);
+        m_root.clear();
+        MonitorClock::release();
+    }
+    m_paths.clear();
+    m_contents.clear();
+    m_present.clear();
+    m_fileSize = 0;
+    m_wallMillis = 0;
+    m_steadyNs = 0;
+    m_ticks.store(0, std::memory_order_relaxed);
+    m_finished.store(false, std::memory_order_relaxed);
+}
+
+const std::string& TraceReplayer::root() const {
+    return m_root;
+}
+
+bool TraceReplayer::step() {
+    if (!m_file || m_finished.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (!applyTick()) {
+        m_finished.store(true, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+std::size_t TraceReplayer::ticks() const {
+    return m_ticks.load(std::memory_order_relaxed);
+}
+
+bool TraceReplayer::finished() const {
+    return m_finished.load(std::memory_order_acquire);
+}
+
+bool TraceReplayer::applyTick() {
+    int tag = std::fgetc(m_file);
+    if (tag == EOF) {
+        return false;
+    }
+
+    // Tick length, then the whole body at once
+    std::uint64_t length = 0;
+    int shift = 0;
+    int byte = 0;
+    do {
+        byte = std::fgetc(m_file);
+        if (byte == EOF || shift > 56) {
+            break;
+        }
+        length |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    if (tag != 'T' || byte == EOF || (byte & 0x80)) {
+        std::cerr << "Corrupt trace at tick " << ticks() << std::endl;
+        return false;
+    }
+
+    // The length is not trusted further than the file goes: a recording cut
+    // short by a crash, or a corrupt one, ends here
+    long offset = std::ftell(m_file);
+    if (offset < 0 || length > m_fileSize - static_cast<std::uint64_t>(offset)) {
+        std::cerr << "Truncated trace at tick " << ticks() << std::endl;
+        return false;
+    }
+    m_body.resize(length);
+    if (std::fread(&m_body[0], 1, length, m_file) != length) {
+        return false;
+    }
+
+    const char* p = m_body.data();
+    const char* end = p + m_body.size();
+    std::int64_t wallDelta;
+    std::int64_t steadyDelta;
+    std::uint64_t changes;
+    bool ok = getSigned(p, end, wallDelta) && getSigned(p, end, steadyDelta) && getVarint(p, end, changes);
+
+    for (std::uint64_t i = 0; ok && i < changes; i++) {
+        std::uint64_t id;
+        std::uint64_t op;
+        ok = getVarint(p, end, id);
+        if (ok && id == m_paths.size()) {
+            std::uint64_t pathLength;
+            ok = getVarint(p, end, pathLength) && pathLength <= static_cast<std::uint64_t>(end - p);
+            if (ok) {
+                m_paths.emplace_back(p, pathLength);
+                m_contents.emplace_back();
+                m_present.push_back(false);
+                p += pathLength;
+                ok = isSafeRelativePath(m_paths.back());
+            }
+        }
+        ok = ok && id < m_paths.size() && getVarint(p, end, op);
+        if (!ok) {
+            break;
+        }
+
+        std::string& content = m_contents[id];
+        if (op == kRemoved) {
+            removeFile(static_cast<std::uint32_t>(id));
+        } else if (op == kFull) {
+            std::uint64_t size;
+            ok = getVarint(p, end, size) && size <= static_cast<std::uint64_t>(end - p);
+            if (ok) {
+                content.assign(p, size);
+                p += size;
+                ok = writeFile(static_cast<std::uint32_t>(id));
+            }
+        } else if (op == kPatch) {
+            std::uint64_t prefix;
+            std::uint64_t suffix;
+            std::uint64_t size;
+            ok = getVarint(p, end, prefix) && getVarint(p, end, suffix) && getVarint(p, end, size) &&
+                 prefix <= content.size() && suffix <= content.size() - prefix &&
+                 size <= static_cast<std::uint64_t>(end - p);
+            if (ok) {
+                content.replace(prefix, content.size() - prefix - suffix, p, size);
+                p += size;
+                ok = writeFile(static_cast<std::uint32_t>(id));
+            }
+        } else {
+            ok = false;
+        }
+    }
+    if (!ok) {
+        std::cerr << "Corrupt trace at tick " << ticks() << std::endl;
+        return false;
+    }
+
+    m_wallMillis += wallDelta;
+    m_steadyNs += steadyDelta;
+    MonitorClock::pin(m_steadyNs, m_wallMillis);
+    m_ticks.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool TraceReplayer::writeFile(std::uint32_t id) {
+    std::string path = m_root + "/" + m_paths[id];
+    if (!m_present[id]) {
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    }
+
+    // Truncated and rewritten rather than replaced, so fds the collectors
+    // keep open read the new content
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to write " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    const std::string& content = m_contents[id];
+    std::size_t written = 0;
+    while (written < content.size()) {
+        ssize_t n = ::write(fd, content.data() + written, content.size() - written);
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+    m_present[id] = true;
+    return written == content.size();
+}
+
+void TraceReplayer::removeFile(std::uint32_t id) {
+    std::string path = m_root + "/" + m_paths[id];
+    ::unlink(path.c_str());
+    m_present[id] = false;
+    m_contents[id].clear();
+
+    // Drop directories left empty, e.g. proc/<pid> of an exited process
+    for (std::size_t slash = path.rfind('/'); slash > m_root.size(); slash = path.rfind('/')) {
+        path.resize(slash);
+        if (::rmdir(path.c_str()) != 0) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "resource_monitor.h"
+
+// Recording and replay of the collectors' raw inputs.
+//
+// A trace is a sequence of ticks, one per sample. A tick holds the clocks
+// at capture time and every input file that changed since the previous
+// tick, by its path below the root: proc/stat, proc/meminfo, proc/net/dev,
+// proc/diskstats, proc/pressure/*, etc/mtab, proc/<pid>/stat and the
+// control files of each cgroup below sys/fs/cgroup. Mount capacities, which
+// come from statvfs() and not from a file, are recorded as a "statvfs" file
+// that ResourceMonitor reads when given a root.
+//
+// A changed file is stored as the bytes between the prefix and suffix it
+// shares with its previous content, so a process whose CPU counters moved
+// costs a few bytes per tick and an idle one nothing.
+//
+// Format, integers as LEB128 varints, signed ones zigzag encoded:
+//   "SYSMONTR" version
+//   per tick:   'T' length(body) body
+//   body:       wall ms delta, steady ns delta, change count, changes
+//   change:     path id [path length, path when the id is new] op
+//   op:         0 removed | 1 length bytes | 2 prefix suffix length bytes
+class TraceRecorder {
+public:
+    TraceRecorder();
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // Start a new trace file, reading the inputs below `root` ("" for /)
+    bool open(const std::string& path, const std::string& root = std::string());
+    void close();
+    bool isOpen() const;
+
+    // Capture the inputs once. The snapshot supplies the mount capacities
+    // the monitor just polled. Call on the sampling thread after a sample.
+    bool capture(const ResourceSnapshot& snapshot);
+
+    std::uint64_t bytesWritten() const;
+
+private:
+    struct File {
+        std::string path;
+        std::string content;
+        bool present;
+        std::size_t tick;       // Last tick that saw the file
+    };
+
+    FILE* m_file;
+    std::string m_root;
+    std::unordered_map<std::string, std::uint32_t> m_ids;
+    std::vector<File> m_files;  // Indexed by path id
+    std::size_t m_tick;
+    std::int64_t m_lastWallMillis;
+    std::int64_t m_lastSteadyNs;
+    std::uint64_t m_changes;    // In the tick being encoded
+    std::uint64_t m_bytesWritten;
+    std::string m_changeBuffer; // Reused between ticks
+    std::string m_tickBuffer;
+    std::string m_readBuffer;
+
+    // Read a file below the root and record it if it changed
+    void captureFile(const std::string& relative);
+    void captureContent(const std::string& relative, const std::string& content);
+    void captureProcesses();
+    void captureCgroups(const std::string& relative);
+};
+
+// Plays a trace back into a temporary root directory, one tick per step(),
+// for a ResourceMonitor created with root(). Files are rewritten in place,
+// so the collectors' cached fds see the new content. MonitorClock is pinned
+// to the recorded times of the current tick.
+class TraceReplayer {
+public:
+    TraceReplayer();
+    ~TraceReplayer();
+
+    TraceReplayer(const TraceReplayer&) = delete;
+    TraceReplayer& operator=(const TraceReplayer&) = delete;
+
+    // Open a trace and apply its first tick, for ResourceMonitor::initialize()
+    bool open(const std::string& path);
+    void close();
+
+    // The temporary root, removed again by close()
+    const std::string& root() const;
+
+    // Apply the next tick; false once the trace is exhausted
+    bool step();
+
+    // Ticks applied so far, and whether the last one was reached. Safe from
+    // any thread.
+    std::size_t ticks() const;
+    bool finished() const;
+
+private:
+    FILE* m_file;
+    std::uint64_t m_fileSize;               // Bounds the tick lengths read from it
+    std::string m_root;
+    std::vector<std::string> m_paths;       // Indexed by path id
+    std::vector<std::string> m_contents;
+    std::vector<bool> m_present;
+    std::int64_t m_wallMillis;
+    std::int64_t m_steadyNs;
+    std::atomic<std::size_t> m_ticks;
+    std::atomic<bool> m_finished;
+    std::string m_body;                     // Reused between ticks
+
+    bool applyTick();
+    bool writeFile(std::uint32_t id);
+    void removeFile(std::uint32_t id);
+};
+
+#endif // TRACE_H
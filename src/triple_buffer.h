@@ -0,0 +1,61 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer "latest value" channel.
+//
+// The producer fills writeBuffer() and calls publish(); the consumer calls
+// update() and then reads readBuffer(). Three slots rotate between the two
+// sides, so neither ever waits for the other and the consumer always sees the
+// most recent complete value. Slot contents are reused, so a T that owns heap
+// storage (vectors, strings) stops allocating once it has reached its size.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer()
+        : m_writeIndex(0),
+          m_readIndex(1),
+          m_middle(2)
+    {
+    }
+
+    // Producer side: slot to fill before the next publish()
+    T& writeBuffer() {
+        return m_slots[m_writeIndex];
+    }
+
+    // Producer side: hand the filled slot to the consumer
+    void publish() {
+        std::uint8_t previous = m_middle.exchange(m_writeIndex | kDirty, std::memory_order_acq_rel);
+        m_writeIndex = previous & kIndexMask;
+    }
+
+    // Consumer side: pick up the newest published slot. Returns false if
+    // nothing was published since the last call.
+    bool update() {
+        if (!(m_middle.load(std::memory_order_relaxed) & kDirty)) {
+            return false;
+        }
+        std::uint8_t previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & kIndexMask;
+        return true;
+    }
+
+    // Consumer side: the slot picked up by the last successful update()
+    const T& readBuffer() const {
+        return m_slots[m_readIndex];
+    }
+
+private:
+    static constexpr std::uint8_t kDirty = 0x4;
+    static constexpr std::uint8_t kIndexMask = 0x3;
+
+    T m_slots[3];
+    std::uint8_t m_writeIndex;              // Owned by the producer
+    std::uint8_t m_readIndex;               // Owned by the consumer
+    std::atomic<std::uint8_t> m_middle;     // Shared slot index plus the dirty flag
+};
+
+#endif // TRIPLE_BUFFER_H